@@ -46,10 +46,36 @@
 
 #include "gams/algorithms/Base_Algorithm.h"
 #include "gams/utility/Region.h"
+#include "madara/utility/Utility.h"
 
 namespace variables = gams::variables;
 namespace platforms = gams::platforms;
 
+namespace
+{
+  /**
+   * Checks if any variable prefix in one list overlaps a prefix in
+   * another, i.e., one of them begins with the other
+   **/
+  bool overlaps (const std::vector <std::string> & lhs,
+    const std::vector <std::string> & rhs)
+  {
+    for (size_t i = 0; i < lhs.size (); ++i)
+    {
+      for (size_t j = 0; j < rhs.size (); ++j)
+      {
+        if (Madara::Utility::begins_with (lhs[i], rhs[j]) ||
+            Madara::Utility::begins_with (rhs[j], lhs[i]))
+        {
+          return true;
+        }
+      }
+    }
+
+    return false;
+  }
+}
+
 gams::algorithms::Base_Algorithm::Base_Algorithm (
   Madara::Knowledge_Engine::Knowledge_Base * knowledge,
   platforms::Base_Platform * platform,
@@ -57,7 +83,8 @@ gams::algorithms::Base_Algorithm::Base_Algorithm (
   variables::Self * self,
   variables::Devices * devices)
   : devices_ (devices), executions_ (0), knowledge_ (knowledge),
-    platform_ (platform), self_ (self), sensors_ (sensors)
+    platform_ (platform), self_ (self), sensors_ (sensors),
+    clock_ (utility::default_clock ())
 {
 }
 
@@ -75,6 +102,9 @@ gams::algorithms::Base_Algorithm::operator= (const Base_Algorithm & rhs)
     this->sensors_ = rhs.sensors_;
     this->self_ = rhs.self_;
     this->status_ = rhs.status_;
+    this->reads_ = rhs.reads_;
+    this->writes_ = rhs.writes_;
+    this->clock_ = rhs.clock_;
   }
 }
 
@@ -137,3 +167,43 @@ gams::algorithms::Base_Algorithm::get_algorithm_status (void)
 {
   return &status_;
 }
+
+void
+gams::algorithms::Base_Algorithm::set_clock (utility::Clock * clock)
+{
+  clock_ = clock ? clock : utility::default_clock ();
+}
+
+gams::utility::Clock *
+gams::algorithms::Base_Algorithm::get_clock (void)
+{
+  return clock_;
+}
+
+void
+gams::algorithms::Base_Algorithm::declare_reads (const std::string & prefix)
+{
+  reads_.push_back (prefix);
+}
+
+void
+gams::algorithms::Base_Algorithm::declare_writes (const std::string & prefix)
+{
+  writes_.push_back (prefix);
+}
+
+bool
+gams::algorithms::Base_Algorithm::conflicts_with (
+  const Base_Algorithm & other) const
+{
+  // without declarations, nothing is known about the accesses
+  if ((reads_.size () == 0 && writes_.size () == 0) ||
+      (other.reads_.size () == 0 && other.writes_.size () == 0))
+  {
+    return true;
+  }
+
+  return overlaps (writes_, other.reads_) ||
+    overlaps (writes_, other.writes_) ||
+    overlaps (reads_, other.writes_);
+}
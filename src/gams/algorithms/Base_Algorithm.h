@@ -59,6 +59,7 @@
 #include "gams/variables/Algorithm_Status.h"
 #include "gams/variables/Self.h"
 #include "gams/utility/Region.h"
+#include "gams/utility/Clock.h"
 #include "madara/knowledge_engine/Knowledge_Base.h"
 
 #include <vector>
@@ -157,6 +158,12 @@ namespace gams
        * @param  sensors      map of sensor names to sensor information
        **/
       virtual void set_sensors (variables::Sensors * sensors);
+
+      /**
+       * Sets the clock the algorithm should read time from
+       * @param  clock     the clock. 0 uses the real time clock.
+       **/
+      virtual void set_clock (utility::Clock * clock);
       
       /**
        * Gets the list of devices
@@ -188,6 +195,36 @@ namespace gams
        **/
       variables::Algorithm_Status * get_algorithm_status (void);
 
+      /**
+       * Gets the clock of the controller running the algorithm. Use this
+       * instead of the system time so the algorithm also works in
+       * simulated time.
+       **/
+      utility::Clock * get_clock (void);
+
+      /**
+       * Declares a variable, or a prefix of variables, that the algorithm
+       * reads. Used to decide which accents may run concurrently.
+       * @param  prefix   variable name or prefix (e.g. "swarm.")
+       **/
+      void declare_reads (const std::string & prefix);
+
+      /**
+       * Declares a variable, or a prefix of variables, that the algorithm
+       * modifies. Used to decide which accents may run concurrently.
+       * @param  prefix   variable name or prefix (e.g. "swarm.")
+       **/
+      void declare_writes (const std::string & prefix);
+
+      /**
+       * Checks if either algorithm modifies variables that the other
+       * reads or modifies. An algorithm that has declared no reads or
+       * writes conflicts with every other algorithm.
+       * @param  other    the algorithm to compare against
+       * @return true if the algorithms must not run concurrently
+       **/
+      bool conflicts_with (const Base_Algorithm & other) const;
+
     protected:
       /// the list of devices potentially participating in the algorithm
       variables::Devices * devices_;
@@ -209,6 +246,15 @@ namespace gams
 
       /// provides access to status information for this platform
       variables::Algorithm_Status status_;
+
+      /// variable prefixes read by the algorithm
+      std::vector <std::string> reads_;
+
+      /// variable prefixes modified by the algorithm
+      std::vector <std::string> writes_;
+
+      /// the source of time
+      utility::Clock * clock_;
     };
 
     // deprecated typdef. Please use Base_Algorithm instead.
@@ -83,6 +83,12 @@ gams::algorithms::Debug_Algorithm::Debug_Algorithm (
     status_.init_vars (*knowledge, "debug");
     k_executions_.set_name (executions_location, *knowledge);
   }
+
+  // lets the accent pool run this concurrently with other accents
+  declare_reads (".id");
+  declare_writes ("algorithm.debug.");
+  declare_writes (executions_location);
+  declare_writes ("device.");
 }
 
 gams::algorithms::Debug_Algorithm::~Debug_Algorithm ()
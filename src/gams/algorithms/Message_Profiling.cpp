@@ -94,6 +94,10 @@ gams::algorithms::Message_Profiling::Message_Profiling (
 {
   status_.init_vars (*knowledge, "message_profiling");
 
+  // lets the accent pool run this concurrently with other accents
+  declare_reads (".id");
+  declare_writes (key_prefix_ + ".");
+
   // attach filter
   //knowledge->close_transport ();
 
@@ -75,6 +75,9 @@ gams::algorithms::Null_Algorithm::Null_Algorithm (
   : Base_Algorithm (knowledge, platform, sensors, self)
 {
   status_.init_vars (*knowledge, "null");
+
+  // the phases touch nothing, so this never conflicts with other accents
+  declare_reads ("algorithm.null.");
 }
 
 gams::algorithms::Null_Algorithm::~Null_Algorithm ()
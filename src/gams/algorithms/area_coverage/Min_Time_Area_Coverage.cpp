@@ -55,6 +55,13 @@
 
 #include "gams/algorithms/area_coverage/Min_Time_Area_Coverage.h"
 
+#include "ace/Task.h"
+#include "ace/Atomic_Op.h"
+#include "ace/Thread_Mutex.h"
+#include "ace/Condition_Thread_Mutex.h"
+#include "ace/Guard_T.h"
+#include "ace/OS_NS_unistd.h"
+
 #include "gams/utility/GPS_Position.h"
 #include "gams/utility/Position.h"
 
@@ -63,10 +70,234 @@
 #include <string>
 #include <set>
 #include <map>
+#include <vector>
+#include <algorithm>
+#include <float.h>
 
 using std::cerr;
 using std::endl;
 
+namespace
+{
+  /// the number of candidates a planner thread takes at a time
+  const size_t CANDIDATE_CHUNK = 64;
+
+  /// the fewest candidates worth giving a thread of its own
+  const size_t MIN_CANDIDATES_PER_THREAD = 512;
+
+  /// orders candidates by descending utility bound, then by index
+  class Higher_Bound
+  {
+  public:
+    Higher_Bound (const std::vector<double> & bounds)
+      : bounds_ (bounds)
+    {
+    }
+
+    bool operator() (size_t lhs, size_t rhs) const
+    {
+      if (bounds_[lhs] != bounds_[rhs])
+        return bounds_[lhs] > bounds_[rhs];
+      return lhs < rhs;
+    }
+
+  private:
+    const std::vector<double> & bounds_;
+  };
+}
+
+/**
+ * Scores candidates in order of their bounds on one or more threads. Each
+ * thread takes chunks of the order and stops at the first candidate whose
+ * bound is below the best utility any thread has shared. A skipped
+ * candidate could not have won, so the result does not depend on the
+ * scheduling of the threads.
+ **/
+class gams::algorithms::area_coverage::Min_Time_Area_Coverage::Candidate_Task
+{
+public:
+  Candidate_Task (const Min_Time_Area_Coverage & planner,
+    const utility::Position & start, double radius,
+    const std::vector<size_t> & order)
+    : best_utility (-DBL_MAX), best_index (order.size ()),
+    planner_ (planner), start_ (start), radius_ (radius), order_ (order),
+    next_ (0)
+  {
+  }
+
+  /**
+   * Scores chunks of candidates until none are left or none can win. May
+   * be called on several threads at once.
+   **/
+  int score (void)
+  {
+    const Candidate_Buffer & candidates = planner_.candidates_;
+    std::vector<maps::Column_Span> spans;
+    double local_utility = -DBL_MAX;
+    size_t local_index = order_.size ();
+
+    for (size_t begin = (next_ += CANDIDATE_CHUNK) - CANDIDATE_CHUNK;
+      begin < order_.size ();
+      begin = (next_ += CANDIDATE_CHUNK) - CANDIDATE_CHUNK)
+    {
+      double shared;
+      {
+        ACE_GUARD_RETURN (ACE_Thread_Mutex, guard, mutex_, -1);
+        shared = std::max (best_utility, local_utility);
+      }
+
+      bool done = false;
+      const size_t end = std::min (begin + CANDIDATE_CHUNK, order_.size ());
+      for (size_t i = begin; i < end && !done; ++i)
+      {
+        const size_t index = order_[i];
+        if (candidates.bounds[index] < shared)
+        {
+          done = true;
+          break;
+        }
+
+        const double utility = planner_.score_path (start_,
+          utility::Position (candidates.x[index], candidates.y[index]),
+          radius_, spans) * candidates.weights[index];
+        if (utility > local_utility ||
+          (utility == local_utility && index < local_index))
+        {
+          local_utility = utility;
+          local_index = index;
+          shared = std::max (shared, utility);
+        }
+      }
+
+      {
+        ACE_GUARD_RETURN (ACE_Thread_Mutex, guard, mutex_, -1);
+        if (local_utility > best_utility ||
+          (local_utility == best_utility && local_index < best_index))
+        {
+          best_utility = local_utility;
+          best_index = local_index;
+        }
+      }
+
+      if (done)
+        break;
+    }
+
+    return 0;
+  }
+
+  /// the highest utility found
+  double best_utility;
+
+  /// the candidate with the highest utility, or the candidate count if none
+  size_t best_index;
+
+private:
+  const Min_Time_Area_Coverage & planner_;
+  const utility::Position start_;
+  const double radius_;
+  const std::vector<size_t> & order_;
+  ACE_Atomic_Op<ACE_Thread_Mutex, size_t> next_;
+  ACE_Thread_Mutex mutex_;
+};
+
+/**
+ * Threads that help the planner thread score the candidates of a replan.
+ * The threads are started once and wait between replans, rather than being
+ * started and joined on every replan.
+ **/
+class gams::algorithms::area_coverage::Min_Time_Area_Coverage::Candidate_Pool
+  : public ACE_Task_Base
+{
+public:
+  Candidate_Pool (size_t num_threads)
+    : work_available_ (mutex_), work_done_ (mutex_), task_ (0),
+    tickets_ (0), active_ (0), terminated_ (false)
+  {
+    activate (THR_NEW_LWP | THR_JOINABLE, (int)num_threads);
+  }
+
+  virtual ~Candidate_Pool ()
+  {
+    {
+      ACE_GUARD (ACE_Thread_Mutex, guard, mutex_);
+
+      terminated_ = true;
+      work_available_.broadcast ();
+    }
+
+    wait ();
+  }
+
+  /**
+   * Scores a task on the calling thread and up to a number of helpers,
+   * and returns once all of them are done
+   **/
+  void run (Candidate_Task & task, size_t helpers)
+  {
+    {
+      ACE_GUARD (ACE_Thread_Mutex, guard, mutex_);
+
+      task_ = &task;
+      tickets_ = helpers;
+      work_available_.broadcast ();
+    }
+
+    task.score ();
+
+    ACE_GUARD (ACE_Thread_Mutex, guard, mutex_);
+
+    // helpers that have not woken up yet would find no work left
+    tickets_ = 0;
+    while (active_ > 0)
+      work_done_.wait ();
+
+    task_ = 0;
+  }
+
+  virtual int svc (void)
+  {
+    for (;;)
+    {
+      Candidate_Task * task;
+
+      {
+        ACE_GUARD_RETURN (ACE_Thread_Mutex, guard, mutex_, -1);
+
+        while (!terminated_ && tickets_ == 0)
+          work_available_.wait ();
+
+        if (terminated_)
+          break;
+
+        --tickets_;
+        ++active_;
+        task = task_;
+      }
+
+      task->score ();
+
+      {
+        ACE_GUARD_RETURN (ACE_Thread_Mutex, guard, mutex_, -1);
+
+        if (--active_ == 0)
+          work_done_.broadcast ();
+      }
+    }
+
+    return 0;
+  }
+
+private:
+  ACE_Thread_Mutex mutex_;
+  ACE_Condition_Thread_Mutex work_available_;
+  ACE_Condition_Thread_Mutex work_done_;
+  Candidate_Task * task_;
+  size_t tickets_;
+  size_t active_;
+  bool terminated_;
+};
+
 gams::algorithms::Base_Algorithm *
 gams::algorithms::area_coverage::Min_Time_Area_Coverage_Factory::create (
   const Madara::Knowledge_Vector & args,
@@ -97,7 +328,9 @@ gams::algorithms::area_coverage::Min_Time_Area_Coverage::
   Base_Area_Coverage (knowledge, platform, sensors, self),
   search_area_ (
     utility::parse_search_area (*knowledge, search_id.to_string ())),
-  min_time_ (search_id.to_string () + ".min_time", knowledge)
+  min_time_ (search_id.to_string () + ".min_time", knowledge),
+  last_seen_ (-1), cells_min_x_ (0), cells_min_y_ (0), cells_width_ (0),
+  cells_height_ (0), pool_ (0)
 {
   // init status vars
   status_.init_vars (*knowledge, algo_name);
@@ -116,26 +349,65 @@ gams::algorithms::area_coverage::Min_Time_Area_Coverage::
   min_time_.set_origin (origin);
   min_time_.set_range (2.5); // balance this between resolution and performance
 
+  // index conversions happen for many cells every tick, so use a snapshot
+  min_time_.set_frame_caching ();
+
+  // observations go out in batches, and analyze learns which cells other
+  // agents observed from the batches instead of checking every cell
+  min_time_.set_change_sync ();
+
   // perform setup
   /**
-   * In this algorithm, individual agents will increment their local copies of
-   * the sensor map to limit the amount of communication required.
+   * In this algorithm, individual agents age cells by comparing the current
+   * tick to the tick each cell was last seen, so the sensor map is only
+   * written, and communicated, when a cell is observed. Cells that have never
+   * been written start one tick old.
    */
   valid_positions_ = min_time_.discretize (search_area_);
-  static const Madara::Knowledge_Engine::Knowledge_Update_Settings
-    NO_BROADCAST (true, false);
-  knowledge_->lock ();
-  for (std::set<utility::Position>::iterator it = valid_positions_.begin ();
-    it != valid_positions_.end (); ++it)
+  min_time_.use_dense_storage (valid_positions_);
+
+  // lay the valid positions out in arrays over their bounding box, so that
+  // paths can be scored without searching valid_positions_
+  if (!valid_positions_.empty ())
   {
-    min_time_.set_value (*it, min_time_.get_value (*it) + 1, NO_BROADCAST);
+    int max_x = (int)valid_positions_.begin ()->x;
+    int max_y = (int)valid_positions_.begin ()->y;
+    cells_min_x_ = max_x;
+    cells_min_y_ = max_y;
+    for (std::set<utility::Position>::iterator it = valid_positions_.begin ();
+      it != valid_positions_.end (); ++it)
+    {
+      cells_min_x_ = std::min (cells_min_x_, (int)it->x);
+      cells_min_y_ = std::min (cells_min_y_, (int)it->y);
+      max_x = std::max (max_x, (int)it->x);
+      max_y = std::max (max_y, (int)it->y);
+    }
+
+    cells_width_ = max_x - cells_min_x_ + 1;
+    cells_height_ = max_y - cells_min_y_ + 1;
+    cell_valid_.assign ((size_t)cells_width_ * cells_height_, 0);
+    cell_utilities_.assign (cell_valid_.size (), 0.0);
+    utility_sums_.assign ((size_t)(cells_width_ + 1) * (cells_height_ + 1), 0.0);
+    column_sums_.assign ((size_t)cells_width_ * (cells_height_ + 1), 0.0);
+
+    for (std::set<utility::Position>::iterator it = valid_positions_.begin ();
+      it != valid_positions_.end (); ++it)
+    {
+      cell_valid_[(size_t)((int)it->y - cells_min_y_) * cells_width_ +
+        ((int)it->x - cells_min_x_)] = 1;
+    }
   }
-  knowledge_->unlock ();
 
   // find first position to go to
   generate_new_position ();
 }
 
+gams::algorithms::area_coverage::Min_Time_Area_Coverage::
+  ~Min_Time_Area_Coverage ()
+{
+  delete pool_;
+}
+
 void
 gams::algorithms::area_coverage::Min_Time_Area_Coverage::operator= (
   const Min_Time_Area_Coverage & rhs)
@@ -144,7 +416,18 @@ gams::algorithms::area_coverage::Min_Time_Area_Coverage::operator= (
   {
     this->search_area_ = rhs.search_area_;
     this->min_time_ = rhs.min_time_;
+    this->last_seen_ = rhs.last_seen_;
+    this->record_clocks_ = rhs.record_clocks_;
     this->valid_positions_ = rhs.valid_positions_;
+    this->cells_min_x_ = rhs.cells_min_x_;
+    this->cells_min_y_ = rhs.cells_min_y_;
+    this->cells_width_ = rhs.cells_width_;
+    this->cells_height_ = rhs.cells_height_;
+    this->cell_valid_ = rhs.cell_valid_;
+    this->cell_utilities_ = rhs.cell_utilities_;
+    this->utility_sums_ = rhs.utility_sums_;
+    this->column_sums_ = rhs.column_sums_;
+    this->candidates_ = rhs.candidates_;
     this->Base_Area_Coverage::operator= (rhs);
   }
 }
@@ -152,20 +435,20 @@ gams::algorithms::area_coverage::Min_Time_Area_Coverage::operator= (
 int
 gams::algorithms::area_coverage::Min_Time_Area_Coverage::analyze ()
 {
+  // every cell ages by one tick, since ages are relative to executions_
   ++executions_;
 
-  // increment time since last seen for all cells
-  /**
-   * As with the initial setup, we don't broadcast our sensor map updates to
-   * limit the communications.
-   */
-  static const Madara::Knowledge_Engine::Knowledge_Update_Settings
-    NO_BROADCAST (true, false);
+  // pick up a changed origin or range, and the changes of other agents
+  std::vector<utility::Position> changed;
   knowledge_->lock ();
-  for (std::set<utility::Position>::iterator it = valid_positions_.begin ();
-    it != valid_positions_.end (); ++it)
+  min_time_.refresh_frame ();
+  min_time_.receive_changes (&changed);
+  for (size_t i = 0; i < changed.size (); ++i)
   {
-    min_time_.set_value (*it, min_time_.get_value (*it) + 1, NO_BROADCAST);
+    const Madara::Knowledge_Record record = min_time_.get_record (changed[i]);
+    last_seen_.set ((int)changed[i].x, (int)changed[i].y,
+      (Madara::Knowledge_Record::Integer)executions_ - record.to_integer ());
+    record_clocks_.set ((int)changed[i].x, (int)changed[i].y, record.clock);
   }
   knowledge_->unlock ();
 
@@ -178,8 +461,12 @@ gams::algorithms::area_coverage::Min_Time_Area_Coverage::analyze ()
    * could be changed to 1 on other agents before it is actually considered for
    * utility calculations. This is inconsequential.
    */
-  min_time_.set_value (current, 0);
-  position_value_map_.erase (min_time_.get_index_from_gps (current));
+  const utility::Position current_index = min_time_.get_index_from_gps (current);
+  set_age (current_index, 0);
+  position_value_map_.erase (current_index);
+
+  // with change sync, the cells cleared since the last tick go out together
+  min_time_.send_changes ();
   
   return 0;
 }
@@ -192,62 +479,125 @@ gams::algorithms::area_coverage::Min_Time_Area_Coverage::
   review_last_move ();
   last_generation_ = executions_;
 
-  // check each possible destination for max utility
-  double max_util = -DBL_MAX;
-  std::set<utility::Position> online;
   utility::GPS_Position current;
   current.from_container (self_->device.location);
   next_position_ = current;
   utility::Position cur_index = min_time_.get_index_from_gps (current);
+
+  /**
+   * Each cell is scored once, and each destination gets an upper bound from
+   * the scores in the bounding box of its path. Destinations are tried from
+   * the highest bound down, and the search stops once no remaining bound can
+   * beat the best utility found. Ties go to the lowest position, which is
+   * the destination the exhaustive search over valid_positions_ would pick.
+   */
+  update_cell_utilities ();
+
+  const size_t count = valid_positions_.size ();
+  if (count == 0)
+    return;
+
+  const double radius =
+    min_time_.get_range () / min_time_.get_discretization ();
+
+  candidates_.resize (count);
+  size_t index = 0;
   for (std::set<utility::Position>::const_iterator it = valid_positions_.begin ();
-    it != valid_positions_.end (); ++it)
+    it != valid_positions_.end (); ++it, ++index)
   {
-    std::set<utility::Position> cur_online;
-    double util = get_utility (cur_index, *it, cur_online);
-    if (util > max_util)
-    {
-      max_util = util;
-      next_position_ = min_time_.get_gps_from_index (*it);
-      next_position_.altitude (self_->device.desired_altitude.to_double ());
-      online.swap (cur_online);
-    }
+    candidates_.x[index] = (int)it->x;
+    candidates_.y[index] = (int)it->y;
+  }
+
+  const Summed_Area_Table table = { &utility_sums_[0],
+    cells_min_x_, cells_min_y_, cells_width_, cells_height_ };
+  get_distance_weights (cur_index,
+    &candidates_.x[0], &candidates_.y[0], count, &candidates_.weights[0]);
+  get_box_sums (table, cur_index, radius,
+    &candidates_.x[0], &candidates_.y[0], count, &candidates_.bounds[0]);
+
+  // allow for rounding in the table, so the bound never prunes the best
+  const double slack = utility_sums_.back () * 1e-9;
+  for (size_t i = 0; i < count; ++i)
+    candidates_.bounds[i] = (candidates_.bounds[i] + slack) *
+      candidates_.weights[i];
+
+  std::vector<size_t> order (count);
+  for (size_t i = 0; i < count; ++i)
+    order[i] = i;
+  std::sort (order.begin (), order.end (), Higher_Bound (candidates_.bounds));
+
+  Candidate_Task task (*this, cur_index, radius, order);
+
+  const size_t processors = (size_t)ACE_OS::num_processors_online ();
+  const size_t threads = std::min (processors,
+    count / MIN_CANDIDATES_PER_THREAD);
+
+  if (threads > 1)
+  {
+    // the planner thread is one of the threads
+    if (pool_ == 0)
+      pool_ = new Candidate_Pool (processors - 1);
+
+    pool_->run (task, threads - 1);
+  }
+  else
+  {
+    task.score ();
   }
 
+  if (task.best_index == count)
+    return;
+
+  const utility::Position best (candidates_.x[task.best_index],
+    candidates_.y[task.best_index]);
+
+  next_position_ = min_time_.get_gps_from_index (best);
+  next_position_.altitude (self_->device.desired_altitude.to_double ());
+
   /**
    * Here we 0 out the cells along the line from our current cell to our
    * destination cell. Importantly, we also store the values that we are 
    * clearing. Once the move is complete, we will check if we actually hit the 
    * cells and update them if we did not.
    */
-  for (std::set<utility::Position>::iterator it = online.begin ();
+  std::vector<utility::Position> online;
+  get_utility (cur_index, best, &online);
+  for (std::vector<utility::Position>::iterator it = online.begin ();
     it != online.end (); ++it)
   {
-    position_value_map_[*it] = min_time_.get_value (*it);
-    min_time_.set_value (*it, 0.0);
+    position_value_map_[*it] = get_age (*it);
+    set_age (*it, 0.0);
   }
 }
 
+double
+gams::algorithms::area_coverage::Min_Time_Area_Coverage::get_cell_utility (
+  const utility::Position& pos)
+{
+  return pow (get_age (pos), 3.0);
+}
+
 double
 gams::algorithms::area_coverage::Min_Time_Area_Coverage::get_utility (
   const utility::Position& start, const utility::Position& end,
-  std::set<utility::Position>& online)
+  std::vector<utility::Position> * online)
 {
-  /**
-   * check each valid position and add its value to utility if it is along
-   * the possible travel path of the agent
-   */
-  double util = 0.0;
   const double radius =
     min_time_.get_range () / min_time_.get_discretization ();
-  for (std::set<utility::Position>::const_iterator it = valid_positions_.begin ();
-    it != valid_positions_.end (); ++it)
+  double util = score_path (start, end, radius, spans_);
+
+  if (online)
   {
-    if (start.distance_to_2d (end, *it) < radius)
+    for (std::vector<maps::Column_Span>::const_iterator it = spans_.begin ();
+      it != spans_.end (); ++it)
     {
-      double time = min_time_.get_value (*it);
-      double delta_util = pow (time, 3.0);
-      util += delta_util;
-      online.insert (*it);
+      for (int y = it->min_y; y <= it->max_y; ++y)
+      {
+        size_t index;
+        if (get_cell_index (utility::Position (it->x, y), index))
+          online->push_back (utility::Position (it->x, y));
+      }
     }
   }
   
@@ -255,6 +605,91 @@ gams::algorithms::area_coverage::Min_Time_Area_Coverage::get_utility (
   return util / sqrt(start.distance_to_2d (end) + 1);
 }
 
+double
+gams::algorithms::area_coverage::Min_Time_Area_Coverage::score_path (
+  const utility::Position& start, const utility::Position& end,
+  double radius, std::vector<maps::Column_Span>& spans) const
+{
+  /**
+   * add the utility of each valid position along the possible travel path of
+   * the agent. The sensor corridor around the path is one run of cells per
+   * column, so each column costs one difference of its prefix sums.
+   */
+  double util = 0.0;
+
+  spans.clear ();
+  maps::Grid::get_corridor_spans (start, end, radius, spans);
+  for (std::vector<maps::Column_Span>::const_iterator it = spans.begin ();
+    it != spans.end (); ++it)
+  {
+    const int x = it->x - cells_min_x_;
+    const int min_y = std::max (it->min_y - cells_min_y_, 0);
+    const int max_y = std::min (it->max_y - cells_min_y_, cells_height_ - 1);
+    if (x < 0 || x >= cells_width_ || min_y > max_y)
+      continue;
+
+    const double * column = &column_sums_[(size_t)x * (cells_height_ + 1)];
+    util += column[max_y + 1] - column[min_y];
+  }
+
+  return util;
+}
+
+void
+gams::algorithms::area_coverage::Min_Time_Area_Coverage::
+  update_cell_utilities ()
+{
+  for (std::set<utility::Position>::const_iterator it = valid_positions_.begin ();
+    it != valid_positions_.end (); ++it)
+  {
+    size_t index;
+    get_cell_index (*it, index);
+    cell_utilities_[index] = get_cell_utility (*it);
+  }
+
+  // sum along the columns
+  for (int x = 0; x < cells_width_; ++x)
+  {
+    double * column = &column_sums_[(size_t)x * (cells_height_ + 1)];
+    for (int y = 0; y < cells_height_; ++y)
+    {
+      const size_t index = (size_t)y * cells_width_ + x;
+      column[y + 1] = column[y] +
+        (cell_valid_[index] ? cell_utilities_[index] : 0.0);
+    }
+  }
+
+  // build the summed area table over the positive utilities
+  const size_t stride = cells_width_ + 1;
+  for (int y = 0; y < cells_height_; ++y)
+  {
+    double row = 0.0;
+    for (int x = 0; x < cells_width_; ++x)
+    {
+      const size_t index = (size_t)y * cells_width_ + x;
+      if (cell_valid_[index] && cell_utilities_[index] > 0)
+        row += cell_utilities_[index];
+      utility_sums_[(y + 1) * stride + x + 1] =
+        utility_sums_[y * stride + x + 1] + row;
+    }
+  }
+}
+
+bool
+gams::algorithms::area_coverage::Min_Time_Area_Coverage::get_cell_index (
+  const utility::Position& pos, size_t& index) const
+{
+  const int x = (int)pos.x - cells_min_x_;
+  const int y = (int)pos.y - cells_min_y_;
+
+  if (x < 0 || y < 0 || x >= cells_width_ || y >= cells_height_)
+    return false;
+
+  index = (size_t)y * cells_width_ + x;
+
+  return cell_valid_[index] != 0;
+}
+
 void
 gams::algorithms::area_coverage::Min_Time_Area_Coverage::review_last_move ()
 {
@@ -269,10 +704,49 @@ gams::algorithms::area_coverage::Min_Time_Area_Coverage::review_last_move ()
     position_value_map_.begin (); it != position_value_map_.end ();
     ++it)
   {
-    if (min_time_.get_value (it->first) == expected)
-      min_time_.set_value (it->first,
-        min_time_.get_value (it->first) + it->second);
+    if (get_age (it->first) == expected)
+      set_age (it->first, expected + it->second);
   }
 
   position_value_map_.clear ();
 }
+
+double
+gams::algorithms::area_coverage::Min_Time_Area_Coverage::get_age (
+  const utility::Position& pos)
+{
+  const int x = (int)pos.x;
+  const int y = (int)pos.y;
+
+  /**
+   * A new clock on the record means the cell was written, by us or another
+   * agent, since we last took its age in. Batches from other agents are
+   * dated in analyze as they arrive, so this only catches writes made
+   * outside of change sync, which are dated when they are read.
+   */
+  const Madara::Knowledge_Record record = min_time_.get_record (pos);
+  if (record.clock != record_clocks_.get (x, y))
+  {
+    record_clocks_.set (x, y, record.clock);
+    last_seen_.set (x, y, (Madara::Knowledge_Record::Integer)executions_ -
+      record.to_integer ());
+  }
+
+  return (double)((Madara::Knowledge_Record::Integer)executions_ -
+    last_seen_.get (x, y));
+}
+
+void
+gams::algorithms::area_coverage::Min_Time_Area_Coverage::set_age (
+  const utility::Position& pos, double age)
+{
+  const int x = (int)pos.x;
+  const int y = (int)pos.y;
+
+  last_seen_.set (x, y, (Madara::Knowledge_Record::Integer)executions_ -
+    (Madara::Knowledge_Record::Integer)age);
+  min_time_.set_value (pos, age);
+
+  // our own write is already in last_seen_
+  record_clocks_.set (x, y, min_time_.get_record (pos).clock);
+}
@@ -62,9 +62,12 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "madara/knowledge_engine/Knowledge_Update_Settings.h"
 
+#include "gams/maps/Grid.h"
+#include "gams/algorithms/area_coverage/Utility_Kernels.h"
 #include "gams/utility/Search_Area.h"
 #include "gams/utility/GPS_Position.h"
 #include "gams/algorithms/Algorithm_Factory.h"
@@ -93,6 +96,11 @@ namespace gams
           Madara::Knowledge_Engine::Knowledge_Base * knowledge = 0,
           platforms::Base_Platform * platform = 0, variables::Sensors * sensors = 0,
           variables::Self * self = 0, const std::string& algo_name = "mtac");
+
+        /**
+         * Destructor. Stops and joins the planner threads.
+         **/
+        virtual ~Min_Time_Area_Coverage ();
   
         /**
          * Assignment operator
@@ -101,7 +109,8 @@ namespace gams
         void operator= (const Min_Time_Area_Coverage & rhs);
 
         /**
-         * Increment sensor values
+         * Advances the tick that cell ages are measured against and marks
+         * the current cell as seen
          */
         virtual int analyze ();
 
@@ -110,25 +119,134 @@ namespace gams
         virtual void generate_new_position ();
   
         /**
-         * A better way to manage this would probably be to take a function
-         * pointer to handle utility calculation.
-         */
-        /// get utility of moving from one index position to another
-        virtual double get_utility (const utility::Position& start,
-          const utility::Position& end, std::set<utility::Position>& online);
+         * Gets the utility of observing a cell. Called once per cell each
+         * time a new position is generated.
+         * @param  pos   index of the cell
+         * @return the utility of the cell
+         **/
+        virtual double get_cell_utility (const utility::Position& pos);
+
+        /**
+         * Gets the utility of moving from one index position to another,
+         * from the cell utilities of the last update_cell_utilities
+         * @param  start    index of the current cell
+         * @param  end      index of the destination cell
+         * @param  online   if not 0, the list to append the cells passed
+         *                  through to
+         * @return the utility of the move
+         **/
+        double get_utility (const utility::Position& start,
+          const utility::Position& end,
+          std::vector<utility::Position> * online = 0);
+
+        /**
+         * Sums the cell utilities of the corridor of a path. Only reads the
+         * cell arrays, so candidates can be scored on several threads.
+         * @param  start    index of the current cell
+         * @param  end      index of the destination cell
+         * @param  radius   the sensor radius in cells
+         * @param  spans    scratch space for the corridor
+         * @return the sum of the utilities of the valid cells passed through
+         **/
+        double score_path (const utility::Position& start,
+          const utility::Position& end, double radius,
+          std::vector<maps::Column_Span>& spans) const;
+
+        /**
+         * Scores all valid cells with get_cell_utility and builds the
+         * prefix sums used to score and bound candidate destinations
+         **/
+        void update_cell_utilities ();
+
+        /**
+         * Gets the array index of a cell
+         * @param  pos     index of the cell
+         * @param  index   the array index, if the cell is in the arrays
+         * @return true if the cell is a valid position
+         **/
+        bool get_cell_index (const utility::Position& pos, size_t& index) const;
 
         /// review if last move was good, did we hit all cells we said we would
         virtual void review_last_move ();
+
+        /**
+         * Gets the number of ticks since a cell was last seen. Values that
+         * other agents wrote to the sensor map since the last read are
+         * taken in first. A remote value is the age the sender wrote, taken
+         * as of the tick on which analyze noticed it, so remote cells look
+         * younger than they are by the transport latency plus up to one
+         * tick.
+         * @param  pos   index of the cell
+         * @return the age of the cell in ticks
+         **/
+        double get_age (const utility::Position& pos);
+
+        /**
+         * Sets the age of a cell and writes it to the sensor map
+         * @param  pos       index of the cell
+         * @param  age       ticks since the cell was last seen
+         **/
+        void set_age (const utility::Position& pos, double age);
   
         /// Search Area to cover
         utility::Search_Area search_area_;
   
-        /// time since last coverage
+        /**
+         * Sensor map shared with other agents. A cell holds its age at the
+         * time it was written, which is 0 when an agent observes it.
+         **/
         variables::Sensor min_time_;
+
+        /// tick at which each cell was last seen
+        maps::Grid_Layer<Madara::Knowledge_Record::Integer> last_seen_;
+
+        /// clock of the sensor map record that last_seen_ was taken from
+        maps::Grid_Layer<uint64_t> record_clocks_;
   
         /// discretized positions in search area
         std::set<utility::Position> valid_positions_;
 
+        /// lowest x index of the valid positions
+        int cells_min_x_;
+
+        /// lowest y index of the valid positions
+        int cells_min_y_;
+
+        /// number of cells along x in the cell arrays
+        int cells_width_;
+
+        /// number of cells along y in the cell arrays
+        int cells_height_;
+
+        /// flags for the valid positions, row by row along x
+        std::vector<char> cell_valid_;
+
+        /// utility of each cell as of the last update_cell_utilities
+        std::vector<double> cell_utilities_;
+
+        /// summed area table of positive cell utilities, one row and column
+        /// larger than the cell arrays
+        std::vector<double> utility_sums_;
+
+        /// prefix sums of cell utilities along each column, column by column
+        /// with one more entry per column than there are rows
+        std::vector<double> column_sums_;
+
+        /// column runs of the corridor currently being scored
+        std::vector<maps::Column_Span> spans_;
+
+        /// candidate destinations of the current replan
+        Candidate_Buffer candidates_;
+
+        /// scores candidates, possibly on several threads
+        class Candidate_Task;
+
+        /// threads that help score candidates, kept between replans
+        class Candidate_Pool;
+
+        /// the helper threads, started by the first replan that needs them
+        Candidate_Pool * pool_;
+
         /// positions we will be passing through and their previous values
         std::map<utility::Position, double> position_value_map_;
 
@@ -63,6 +63,7 @@ using std::endl;
 #include <cmath>
 #include <set>
 using std::set;
+#include <vector>
 
 #include "gams/utility/GPS_Position.h"
 #include "gams/utility/Position.h"
@@ -96,41 +97,43 @@ gams::algorithms::area_coverage::Prioritized_Min_Time_Area_Coverage::
   variables::Self * self, const string& algo_name) :
   Min_Time_Area_Coverage (search_id, knowledge, platform, sensors, self, algo_name)
 {
+  /**
+   * Priorities come from point in polygon tests against every region, and
+   * they do not change, so test each cell once rather than on every replan.
+   */
+  std::vector<utility::Position> cells (valid_positions_.begin (),
+    valid_positions_.end ());
+  std::vector<utility::GPS_Position> gps;
+  min_time_.get_gps_from_index (cells, gps);
+  for (size_t i = 0; i < cells.size (); ++i)
+  {
+    priorities_.set ((int)cells[i].x, (int)cells[i].y,
+      search_area_.get_priority (gps[i]));
+  }
+  priorities_.clear_dirty ();
 }
 
 void
 gams::algorithms::area_coverage::Prioritized_Min_Time_Area_Coverage::operator= (
   const Prioritized_Min_Time_Area_Coverage & rhs)
 {
-  this->Min_Time_Area_Coverage::operator= (rhs);
+  if (this != &rhs)
+  {
+    this->priorities_ = rhs.priorities_;
+    this->Min_Time_Area_Coverage::operator= (rhs);
+  }
+}
+
+const gams::maps::Grid_Layer<double> &
+gams::algorithms::area_coverage::Prioritized_Min_Time_Area_Coverage::
+  get_priorities () const
+{
+  return priorities_;
 }
 
 double
-gams::algorithms::area_coverage::Prioritized_Min_Time_Area_Coverage::get_utility (
-  const utility::Position& start, const utility::Position& end,
-  set<utility::Position>& online)
+gams::algorithms::area_coverage::Prioritized_Min_Time_Area_Coverage::
+  get_cell_utility (const utility::Position& pos)
 {
-  /**
-   * check each valid position and add its value to utility if it is along
-   * the possible travel path of the agent
-   */
-  double util = 0.0;
-  const double radius =
-    min_time_.get_range () / min_time_.get_discretization ();
-  for (set<utility::Position>::const_iterator it = valid_positions_.begin ();
-    it != valid_positions_.end (); ++it)
-  {
-    if (start.distance_to_2d (end, *it) < radius)
-    {
-      const utility::GPS_Position gps = min_time_.get_gps_from_index (*it);
-      double time = min_time_.get_value (*it) * search_area_.get_priority (gps);
-      double delta_util = pow (time, 3.0);
-      util += delta_util;
-      online.insert (*it);
-    }
-  }
-  
-  // modify the utility based on the distance that will be travelled
-  util = util / sqrt (start.distance_to_2d (end) + 1);
-  return util;
+  return pow (get_age (pos) * priorities_.get ((int)pos.x, (int)pos.y), 3.0);
 }
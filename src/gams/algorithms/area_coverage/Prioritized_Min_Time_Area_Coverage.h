@@ -92,11 +92,24 @@ namespace gams
          * @param  rhs   values to copy
          **/
         void operator= (const Prioritized_Min_Time_Area_Coverage & rhs);
+
+        /**
+         * Gets the priority of each valid cell, computed once from the
+         * search area when the algorithm is created
+         * @return the priority layer, indexed like the sensor map
+         **/
+        const maps::Grid_Layer<double> & get_priorities () const;
   
       protected:
-        /// get utility of moving from one index position to another
-        virtual double get_utility (const utility::Position& start,
-          const utility::Position& end, std::set<utility::Position>& online);
+        /**
+         * Gets the utility of observing a cell, weighted by its priority
+         * @param  pos   index of the cell
+         * @return the utility of the cell
+         **/
+        virtual double get_cell_utility (const utility::Position& pos);
+
+        /// priority of each valid cell
+        maps::Grid_Layer<double> priorities_;
       }; // class Prioritized_Min_Time_Area_Coverage
 
       /**
@@ -147,17 +147,28 @@ gams::algorithms::area_coverage::Priority_Weighted_Random_Area_Coverage::
     }
   }
 
-  // select point in region
-  do
+  // select point in region, testing candidates a block at a time and
+  // accepting the first one inside
+  const size_t block = 16;
+  double lats[block], lons[block];
+  uint8_t inside[block];
+  size_t found = block;
+  while (found == block)
   {
-    next_position_.latitude (Madara::Utility::rand_double (selected_region->min_lat_,
-      selected_region->max_lat_));
-    next_position_.longitude (Madara::Utility::rand_double (selected_region->min_lon_,
-      selected_region->max_lon_));
-    next_position_.altitude (Madara::Utility::rand_double (selected_region->min_alt_,
-      selected_region->max_alt_));
+    for (size_t i = 0; i < block; ++i)
+    {
+      lats[i] = Madara::Utility::rand_double (selected_region->min_lat_,
+        selected_region->max_lat_);
+      lons[i] = Madara::Utility::rand_double (selected_region->min_lon_,
+        selected_region->max_lon_);
+    }
+    selected_region->contains (lats, lons, block, inside);
+    found = 0;
+    while (found < block && !inside[found])
+      ++found;
   }
-  while (!selected_region->contains (next_position_));
+  next_position_.latitude (lats[found]);
+  next_position_.longitude (lons[found]);
 
   // found an acceptable position, so set it as next
   utility::GPS_Position current;
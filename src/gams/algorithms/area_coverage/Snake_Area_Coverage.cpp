@@ -53,6 +53,7 @@ using std::string;
 using std::vector;
 
 #include "gams/utility/GPS_Position.h"
+#include "gams/utility/Local_Frame.h"
 #include "gams/utility/Region.h"
 #include "gams/utility/Position.h"
 
@@ -136,9 +137,8 @@ gams::algorithms::area_coverage::Snake_Area_Coverage::compute_waypoints (
   // convert to equirectangular projection coordinates
   const size_t num_edges = region.vertices.size ();
   vector<utility::Position> positions;
-  const utility::GPS_Position reference = region.vertices[0];
-  for (size_t i = 0; i < region.vertices.size (); ++i)
-    positions.push_back (region.vertices[i].to_position (reference));
+  const utility::Local_Frame reference (region.vertices[0]);
+  reference.to_positions (region.vertices, positions);
 
   // find longest edge
   size_t longest_edge = 0;
@@ -155,12 +155,12 @@ gams::algorithms::area_coverage::Snake_Area_Coverage::compute_waypoints (
   }
 
   // starting points are vertices of longest edge
-  utility::GPS_Position temp = utility::GPS_Position::to_gps_position (
-    positions[longest_edge], reference);
+  utility::GPS_Position temp = reference.to_gps_position (
+    positions[longest_edge]);
   temp.altitude (self_->device.desired_altitude.to_double ());
   waypoints_.push_back (temp);
-  temp = utility::GPS_Position::to_gps_position (
-    positions[(longest_edge + 1) % num_edges], reference);
+  temp = reference.to_gps_position (
+    positions[(longest_edge + 1) % num_edges]);
   temp.altitude (self_->device.desired_altitude.to_double ());
   waypoints_.push_back (temp);
 
@@ -259,27 +259,27 @@ gams::algorithms::area_coverage::Snake_Area_Coverage::compute_waypoints (
       if (intercept_idx > 1)
       {
         const utility::Position prev = 
-          waypoints_[waypoints_.size () - 1].to_position (reference);
+          reference.to_position (waypoints_[waypoints_.size () - 1]);
         if (prev.distance_to_2d (intercepts[0]) >
             prev.distance_to_2d (intercepts[1]))
         {
           waypoints_.push_back (
-            utility::GPS_Position::to_gps_position (intercepts[1], reference));
+            reference.to_gps_position (intercepts[1]));
           waypoints_.push_back (
-            utility::GPS_Position::to_gps_position (intercepts[0], reference));
+            reference.to_gps_position (intercepts[0]));
         }
         else
         {
           waypoints_.push_back (
-            utility::GPS_Position::to_gps_position (intercepts[0], reference));
+            reference.to_gps_position (intercepts[0]));
           waypoints_.push_back (
-            utility::GPS_Position::to_gps_position (intercepts[1], reference));
+            reference.to_gps_position (intercepts[1]));
         }
       }
       else if (intercept_idx > 0)
       {
         waypoints_.push_back (
-          utility::GPS_Position::to_gps_position (intercepts[0], reference));
+          reference.to_gps_position (intercepts[0]));
       }
     } // end while still finding intercepts
   } // end for +/- delta_b
@@ -115,16 +115,27 @@ void
 gams::algorithms::area_coverage::Uniform_Random_Area_Coverage::
   generate_new_position ()
 {
-  do
+  // test candidates a block at a time, the first one inside is accepted
+  const size_t block = 16;
+  double lats[block], lons[block];
+  uint8_t inside[block];
+  size_t found = block;
+  while (found == block)
   {
-    next_position_.latitude (Madara::Utility::rand_double (region_.min_lat_,
-      region_.max_lat_));
-    next_position_.longitude (Madara::Utility::rand_double (region_.min_lon_,
-      region_.max_lon_));
-    next_position_.altitude (Madara::Utility::rand_double (region_.min_alt_,
-      region_.max_alt_));
+    for (size_t i = 0; i < block; ++i)
+    {
+      lats[i] = Madara::Utility::rand_double (region_.min_lat_,
+        region_.max_lat_);
+      lons[i] = Madara::Utility::rand_double (region_.min_lon_,
+        region_.max_lon_);
+    }
+    region_.contains (lats, lons, block, inside);
+    found = 0;
+    while (found < block && !inside[found])
+      ++found;
   }
-  while (!region_.contains (next_position_));
+  next_position_.latitude (lats[found]);
+  next_position_.longitude (lons[found]);
 
   // found an acceptable position, so set it as next
   utility::GPS_Position current;
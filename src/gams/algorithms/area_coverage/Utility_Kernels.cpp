@@ -0,0 +1,314 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+/**
+ * @file Utility_Kernels.cpp
+ * @author James Edmondson <jedmondson@gmail.com>
+ *
+ * This file contains vectorized kernels for scoring candidate destinations
+ * of the minimum time coverage planners. The AVX2 and SSE2 versions are
+ * chosen at compile time and give the same results as the scalar version.
+ **/
+
+#include "gams/algorithms/area_coverage/Utility_Kernels.h"
+
+#include <cmath>
+#include <algorithm>
+
+#if defined (__AVX2__)
+  #define GAMS_KERNELS_AVX2
+  #include <immintrin.h>
+#elif defined (__SSE2__) || defined (_M_X64)
+  #define GAMS_KERNELS_SSE2
+  #include <emmintrin.h>
+#endif
+
+namespace
+{
+  /**
+   * Sums a box of cells, given in table offsets
+   **/
+  inline double
+  sum_box (const gams::algorithms::area_coverage::Summed_Area_Table & table,
+    int min_x, int max_x, int min_y, int max_y)
+  {
+    if (min_x > max_x || min_y > max_y)
+      return 0.0;
+
+    const int stride = table.width + 1;
+    return table.sums[(max_y + 1) * stride + max_x + 1] -
+      table.sums[min_y * stride + max_x + 1] -
+      table.sums[(max_y + 1) * stride + min_x] +
+      table.sums[min_y * stride + min_x];
+  }
+
+  /**
+   * Sums the box of one candidate
+   **/
+  inline double
+  get_box_sum (const gams::algorithms::area_coverage::Summed_Area_Table & table,
+    double start_x, double start_y, double radius, int x, int y)
+  {
+    const int max_x_index = table.min_x + table.width - 1;
+    const int max_y_index = table.min_y + table.height - 1;
+
+    return sum_box (table,
+      std::max ((int)floor (std::min (start_x, (double)x) - radius),
+        table.min_x) - table.min_x,
+      std::min ((int)ceil (std::max (start_x, (double)x) + radius),
+        max_x_index) - table.min_x,
+      std::max ((int)floor (std::min (start_y, (double)y) - radius),
+        table.min_y) - table.min_y,
+      std::min ((int)ceil (std::max (start_y, (double)y) + radius),
+        max_y_index) - table.min_y);
+  }
+
+#if defined (GAMS_KERNELS_SSE2)
+  /**
+   * Rounds two values down. SSE2 has no floor, and truncation rounds
+   * negative values up.
+   **/
+  inline __m128d
+  floor_pd (__m128d value)
+  {
+    const __m128d truncated = _mm_cvtepi32_pd (_mm_cvttpd_epi32 (value));
+    return _mm_sub_pd (truncated,
+      _mm_and_pd (_mm_cmpgt_pd (truncated, value), _mm_set1_pd (1.0)));
+  }
+
+  /**
+   * Rounds two values up
+   **/
+  inline __m128d
+  ceil_pd (__m128d value)
+  {
+    const __m128d truncated = _mm_cvtepi32_pd (_mm_cvttpd_epi32 (value));
+    return _mm_add_pd (truncated,
+      _mm_and_pd (_mm_cmplt_pd (truncated, value), _mm_set1_pd (1.0)));
+  }
+
+  /**
+   * Converts two integral values to table offsets
+   **/
+  inline void
+  store_offsets (__m128d value, __m128d table_min, int * offsets)
+  {
+    _mm_storel_epi64 ((__m128i *)offsets,
+      _mm_cvttpd_epi32 (_mm_sub_pd (value, table_min)));
+  }
+#endif
+}
+
+void
+gams::algorithms::area_coverage::Candidate_Buffer::resize (size_t count)
+{
+  x.resize (count);
+  y.resize (count);
+  weights.resize (count);
+  bounds.resize (count);
+}
+
+size_t
+gams::algorithms::area_coverage::Candidate_Buffer::size (void) const
+{
+  return x.size ();
+}
+
+void
+gams::algorithms::area_coverage::get_distance_weights (
+  const utility::Position & start,
+  const int * x, const int * y, size_t count, double * weights)
+{
+  size_t i = 0;
+
+#if defined (GAMS_KERNELS_AVX2)
+  const __m256d start_x = _mm256_set1_pd (start.x);
+  const __m256d start_y = _mm256_set1_pd (start.y);
+  const __m256d one = _mm256_set1_pd (1.0);
+  for (; i + 4 <= count; i += 4)
+  {
+    const __m256d dx = _mm256_sub_pd (_mm256_cvtepi32_pd (
+      _mm_loadu_si128 ((const __m128i *)(x + i))), start_x);
+    const __m256d dy = _mm256_sub_pd (_mm256_cvtepi32_pd (
+      _mm_loadu_si128 ((const __m128i *)(y + i))), start_y);
+    const __m256d distance = _mm256_sqrt_pd (_mm256_add_pd (
+      _mm256_mul_pd (dx, dx), _mm256_mul_pd (dy, dy)));
+    _mm256_storeu_pd (weights + i, _mm256_div_pd (one,
+      _mm256_sqrt_pd (_mm256_add_pd (distance, one))));
+  }
+#elif defined (GAMS_KERNELS_SSE2)
+  const __m128d start_x = _mm_set1_pd (start.x);
+  const __m128d start_y = _mm_set1_pd (start.y);
+  const __m128d one = _mm_set1_pd (1.0);
+  for (; i + 2 <= count; i += 2)
+  {
+    const __m128d dx = _mm_sub_pd (_mm_set_pd (x[i + 1], x[i]), start_x);
+    const __m128d dy = _mm_sub_pd (_mm_set_pd (y[i + 1], y[i]), start_y);
+    const __m128d distance = _mm_sqrt_pd (_mm_add_pd (
+      _mm_mul_pd (dx, dx), _mm_mul_pd (dy, dy)));
+    _mm_storeu_pd (weights + i, _mm_div_pd (one,
+      _mm_sqrt_pd (_mm_add_pd (distance, one))));
+  }
+#endif
+
+  // remaining candidates, or all of them without vector instructions
+  for (; i < count; ++i)
+  {
+    const double dx = x[i] - start.x;
+    const double dy = y[i] - start.y;
+    weights[i] = 1.0 / sqrt (sqrt (dx * dx + dy * dy) + 1.0);
+  }
+}
+
+void
+gams::algorithms::area_coverage::get_box_sums (
+  const Summed_Area_Table & table,
+  const utility::Position & start, double radius,
+  const int * x, const int * y, size_t count, double * sums)
+{
+  size_t i = 0;
+
+  if (table.width <= 0 || table.height <= 0)
+  {
+    std::fill (sums, sums + count, 0.0);
+    return;
+  }
+
+#if defined (GAMS_KERNELS_AVX2)
+  const __m256d start_x = _mm256_set1_pd (start.x);
+  const __m256d start_y = _mm256_set1_pd (start.y);
+  const __m256d radius_4 = _mm256_set1_pd (radius);
+  const __m128i table_min_x = _mm_set1_epi32 (table.min_x);
+  const __m128i table_min_y = _mm_set1_epi32 (table.min_y);
+  const __m128i table_max_x = _mm_set1_epi32 (table.min_x + table.width - 1);
+  const __m128i table_max_y = _mm_set1_epi32 (table.min_y + table.height - 1);
+  const __m128i stride = _mm_set1_epi32 (table.width + 1);
+  const __m128i one = _mm_set1_epi32 (1);
+
+  for (; i + 4 <= count; i += 4)
+  {
+    const __m256d cell_x = _mm256_cvtepi32_pd (
+      _mm_loadu_si128 ((const __m128i *)(x + i)));
+    const __m256d cell_y = _mm256_cvtepi32_pd (
+      _mm_loadu_si128 ((const __m128i *)(y + i)));
+
+    // the box in table offsets, as in get_box_sum
+    const __m128i min_x = _mm_sub_epi32 (_mm_max_epi32 (_mm256_cvttpd_epi32 (
+      _mm256_floor_pd (_mm256_sub_pd (_mm256_min_pd (start_x, cell_x),
+      radius_4))), table_min_x), table_min_x);
+    const __m128i max_x = _mm_sub_epi32 (_mm_min_epi32 (_mm256_cvttpd_epi32 (
+      _mm256_ceil_pd (_mm256_add_pd (_mm256_max_pd (start_x, cell_x),
+      radius_4))), table_max_x), table_min_x);
+    const __m128i min_y = _mm_sub_epi32 (_mm_max_epi32 (_mm256_cvttpd_epi32 (
+      _mm256_floor_pd (_mm256_sub_pd (_mm256_min_pd (start_y, cell_y),
+      radius_4))), table_min_y), table_min_y);
+    const __m128i max_y = _mm_sub_epi32 (_mm_min_epi32 (_mm256_cvttpd_epi32 (
+      _mm256_ceil_pd (_mm256_add_pd (_mm256_max_pd (start_y, cell_y),
+      radius_4))), table_max_y), table_min_y);
+
+    // lanes with empty boxes read entry 0 and are zeroed below
+    const __m128i empty = _mm_or_si128 (_mm_cmpgt_epi32 (min_x, max_x),
+      _mm_cmpgt_epi32 (min_y, max_y));
+
+    const __m128i low_row = _mm_mullo_epi32 (min_y, stride);
+    const __m128i high_row = _mm_mullo_epi32 (_mm_add_epi32 (max_y, one),
+      stride);
+    const __m128i high_x = _mm_add_epi32 (max_x, one);
+
+    const __m256d high_high = _mm256_i32gather_pd (table.sums,
+      _mm_andnot_si128 (empty, _mm_add_epi32 (high_row, high_x)), 8);
+    const __m256d low_high = _mm256_i32gather_pd (table.sums,
+      _mm_andnot_si128 (empty, _mm_add_epi32 (low_row, high_x)), 8);
+    const __m256d high_low = _mm256_i32gather_pd (table.sums,
+      _mm_andnot_si128 (empty, _mm_add_epi32 (high_row, min_x)), 8);
+    const __m256d low_low = _mm256_i32gather_pd (table.sums,
+      _mm_andnot_si128 (empty, _mm_add_epi32 (low_row, min_x)), 8);
+
+    const __m256d sum = _mm256_add_pd (_mm256_sub_pd (
+      _mm256_sub_pd (high_high, low_high), high_low), low_low);
+
+    _mm256_storeu_pd (sums + i, _mm256_andnot_pd (
+      _mm256_castsi256_pd (_mm256_cvtepi32_epi64 (empty)), sum));
+  }
+#elif defined (GAMS_KERNELS_SSE2)
+  // SSE2 has no gathers, so only the boxes are computed two at a time.
+  // Clamping the rounded bounds as doubles matches clamping them as ints.
+  const __m128d start_x = _mm_set1_pd (start.x);
+  const __m128d start_y = _mm_set1_pd (start.y);
+  const __m128d radius_2 = _mm_set1_pd (radius);
+  const __m128d table_min_x = _mm_set1_pd (table.min_x);
+  const __m128d table_min_y = _mm_set1_pd (table.min_y);
+  const __m128d table_max_x = _mm_set1_pd (table.min_x + table.width - 1);
+  const __m128d table_max_y = _mm_set1_pd (table.min_y + table.height - 1);
+
+  int min_x[2], max_x[2], min_y[2], max_y[2];
+  for (; i + 2 <= count; i += 2)
+  {
+    const __m128d cell_x = _mm_set_pd (x[i + 1], x[i]);
+    const __m128d cell_y = _mm_set_pd (y[i + 1], y[i]);
+
+    store_offsets (_mm_max_pd (floor_pd (_mm_sub_pd (
+      _mm_min_pd (start_x, cell_x), radius_2)), table_min_x),
+      table_min_x, min_x);
+    store_offsets (_mm_min_pd (ceil_pd (_mm_add_pd (
+      _mm_max_pd (start_x, cell_x), radius_2)), table_max_x),
+      table_min_x, max_x);
+    store_offsets (_mm_max_pd (floor_pd (_mm_sub_pd (
+      _mm_min_pd (start_y, cell_y), radius_2)), table_min_y),
+      table_min_y, min_y);
+    store_offsets (_mm_min_pd (ceil_pd (_mm_add_pd (
+      _mm_max_pd (start_y, cell_y), radius_2)), table_max_y),
+      table_min_y, max_y);
+
+    sums[i] = sum_box (table, min_x[0], max_x[0], min_y[0], max_y[0]);
+    sums[i + 1] = sum_box (table, min_x[1], max_x[1], min_y[1], max_y[1]);
+  }
+#endif
+
+  // remaining candidates, or all of them without vector instructions
+  for (; i < count; ++i)
+    sums[i] = get_box_sum (table, start.x, start.y, radius, x[i], y[i]);
+}
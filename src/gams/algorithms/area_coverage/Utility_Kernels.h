@@ -0,0 +1,153 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+/**
+ * @file Utility_Kernels.h
+ * @author James Edmondson <jedmondson@gmail.com>
+ *
+ * This file contains vectorized kernels for scoring candidate destinations
+ * of the minimum time coverage planners
+ **/
+
+#ifndef _GAMS_ALGORITHMS_AREA_COVERAGE_UTILITY_KERNELS_H_
+#define _GAMS_ALGORITHMS_AREA_COVERAGE_UTILITY_KERNELS_H_
+
+#include <vector>
+
+#include "gams/GAMS_Export.h"
+#include "gams/utility/Position.h"
+
+namespace gams
+{
+  namespace algorithms
+  {
+    namespace area_coverage
+    {
+      /**
+       * Candidate destinations held as separate arrays, so that kernels can
+       * load several candidates at once
+       **/
+      struct GAMS_Export Candidate_Buffer
+      {
+        /**
+         * Resizes all arrays
+         * @param  count   the number of candidates
+         **/
+        void resize (size_t count);
+
+        /**
+         * Gets the number of candidates
+         * @return the number of candidates
+         **/
+        size_t size (void) const;
+
+        /// x indices of the candidate cells
+        std::vector<int> x;
+
+        /// y indices of the candidate cells
+        std::vector<int> y;
+
+        /// 1 / sqrt (distance + 1) from the start to each candidate
+        std::vector<double> weights;
+
+        /// upper bounds on the weighted utility of each candidate
+        std::vector<double> bounds;
+      };
+
+      /**
+       * A summed area table over a block of cells. Entry (x, y) of the
+       * table, at sums[y * (width + 1) + x], holds the sum of the cells
+       * with lower x and y offsets.
+       **/
+      struct Summed_Area_Table
+      {
+        /// the table, (width + 1) * (height + 1) entries
+        const double * sums;
+
+        /// x index of the first cell
+        int min_x;
+
+        /// y index of the first cell
+        int min_y;
+
+        /// number of cells along x
+        int width;
+
+        /// number of cells along y
+        int height;
+      };
+
+      /**
+       * Computes 1 / sqrt (distance + 1) from a start cell to each candidate,
+       * which is the distance discount of the coverage utility
+       * @param  start     the start cell
+       * @param  x         x indices of the candidates
+       * @param  y         y indices of the candidates
+       * @param  count     the number of candidates
+       * @param  weights   the output, one weight per candidate
+       **/
+      GAMS_Export void get_distance_weights (const utility::Position & start,
+        const int * x, const int * y, size_t count, double * weights);
+
+      /**
+       * Sums the cells of a table in the bounding box of the path from a
+       * start cell to each candidate, widened by a radius
+       * @param  table     the summed area table
+       * @param  start     the start cell
+       * @param  radius    the radius to widen each box by, in cells
+       * @param  x         x indices of the candidates
+       * @param  y         y indices of the candidates
+       * @param  count     the number of candidates
+       * @param  sums      the output, one sum per candidate
+       **/
+      GAMS_Export void get_box_sums (const Summed_Area_Table & table,
+        const utility::Position & start, double radius,
+        const int * x, const int * y, size_t count, double * sums);
+    }
+  }
+}
+
+#endif // _GAMS_ALGORITHMS_AREA_COVERAGE_UTILITY_KERNELS_H_
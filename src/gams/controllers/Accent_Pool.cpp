@@ -0,0 +1,232 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+#include "Accent_Pool.h"
+#include "Base_Controller.h"
+
+#include "gams/utility/Logging.h"
+
+gams::controllers::Accent_Pool::Accent_Pool (unsigned int num_threads)
+  : work_available_ (mutex_), work_done_ (mutex_), next_job_ (0),
+  pending_ (0), phase_ (PHASE_ANALYZE), terminated_ (false)
+{
+  if (num_threads > 0)
+  {
+    activate (THR_NEW_LWP | THR_JOINABLE, (int)num_threads);
+  }
+}
+
+gams::controllers::Accent_Pool::~Accent_Pool ()
+{
+  {
+    ACE_GUARD (ACE_Thread_Mutex, guard, mutex_);
+
+    terminated_ = true;
+    work_available_.broadcast ();
+  }
+
+  wait ();
+}
+
+int
+gams::controllers::Accent_Pool::call (
+  algorithms::Base_Algorithm & algorithm, int phase)
+{
+  if (phase == PHASE_ANALYZE)
+    return algorithm.analyze ();
+  else if (phase == PHASE_PLAN)
+    return algorithm.plan ();
+  else
+    return algorithm.execute ();
+}
+
+size_t
+gams::controllers::Accent_Pool::get_waves (
+  const algorithms::Algorithms & accents, std::vector <size_t> & waves)
+{
+  // an accent must wait for the wave of every earlier accent it
+  // conflicts with, which preserves their relative order
+  waves.assign (accents.size (), 0);
+  size_t num_waves (0);
+
+  for (size_t i = 0; i < accents.size (); ++i)
+  {
+    for (size_t j = 0; j < i; ++j)
+    {
+      if (waves[j] >= waves[i] && accents[i]->conflicts_with (*accents[j]))
+        waves[i] = waves[j] + 1;
+    }
+
+    if (waves[i] + 1 > num_waves)
+      num_waves = waves[i] + 1;
+  }
+
+  return num_waves;
+}
+
+void
+gams::controllers::Accent_Pool::run (
+  algorithms::Algorithms & accents, int phase,
+  Madara::Knowledge_Engine::Knowledge_Base * knowledge)
+{
+  std::vector <size_t> waves;
+  const size_t num_waves = get_waves (accents, waves);
+
+  GAMS_DEBUG (gams::utility::LOG_DETAILED_TRACE, (LM_DEBUG, 
+    DLINFO "gams::controllers::Accent_Pool::run:" \
+    " running %u accents in %u waves\n",
+    (unsigned int)accents.size (), (unsigned int)num_waves));
+
+  for (size_t wave = 0; wave < num_waves; ++wave)
+  {
+    algorithms::Algorithms jobs;
+
+    for (size_t i = 0; i < accents.size (); ++i)
+    {
+      if (waves[i] == wave)
+        jobs.push_back (accents[i]);
+    }
+
+    if (jobs.size () == 1)
+    {
+      // no need to involve the workers, or to give up the lock
+      call (*jobs[0], phase);
+    }
+    else
+    {
+      // accents on the workers would block on the caller's lock, so
+      // each of their accesses locks instead
+      if (knowledge)
+        knowledge->unlock ();
+
+      {
+        ACE_GUARD (ACE_Thread_Mutex, guard, mutex_);
+
+        jobs_ = jobs;
+        next_job_ = 0;
+        pending_ = jobs_.size ();
+        phase_ = phase;
+
+        work_available_.broadcast ();
+      }
+
+      run_wave ();
+
+      if (knowledge)
+        knowledge->lock ();
+    }
+  }
+}
+
+void
+gams::controllers::Accent_Pool::run_wave (void)
+{
+  algorithms::Base_Algorithm * accent;
+
+  // the calling thread runs jobs until none are left to start
+  while (take (accent))
+  {
+    call (*accent, phase_);
+    finish ();
+  }
+
+  // join with the workers
+  ACE_GUARD (ACE_Thread_Mutex, guard, mutex_);
+
+  while (pending_ > 0)
+    work_done_.wait ();
+}
+
+bool
+gams::controllers::Accent_Pool::take (algorithms::Base_Algorithm *& accent)
+{
+  ACE_GUARD_RETURN (ACE_Thread_Mutex, guard, mutex_, false);
+
+  if (next_job_ < jobs_.size ())
+  {
+    accent = jobs_[next_job_++];
+    return true;
+  }
+
+  return false;
+}
+
+void
+gams::controllers::Accent_Pool::finish (void)
+{
+  ACE_GUARD (ACE_Thread_Mutex, guard, mutex_);
+
+  if (--pending_ == 0)
+    work_done_.broadcast ();
+}
+
+int
+gams::controllers::Accent_Pool::svc (void)
+{
+  for (;;)
+  {
+    algorithms::Base_Algorithm * accent;
+    int phase;
+
+    {
+      ACE_GUARD_RETURN (ACE_Thread_Mutex, guard, mutex_, -1);
+
+      while (!terminated_ && next_job_ >= jobs_.size ())
+        work_available_.wait ();
+
+      if (terminated_)
+        break;
+
+      accent = jobs_[next_job_++];
+      phase = phase_;
+    }
+
+    call (*accent, phase);
+    finish ();
+  }
+
+  return 0;
+}
@@ -0,0 +1,175 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+/**
+ * @file Accent_Pool.h
+ * @author James Edmondson <jedmondson@gmail.com>
+ *
+ * This file contains a thread pool for running accents concurrently
+ **/
+
+#ifndef   _GAMS_CONTROLLERS_ACCENT_POOL_H_
+#define   _GAMS_CONTROLLERS_ACCENT_POOL_H_
+
+#include <vector>
+
+#include "gams/GAMS_Export.h"
+#include "gams/algorithms/Base_Algorithm.h"
+#include "madara/knowledge_engine/Knowledge_Base.h"
+
+#include "ace/Task.h"
+#include "ace/Thread_Mutex.h"
+#include "ace/Condition_Thread_Mutex.h"
+
+namespace gams
+{
+  namespace controllers
+  {
+    /**
+     * Runs a phase of a list of accents on a small set of threads. Accents
+     * that conflict, according to their declared reads and writes, run in
+     * list order. The calling thread helps run the accents and returns
+     * when all of them have finished the phase.
+     **/
+    class GAMS_Export Accent_Pool : public ACE_Task_Base
+    {
+    public:
+      /**
+       * Constructor
+       * @param  num_threads   the number of worker threads in addition to
+       *                       the calling thread
+       **/
+      Accent_Pool (unsigned int num_threads);
+
+      /**
+       * Destructor. Stops and joins the worker threads.
+       **/
+      virtual ~Accent_Pool ();
+
+      /**
+       * Runs a phase on every accent and waits for all of them to finish
+       * @param  accents    the accents to run
+       * @param  phase      the phase to call (PHASE_ANALYZE, PHASE_PLAN
+       *                    or PHASE_EXECUTE). @see Loop_Phases
+       * @param  knowledge  if not 0, a knowledge base locked by the
+       *                    calling thread. It is unlocked while a wave of
+       *                    more than one accent runs on the workers, which
+       *                    would otherwise block on it.
+       **/
+      void run (algorithms::Algorithms & accents, int phase,
+        Madara::Knowledge_Engine::Knowledge_Base * knowledge = 0);
+
+      /**
+       * Groups accents into waves that may run concurrently. An accent
+       * runs in a later wave than every earlier accent it conflicts with.
+       * @param  accents  the accents to group
+       * @param  waves    the wave of each accent
+       * @return the number of waves
+       **/
+      static size_t get_waves (const algorithms::Algorithms & accents,
+        std::vector <size_t> & waves);
+
+      /**
+       * Runs a worker thread
+       * @return 0 on termination
+       **/
+      virtual int svc (void);
+
+      /**
+       * Calls a phase on an algorithm
+       * @param  algorithm   the algorithm to call
+       * @param  phase       the phase to call. @see Loop_Phases
+       * @return the result of the phase
+       **/
+      static int call (algorithms::Base_Algorithm & algorithm, int phase);
+
+    protected:
+      /**
+       * Runs a group of non-conflicting accents concurrently and waits
+       * for them to finish
+       **/
+      void run_wave (void);
+
+      /**
+       * Takes the next unstarted job
+       * @param  accent   the accent to run
+       * @return true if a job was taken
+       **/
+      bool take (algorithms::Base_Algorithm *& accent);
+
+      /**
+       * Marks a job as finished
+       **/
+      void finish (void);
+
+      /// guard for the job list
+      ACE_Thread_Mutex mutex_;
+
+      /// signaled when jobs are added or the pool is terminated
+      ACE_Condition_Thread_Mutex work_available_;
+
+      /// signaled when the last job of a wave finishes
+      ACE_Condition_Thread_Mutex work_done_;
+
+      /// the accents of the current wave
+      algorithms::Algorithms jobs_;
+
+      /// the index of the next job to start
+      size_t next_job_;
+
+      /// the number of jobs that have not finished
+      size_t pending_;
+
+      /// the phase to call on the current jobs
+      int phase_;
+
+      /// flag for workers to exit
+      bool terminated_;
+    };
+  }
+}
+
+#endif // _GAMS_CONTROLLERS_ACCENT_POOL_H_
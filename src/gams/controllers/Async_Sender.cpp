@@ -0,0 +1,259 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+#include "Async_Sender.h"
+
+#include "ace/High_Res_Timer.h"
+#include "ace/OS_NS_sys_time.h"
+#include "madara/transport/multicast/Multicast_Transport.h"
+#include "madara/transport/broadcast/Broadcast_Transport.h"
+#include "madara/transport/udp/UDP_Transport.h"
+#include "gams/utility/Logging.h"
+
+gams::controllers::Async_Sender::Async_Sender (
+  Madara::Knowledge_Engine::Knowledge_Base & knowledge,
+  Madara::Transport::Base & transport, double send_period)
+  : knowledge_ (knowledge), transport_ (transport), pending_ (0),
+  sends_ (0), coalesced_ (0), stopped_ (mutex_), terminated_ (false),
+  running_ (false)
+{
+  // the sender should not spin when the loop runs as fast as possible
+  if (send_period < 0.001)
+    send_period = 0.001;
+
+  send_period_.set (send_period);
+}
+
+gams::controllers::Async_Sender::~Async_Sender ()
+{
+  stop ();
+}
+
+Madara::Transport::Base *
+gams::controllers::Async_Sender::create_transport (
+  Madara::Knowledge_Engine::Knowledge_Base & knowledge,
+  const Madara::Transport::QoS_Transport_Settings & settings)
+{
+  Madara::Transport::QoS_Transport_Settings config (settings);
+  Madara::Transport::Base * result (0);
+
+  if (config.type == Madara::Transport::MULTICAST)
+  {
+    result = new Madara::Transport::Multicast_Transport (knowledge.get_id (),
+      knowledge.get_context (), config, true);
+  }
+  else if (config.type == Madara::Transport::BROADCAST)
+  {
+    result = new Madara::Transport::Broadcast_Transport (knowledge.get_id (),
+      knowledge.get_context (), config, true);
+  }
+  else if (config.type == Madara::Transport::UDP)
+  {
+    result = new Madara::Transport::UDP_Transport (knowledge.get_id (),
+      knowledge.get_context (), config, true);
+  }
+  else
+  {
+    GAMS_DEBUG (gams::utility::LOG_EMERGENCY, (LM_DEBUG, 
+      DLINFO "gams::controllers::Async_Sender::create_transport:" \
+      " ERROR: transport type %d is not supported\n", (int)config.type));
+  }
+
+  return result;
+}
+
+void
+gams::controllers::Async_Sender::start (void)
+{
+  if (!running_)
+  {
+    terminated_ = false;
+    running_ = true;
+    activate (THR_NEW_LWP | THR_JOINABLE, 1);
+  }
+}
+
+void
+gams::controllers::Async_Sender::stop (void)
+{
+  if (running_)
+  {
+    {
+      ACE_GUARD (ACE_Thread_Mutex, guard, mutex_);
+
+      terminated_ = true;
+      stopped_.signal ();
+    }
+
+    wait ();
+    running_ = false;
+  }
+}
+
+void
+gams::controllers::Async_Sender::collect (void)
+{
+  std::list <Batch> batch (1);
+  Batch & updates = batch.front ();
+
+  // only the copy is made under the knowledge base lock
+  Madara::Knowledge_Engine::Thread_Safe_Context & context =
+    knowledge_.get_context ();
+  context.lock ();
+
+  const Madara::Knowledge_Records & modifieds = context.get_modifieds ();
+  for (Madara::Knowledge_Records::const_iterator i = modifieds.begin ();
+    i != modifieds.end (); ++i)
+  {
+    updates[i->first] = *i->second;
+  }
+  context.reset_modified ();
+
+  context.unlock ();
+
+  // the sender merges the batches, so the handoff is only a splice
+  ACE_GUARD (ACE_Thread_Mutex, guard, mutex_);
+
+  batches_.splice (batches_.end (), batch);
+  ++pending_;
+}
+
+unsigned int
+gams::controllers::Async_Sender::get_sends (void) const
+{
+  return sends_;
+}
+
+unsigned int
+gams::controllers::Async_Sender::get_coalesced (void) const
+{
+  return coalesced_;
+}
+
+void
+gams::controllers::Async_Sender::flush (void)
+{
+  std::list <Batch> batches;
+  unsigned int iterations;
+
+  {
+    ACE_GUARD (ACE_Thread_Mutex, guard, mutex_);
+
+    batches.swap (batches_);
+    iterations = pending_;
+    pending_ = 0;
+  }
+
+  // later batches hold the later values
+  Batch updates;
+  for (std::list <Batch>::iterator batch = batches.begin ();
+    batch != batches.end (); ++batch)
+  {
+    if (updates.empty ())
+    {
+      updates.swap (*batch);
+      continue;
+    }
+
+    for (Batch::iterator i = batch->begin (); i != batch->end (); ++i)
+      updates[i->first] = i->second;
+  }
+
+  if (!updates.empty ())
+  {
+    GAMS_DEBUG (gams::utility::LOG_MINOR_EVENT, (LM_DEBUG, 
+      DLINFO "gams::controllers::Async_Sender::flush:" \
+      " sending %u variables from %u iterations\n",
+      (unsigned int)updates.size (), iterations));
+
+    Madara::Knowledge_Records records;
+    for (Batch::iterator i = updates.begin (); i != updates.end (); ++i)
+    {
+      records[i->first] = &i->second;
+    }
+
+    transport_.send_data (records);
+
+    ++sends_;
+    if (iterations > 1)
+      coalesced_ += iterations - 1;
+  }
+}
+
+int
+gams::controllers::Async_Sender::svc (void)
+{
+  ACE_Time_Value next_epoch = ACE_High_Res_Timer::gettimeofday_hr ();
+
+  for (;;)
+  {
+    next_epoch += send_period_;
+
+    {
+      ACE_GUARD_RETURN (ACE_Thread_Mutex, guard, mutex_, -1);
+
+      ACE_Time_Value current = ACE_High_Res_Timer::gettimeofday_hr ();
+
+      // condition timeouts are absolute times of day
+      if (!terminated_ && current < next_epoch)
+      {
+        ACE_Time_Value timeout = ACE_OS::gettimeofday () +
+          (next_epoch - current);
+        stopped_.wait (&timeout);
+      }
+
+      if (terminated_)
+        break;
+    }
+
+    flush ();
+  }
+
+  // updates from the last iterations are never dropped
+  flush ();
+
+  return 0;
+}
@@ -0,0 +1,200 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+/**
+ * @file Async_Sender.h
+ * @author James Edmondson <jedmondson@gmail.com>
+ *
+ * This file contains a thread that sends knowledge base updates
+ * independently of the control loop
+ **/
+
+#ifndef   _GAMS_CONTROLLERS_ASYNC_SENDER_H_
+#define   _GAMS_CONTROLLERS_ASYNC_SENDER_H_
+
+#include <list>
+#include <map>
+#include <string>
+
+#include "gams/GAMS_Export.h"
+#include "madara/knowledge_engine/Knowledge_Base.h"
+#include "madara/transport/Transport.h"
+#include "madara/transport/QoS_Transport_Settings.h"
+
+#include "ace/Task.h"
+#include "ace/Thread_Mutex.h"
+#include "ace/Condition_Thread_Mutex.h"
+
+namespace gams
+{
+  namespace controllers
+  {
+    /**
+     * Sends modified variables on its own thread at a fixed period. At
+     * the end of each iteration, the control loop copies the modified
+     * variables of the knowledge base into a batch with collect, which
+     * holds the knowledge base lock only to copy them. Batches are handed
+     * to the sender thread under a mutex that is held only to splice a
+     * batch into, or swap the batches out of, a list, so neither side
+     * waits on the other's copying, merging or sending. A slow transport
+     * never delays the loop and never sees state from an unfinished
+     * iteration. All writes to a variable between two sends are coalesced
+     * into its latest value.
+     **/
+    class GAMS_Export Async_Sender : public ACE_Task_Base
+    {
+    public:
+      /**
+       * Constructor
+       * @param  knowledge    the knowledge base to send updates from
+       * @param  transport    the transport to send updates through. It
+       *                      is not attached to the knowledge base, so
+       *                      send_modifieds does not use it.
+       * @param  send_period  time (in seconds) between sends. Periods
+       *                      below a millisecond are rounded up.
+       **/
+      Async_Sender (Madara::Knowledge_Engine::Knowledge_Base & knowledge,
+        Madara::Transport::Base & transport, double send_period);
+
+      /**
+       * Destructor. Stops the sender if it is running.
+       **/
+      virtual ~Async_Sender ();
+
+      /**
+       * Creates a transport that receives into a knowledge base and can
+       * be used by a sender
+       * @param  knowledge    the knowledge base to receive into
+       * @param  settings     the transport settings
+       * @return the new transport, or 0 if the type is not supported
+       **/
+      static Madara::Transport::Base * create_transport (
+        Madara::Knowledge_Engine::Knowledge_Base & knowledge,
+        const Madara::Transport::QoS_Transport_Settings & settings);
+
+      /**
+       * Starts the sender thread
+       **/
+      void start (void);
+
+      /**
+       * Stops the sender thread after flushing any pending updates
+       **/
+      void stop (void);
+
+      /**
+       * Copies the variables modified since the last collect into a batch
+       * for the sender and clears their modified flags. Called by the loop
+       * between iterations, when the knowledge base is consistent.
+       **/
+      void collect (void);
+
+      /**
+       * Gets the number of times updates were sent
+       * @return the number of sends
+       **/
+      unsigned int get_sends (void) const;
+
+      /**
+       * Gets the number of collected iterations that were folded into a
+       * send with other iterations
+       * @return the number of coalesced iterations
+       **/
+      unsigned int get_coalesced (void) const;
+
+      /**
+       * Runs the sender thread
+       * @return 0 on termination
+       **/
+      virtual int svc (void);
+
+    protected:
+      /**
+       * Sends the latest values of the variables in the collected batches,
+       * if any, in one send
+       **/
+      void flush (void);
+
+      /// variables modified in one or more iterations, by name
+      typedef std::map <std::string, Madara::Knowledge_Record> Batch;
+
+      /// the knowledge base to send updates from
+      Madara::Knowledge_Engine::Knowledge_Base & knowledge_;
+
+      /// the transport to send updates through
+      Madara::Transport::Base & transport_;
+
+      /// time between sends
+      ACE_Time_Value send_period_;
+
+      /// batches collected since the last send, oldest first
+      std::list <Batch> batches_;
+
+      /// iterations collected since the last send
+      unsigned int pending_;
+
+      /// the number of sends
+      unsigned int sends_;
+
+      /// the number of coalesced iterations
+      unsigned int coalesced_;
+
+      /// guard for the batches and the termination flag
+      ACE_Thread_Mutex mutex_;
+
+      /// signaled when the sender should stop
+      ACE_Condition_Thread_Mutex stopped_;
+
+      /// flag for the sender thread to exit
+      bool terminated_;
+
+      /// true while the sender thread is running
+      bool running_;
+    };
+  }
+}
+
+#endif // _GAMS_CONTROLLERS_ASYNC_SENDER_H_
@@ -55,6 +55,7 @@
 #include "gams/platforms/Platform_Factory.h"
 #include "gams/algorithms/Algorithm_Factory.h"
 #include "gams/utility/Logging.h"
+#include "gams/utility/Trace_Buffer.h"
 
 // Java-specific header includes
 #ifdef _GAMS_JAVA_
@@ -67,15 +68,41 @@ using std::endl;
 
 typedef  Madara::Knowledge_Record::Integer  Integer;
 
+namespace
+{
+  /**
+   * Converts a time value into seconds
+   * @param  value   the time value to convert
+   * @return  the number of seconds in the time value
+   **/
+  inline double to_seconds (const ACE_Time_Value & value)
+  {
+    return value.sec () + value.usec () / 1000000.0;
+  }
+
+  /// names of the loop phases, indexed by Loop_Phases
+  const char * phase_names [gams::controllers::NUM_LOOP_PHASES] =
+  {
+    "monitor", "analyze", "plan", "execute", "accents", "send"
+  };
+}
+
 gams::controllers::Base_Controller::Base_Controller (
   Madara::Knowledge_Engine::Knowledge_Base & knowledge)
-  : algorithm_ (0), knowledge_ (knowledge), platform_ (0),
-  algorithm_factory_ (&knowledge, &sensors_, platform_, 0, &devices_),
+  : algorithm_ (0), knowledge_ (knowledge),
+  overrun_policy_ (OVERRUN_CATCH_UP), execution_model_ (EXECUTION_LOCKED),
+  profiling_ (false), accent_time_ (0), accent_pool_ (0),
+  holds_lock_ (false), async_transport_ (0), event_driven_ (false),
+  clock_ (utility::default_clock ()), cache_algorithms_ (false),
+  platform_ (0),
+  algorithm_factory_ (&knowledge, &sensors_, platform_, &self_, &devices_),
   platform_factory_ (&knowledge, &sensors_, &platforms_, 0)
 {
   GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
     DLINFO "gams::controllers::Base_Controller::constructor:" \
     " default constructor called.\n"));
+
+  loop_stats_.init_vars (knowledge_);
 }
 
 gams::controllers::Base_Controller::~Base_Controller ()
@@ -83,7 +110,8 @@ gams::controllers::Base_Controller::~Base_Controller ()
   GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
     DLINFO "gams::controllers::Base_Controller::destructor:" \
     " deleting algorithm.\n"));
-  delete algorithm_;
+  release_algorithm ();
+  clear_algorithm_cache ();
 
   GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
     DLINFO "gams::controllers::Base_Controller::destructor:" \
@@ -98,6 +126,9 @@ gams::controllers::Base_Controller::~Base_Controller ()
   {
     delete *i;
   }
+
+  delete accent_pool_;
+  delete async_transport_;
 }
 
 void gams::controllers::Base_Controller::add_platform_factory (
@@ -231,11 +262,8 @@ gams::controllers::Base_Controller::analyze (void)
     GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
       DLINFO "gams::controllers::Base_Controller::analyze:" \
       " calling analyze on accents\n"));
-    for (algorithms::Algorithms::iterator i = accents_.begin ();
-      i != accents_.end (); ++i)
-    {
-      (*i)->analyze ();
-    }
+
+    run_accents (PHASE_ANALYZE);
   }
 
   return return_value;
@@ -267,11 +295,7 @@ gams::controllers::Base_Controller::plan (void)
       DLINFO "gams::controllers::Base_Controller::plan:" \
       " calling plan on accents\n"));
 
-    for (algorithms::Algorithms::iterator i = accents_.begin ();
-      i != accents_.end (); ++i)
-    {
-      (*i)->plan ();
-    }
+    run_accents (PHASE_PLAN);
   }
 
   return return_value;
@@ -299,11 +323,7 @@ gams::controllers::Base_Controller::execute (void)
 
   if (accents_.size () > 0)
   {
-    for (algorithms::Algorithms::iterator i = accents_.begin ();
-      i != accents_.end (); ++i)
-    {
-      (*i)->execute ();
-    }
+    run_accents (PHASE_EXECUTE);
   }
 
   return return_value;
@@ -323,12 +343,24 @@ gams::controllers::Base_Controller::run (double loop_period,
     send_period = loop_period;
   }
 
-  // loop every period until a max run time has been reached
-  ACE_Time_Value current = ACE_OS::gettimeofday ();  
-  ACE_Time_Value max_wait, sleep_time, next_epoch;
-  ACE_Time_Value send_sleep_time, send_next_epoch;
+  // simulated time only moves when the loop sleeps until the next period,
+  // so without a period the max runtime would never be reached
+  if (loop_period <= 0.0 && max_runtime >= 0.0 && clock_->is_simulated ())
+  {
+    GAMS_DEBUG (gams::utility::LOG_EMERGENCY, (LM_DEBUG, 
+      DLINFO "gams::controllers::Base_Controller::run:" \
+      " a simulated clock requires a positive loop_period\n"));
+
+    return -1;
+  }
+
+  // loop every period until a max run time has been reached. All timing
+  // uses the controller's clock, which by default follows the high
+  // resolution timer so wall clock adjustments do not disturb the schedule.
+  ACE_Time_Value current = clock_->now ();
+  ACE_Time_Value start (current), max_wait, next_epoch;
+  ACE_Time_Value send_next_epoch;
   ACE_Time_Value poll_frequency, send_poll_frequency;
-  ACE_Time_Value last (current), last_send (current);
   
   GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
     DLINFO "gams::controllers::Base_Controller::run:" \
@@ -342,85 +374,576 @@ gams::controllers::Base_Controller::run (double loop_period,
     
     poll_frequency.set (loop_period);
     send_poll_frequency.set (send_period);
-    next_epoch = current + poll_frequency;
-    send_next_epoch = current;
 
-    unsigned int iterations = 0;
-    while (first_execute || max_runtime < 0 || current < max_wait)
-    {
-      // return value should be last return value of mape loop
-      return_value = 0;
-      
-      GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
-        DLINFO "gams::controllers::Base_Controller::run:" \
-        " calling monitor ()\n"));
-
-      // lock the context from any external updates
-      knowledge_.lock ();
+    // the first iteration is scheduled for now
+    next_epoch = current;
+    send_next_epoch = current;
 
-      return_value |= monitor ();
+    loop_stats_.reset (loop_period);
 
-      GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
-        DLINFO "gams::controllers::Base_Controller::run:" \
-        " calling analyze ()\n"));
+    // with an asynchronous sender, the loop never calls send_modifieds
+    Async_Sender * sender (0);
+    if (async_transport_)
+    {
+      sender = new Async_Sender (knowledge_, *async_transport_, send_period);
+      sender->start ();
+    }
 
-      return_value |= analyze ();
+    // in event-driven mode, the loop waits for changes instead of sleeping
+    Change_Watcher * watcher (0);
+    if (event_driven_)
+    {
+      watcher = new Change_Watcher (knowledge_);
+      watcher->add (self_.device.command.get_name ());
+      watcher->add (swarm_.command.get_name ());
 
-      GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
-        DLINFO "gams::controllers::Base_Controller::run:" \
-        " calling plan ()\n"));
+      for (size_t i = 0; i < watched_.size (); ++i)
+      {
+        watcher->add (watched_[i]);
+      }
 
-      return_value |= plan ();
+      watcher->start ();
+    }
 
-      GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
-        DLINFO "gams::controllers::Base_Controller::run:" \
-        " calling execute ()\n"));
+    while (first_execute || max_runtime < 0 || current < max_wait)
+    {
+      loop_stats_.record_start (to_seconds (current - start),
+        to_seconds (next_epoch - start));
 
-      return_value |= execute ();
-    
-      // unlock the context to allow external updates
-      knowledge_.unlock ();
+      // the deadline of the following iteration
+      next_epoch += poll_frequency;
+      
+      // return value should be last return value of mape loop
+      return_value = run_iteration ();
 
       // grab current time
-      current = ACE_OS::gettimeofday ();
+      current = clock_->now ();
       
+      if (sender)
+      {
+        // the iteration is complete, so its changes are consistent
+        sender->collect ();
+      }
       // run will always try to send at least once
-      if (first_execute || current > send_next_epoch)
+      else if (first_execute || current > send_next_epoch)
       {
         GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
           DLINFO "gams::controllers::Base_Controller::run:" \
           " sending updates\n"));
 
-        // send modified values through network
-        knowledge_.send_modifieds();
+        // timing statistics are local variables and are not sent
+        loop_stats_.publish ();
+
+        send_updates ();
 
-        // setup the next send epoch
-        while (send_next_epoch < current)
-          send_next_epoch += send_poll_frequency;
+        // setup the next send epoch. Without a send period, every
+        // iteration sends.
+        if (send_poll_frequency == ACE_Time_Value::zero)
+          send_next_epoch = current;
+        else
+        {
+          while (send_next_epoch < current)
+            send_next_epoch += send_poll_frequency;
+        }
       }
 
-      // check to see if we need to sleep for next loop epoch
-      if (loop_period > 0.0 && current < next_epoch)
+      if (loop_period > 0.0)
       {
-        GAMS_DEBUG (gams::utility::LOG_MINOR_EVENT, (LM_DEBUG, 
-          DLINFO "gams::controllers::Base_Controller::run:" \
-          " sleeping until next epoch\n"));
+        // check to see if we need to sleep for next loop epoch
+        if (current < next_epoch)
+        {
+          GAMS_DEBUG (gams::utility::LOG_MINOR_EVENT, (LM_DEBUG, 
+            DLINFO "gams::controllers::Base_Controller::run:" \
+            " sleeping until next epoch\n"));
+
+          if (watcher)
+          {
+            // the period is only a fallback when nothing changes
+            bool changed = watcher->wait_for_change (
+              to_seconds (next_epoch - current));
+
+            current = clock_->now ();
+
+            // react now and restart the fallback period from here
+            if (changed)
+              next_epoch = current;
+          }
+          else
+          {
+            clock_->sleep_until (next_epoch);
+
+            current = clock_->now ();
+          }
+        }
+        else
+        {
+          unsigned int skipped = 0;
+
+          if (overrun_policy_ == OVERRUN_SKIP)
+          {
+            // drop every deadline that has already passed
+            skipped = (unsigned int)(
+              to_seconds (current - next_epoch) / loop_period) + 1;
+
+            ACE_Time_Value skip_time;
+            skip_time.set (skipped * loop_period);
+            next_epoch += skip_time;
+          }
+
+          GAMS_DEBUG (gams::utility::LOG_MINOR_EVENT, (LM_DEBUG, 
+            DLINFO "gams::controllers::Base_Controller::run:" \
+            " iteration overran its period. Skipping %u deadlines\n",
+            skipped));
+
+          loop_stats_.record_overrun (skipped);
+
+          // the skip policy realigns to the next boundary, which is later
+          if (overrun_policy_ == OVERRUN_SKIP && current < next_epoch)
+          {
+            clock_->sleep_until (next_epoch);
+
+            current = clock_->now ();
+          }
+        }
+      }
+      else if (watcher)
+      {
+        // with no period, wait for a change for as long as we may run
+        if (max_runtime < 0 || current < max_wait)
+        {
+          watcher->wait_for_change (
+            max_runtime < 0 ? -1.0 : to_seconds (max_wait - current));
 
-        Madara::Utility::sleep (next_epoch - current);  
+          current = clock_->now ();
+        }
+
+        next_epoch = current;
+      }
+      else
+      {
+        // with no period, every iteration is scheduled immediately
+        next_epoch = current;
       }
-      
-      // setup the next 
-      next_epoch += poll_frequency;
 
       // run will always execute at least one time. Update flag for execution.
       if (first_execute)
         first_execute = false;
     }
+
+    loop_stats_.publish ();
+
+    if (watcher)
+    {
+      watcher->stop ();
+      delete watcher;
+    }
+
+    if (sender)
+    {
+      GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
+        DLINFO "gams::controllers::Base_Controller::run:" \
+        " async sender made %u sends, coalesced %u iterations\n",
+        sender->get_sends (), sender->get_coalesced ()));
+
+      // flushes the updates of the final iterations
+      sender->stop ();
+      delete sender;
+    }
+
+    if (profiling_)
+      publish_profile ();
   }
 
   return return_value;
 }
 
+int
+gams::controllers::Base_Controller::run_once (void)
+{
+  int return_value = run_iteration ();
+
+  GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
+    DLINFO "gams::controllers::Base_Controller::run_once:" \
+    " sending updates\n"));
+
+  send_updates ();
+
+  return return_value;
+}
+
+int
+gams::controllers::Base_Controller::run_iteration (void)
+{
+  int return_value (0);
+
+  // phase trace events mark the end of each phase
+  GAMS_TRACE_EVENT (gams::utility::LOG_DETAILED_TRACE, "iteration", 0, 0);
+
+  GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
+    DLINFO "gams::controllers::Base_Controller::run_iteration:" \
+    " calling monitor ()\n"));
+
+  const bool unlocked_io = execution_model_ == EXECUTION_UNLOCKED_IO;
+
+  // lock the context from any external updates
+  if (!unlocked_io)
+  {
+    knowledge_.lock ();
+    holds_lock_ = true;
+  }
+
+  ACE_High_Res_Timer phase_timer;
+  accent_time_ = 0;
+  if (profiling_)
+    phase_timer.start ();
+
+  return_value |= monitor ();
+  record_phase (PHASE_MONITOR, phase_timer);
+
+  // external updates are held off while analyze and plan run
+  if (unlocked_io)
+  {
+    knowledge_.lock ();
+    holds_lock_ = true;
+  }
+
+  GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
+    DLINFO "gams::controllers::Base_Controller::run_iteration:" \
+    " calling analyze ()\n"));
+
+  return_value |= analyze ();
+  record_phase (PHASE_ANALYZE, phase_timer);
+
+  GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
+    DLINFO "gams::controllers::Base_Controller::run_iteration:" \
+    " calling plan ()\n"));
+
+  return_value |= plan ();
+  record_phase (PHASE_PLAN, phase_timer);
+
+  // platform commands may block, so allow external updates meanwhile
+  if (unlocked_io)
+  {
+    holds_lock_ = false;
+    knowledge_.unlock ();
+  }
+
+  GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
+    DLINFO "gams::controllers::Base_Controller::run_iteration:" \
+    " calling execute ()\n"));
+
+  return_value |= execute ();
+  record_phase (PHASE_EXECUTE, phase_timer);
+
+  // unlock the context to allow external updates
+  if (!unlocked_io)
+  {
+    holds_lock_ = false;
+    knowledge_.unlock ();
+  }
+
+  if (profiling_ && accents_.size () > 0)
+    profile_[PHASE_ACCENTS].record (accent_time_);
+
+  return return_value;
+}
+
+void
+gams::controllers::Base_Controller::send_updates (void)
+{
+  ACE_High_Res_Timer send_timer;
+
+  if (profiling_)
+    send_timer.start ();
+
+  // send modified values through network
+  knowledge_.send_modifieds();
+  record_phase (PHASE_SEND, send_timer);
+}
+
+void
+gams::controllers::Base_Controller::set_overrun_policy (int policy)
+{
+  overrun_policy_ = policy;
+}
+
+int
+gams::controllers::Base_Controller::get_overrun_policy (void) const
+{
+  return overrun_policy_;
+}
+
+void
+gams::controllers::Base_Controller::set_execution_model (int model)
+{
+  execution_model_ = model;
+}
+
+int
+gams::controllers::Base_Controller::get_execution_model (void) const
+{
+  return execution_model_;
+}
+
+const gams::variables::Loop_Statistics &
+gams::controllers::Base_Controller::get_loop_statistics (void) const
+{
+  return loop_stats_;
+}
+
+void
+gams::controllers::Base_Controller::enable_profiling (bool enabled)
+{
+  profiling_ = enabled;
+}
+
+void
+gams::controllers::Base_Controller::reset_profile (void)
+{
+  for (int i = 0; i < NUM_LOOP_PHASES; ++i)
+  {
+    profile_[i].reset ();
+  }
+}
+
+const gams::utility::Latency_Histogram &
+gams::controllers::Base_Controller::get_profile (int phase) const
+{
+  return profile_[phase];
+}
+
+void
+gams::controllers::Base_Controller::publish_profile (void)
+{
+  GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
+    DLINFO "gams::controllers::Base_Controller::publish_profile:" \
+    " publishing phase latencies to .gams.perf\n"));
+
+  for (int i = 0; i < NUM_LOOP_PHASES; ++i)
+  {
+    std::string prefix (".gams.perf.");
+    prefix += phase_names[i];
+
+    knowledge_.set (prefix + ".count", Integer (profile_[i].get_count ()));
+    knowledge_.set (prefix + ".p50",
+      profile_[i].get_percentile (50.0) / 1000000000.0);
+    knowledge_.set (prefix + ".p99",
+      profile_[i].get_percentile (99.0) / 1000000000.0);
+    knowledge_.set (prefix + ".max",
+      profile_[i].get_max () / 1000000000.0);
+  }
+}
+
+std::string
+gams::controllers::Base_Controller::profile_to_string (void) const
+{
+  std::stringstream buffer;
+
+  for (int i = 0; i < NUM_LOOP_PHASES; ++i)
+  {
+    buffer << phase_names[i] << " (us): ";
+    buffer << profile_[i].to_string (1000.0) << "\n";
+  }
+
+  return buffer.str ();
+}
+
+void
+gams::controllers::Base_Controller::record_phase (int phase,
+  ACE_High_Res_Timer & timer)
+{
+  GAMS_TRACE_EVENT (gams::utility::LOG_DETAILED_TRACE,
+    phase_names[phase], phase, 0);
+
+  if (profiling_)
+  {
+    ACE_hrtime_t elapsed;
+    timer.stop ();
+    timer.elapsed_time (elapsed);
+    profile_[phase].record (elapsed);
+
+    // the next phase starts now
+    timer.start ();
+  }
+}
+
+void
+gams::controllers::Base_Controller::set_async_send (bool enabled,
+  const Madara::Transport::QoS_Transport_Settings & settings)
+{
+  delete async_transport_;
+  async_transport_ = 0;
+
+  if (enabled)
+  {
+    async_transport_ = Async_Sender::create_transport (knowledge_, settings);
+
+    if (!async_transport_)
+    {
+      GAMS_DEBUG (gams::utility::LOG_EMERGENCY, (LM_DEBUG, 
+        DLINFO "gams::controllers::Base_Controller::set_async_send:" \
+        " ERROR: no transport for the sender. Sending from the loop.\n"));
+    }
+  }
+}
+
+bool
+gams::controllers::Base_Controller::get_async_send (void) const
+{
+  return async_transport_ != 0;
+}
+
+void
+gams::controllers::Base_Controller::set_event_driven (bool enabled)
+{
+  event_driven_ = enabled;
+}
+
+bool
+gams::controllers::Base_Controller::get_event_driven (void) const
+{
+  return event_driven_;
+}
+
+void
+gams::controllers::Base_Controller::watch (const std::string & name)
+{
+  watched_.push_back (name);
+}
+
+void
+gams::controllers::Base_Controller::set_clock (utility::Clock * clock)
+{
+  clock_ = clock ? clock : utility::default_clock ();
+
+  if (platform_)
+    platform_->set_clock (clock_);
+
+  if (algorithm_)
+    algorithm_->set_clock (clock_);
+
+  for (algorithms::Algorithms::iterator i = accents_.begin ();
+    i != accents_.end (); ++i)
+  {
+    (*i)->set_clock (clock_);
+  }
+}
+
+gams::utility::Clock *
+gams::controllers::Base_Controller::get_clock (void)
+{
+  return clock_;
+}
+
+void
+gams::controllers::Base_Controller::set_algorithm_caching (bool enabled)
+{
+  cache_algorithms_ = enabled;
+
+  if (!enabled)
+    clear_algorithm_cache ();
+}
+
+void
+gams::controllers::Base_Controller::clear_algorithm_cache (void)
+{
+  // the active algorithm stays owned by the controller
+  for (std::map <std::string, algorithms::Base_Algorithm *>::iterator i =
+    algorithm_cache_.begin (); i != algorithm_cache_.end (); ++i)
+  {
+    if (i->second != algorithm_)
+      delete i->second;
+  }
+
+  algorithm_cache_.clear ();
+}
+
+std::string
+gams::controllers::Base_Controller::get_algorithm_key (
+  const std::string & algorithm, const Madara::Knowledge_Vector & args) const
+{
+  // fields are prefixed with their lengths, and arguments with their
+  // types, so that different names and arguments never share a key
+  std::stringstream key;
+  key << algorithm.size () << ":" << algorithm;
+
+  for (size_t i = 0; i < args.size (); ++i)
+  {
+    const std::string value (args[i].to_string ());
+    key << "," << args[i].type () << ":" << value.size () << ":" << value;
+  }
+
+  return key.str ();
+}
+
+void
+gams::controllers::Base_Controller::release_algorithm (void)
+{
+  bool cached (false);
+
+  for (std::map <std::string, algorithms::Base_Algorithm *>::iterator i =
+    algorithm_cache_.begin (); i != algorithm_cache_.end () && !cached; ++i)
+  {
+    cached = i->second == algorithm_;
+  }
+
+  if (!cached)
+    delete algorithm_;
+
+  algorithm_ = 0;
+}
+
+void
+gams::controllers::Base_Controller::set_accent_threads (
+  unsigned int threads)
+{
+  delete accent_pool_;
+  accent_pool_ = 0;
+
+  if (threads > 1)
+  {
+    // the thread running the loop also runs accents
+    accent_pool_ = new Accent_Pool (threads - 1);
+  }
+}
+
+void
+gams::controllers::Base_Controller::run_accents (int phase)
+{
+  ACE_High_Res_Timer accent_timer;
+  if (profiling_)
+    accent_timer.start ();
+
+  if (accent_pool_ && accents_.size () > 1)
+  {
+    // the pool gives up our lock only for waves that use the workers
+    accent_pool_->run (accents_, phase, holds_lock_ ? &knowledge_ : 0);
+  }
+  else
+  {
+    for (algorithms::Algorithms::iterator i = accents_.begin ();
+      i != accents_.end (); ++i)
+    {
+      Accent_Pool::call (**i, phase);
+    }
+  }
+
+  record_accents (accent_timer);
+}
+
+void
+gams::controllers::Base_Controller::record_accents (
+  ACE_High_Res_Timer & timer)
+{
+  if (profiling_)
+  {
+    ACE_hrtime_t elapsed;
+    timer.stop ();
+    timer.elapsed_time (elapsed);
+    accent_time_ += elapsed;
+  }
+}
+
 void
 gams::controllers::Base_Controller::init_accent (const std::string & algorithm,
   const Madara::Knowledge_Vector & args)
@@ -437,19 +960,18 @@ gams::controllers::Base_Controller::init_accent (const std::string & algorithm,
   }
   else
   {
-    // create new accent pointer and algorithm factory
+    // create new accent pointer
     algorithms::Base_Algorithm * new_accent (0);
-    algorithms::Controller_Algorithm_Factory factory (&knowledge_, &sensors_,
-      platform_, &self_, &devices_);
     
     GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
       DLINFO "gams::controllers::Base_Controller::init_accent:" \
       " factory is creating accent %s\n", algorithm.c_str ()));
 
-    new_accent = factory.create (algorithm, args);
+    new_accent = algorithm_factory_.create (algorithm, args);
 
     if (new_accent)
     {
+      new_accent->set_clock (clock_);
       accents_.push_back (new_accent);
     }
     else
@@ -500,26 +1022,49 @@ const std::string & algorithm, const Madara::Knowledge_Vector & args)
       DLINFO "gams::controllers::Base_Controller::init_platform:" \
       " deleting old algorithm\n"));
 
-    delete algorithm_;
-    algorithms::Controller_Algorithm_Factory factory (&knowledge_, &sensors_,
-      platform_, &self_, &devices_);
-    
-    GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
-      DLINFO "gams::controllers::Base_Controller::init_algorithm:" \
-      " factory is creating algorithm %s\n", algorithm.c_str ()));
+    release_algorithm ();
 
-    algorithm_ = factory.create (algorithm, args);
+    std::string key;
+    std::map <std::string, algorithms::Base_Algorithm *>::iterator cached =
+      algorithm_cache_.end ();
 
-    if (algorithm_ == 0)
+    if (cache_algorithms_)
     {
-      // the user is going to expect this kind of error to be printed immediately
-      GAMS_DEBUG (gams::utility::LOG_EMERGENCY, (LM_DEBUG, 
+      key = get_algorithm_key (algorithm, args);
+      cached = algorithm_cache_.find (key);
+    }
+
+    if (cached != algorithm_cache_.end ())
+    {
+      GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
         DLINFO "gams::controllers::Base_Controller::init_algorithm:" \
-        " failed to create algorithm\n"));
+        " reactivating cached algorithm %s\n", algorithm.c_str ()));
+
+      algorithm_ = cached->second;
+      init_vars (*algorithm_);
     }
     else
     {
-      init_vars (*algorithm_);
+      GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
+        DLINFO "gams::controllers::Base_Controller::init_algorithm:" \
+        " factory is creating algorithm %s\n", algorithm.c_str ()));
+
+      algorithm_ = algorithm_factory_.create (algorithm, args);
+
+      if (algorithm_ == 0)
+      {
+        // the user is going to expect this kind of error to be printed immediately
+        GAMS_DEBUG (gams::utility::LOG_EMERGENCY, (LM_DEBUG, 
+          DLINFO "gams::controllers::Base_Controller::init_algorithm:" \
+          " failed to create algorithm\n"));
+      }
+      else
+      {
+        init_vars (*algorithm_);
+
+        if (cache_algorithms_)
+          algorithm_cache_[key] = algorithm_;
+      }
     }
   }
 }
@@ -558,6 +1103,7 @@ gams::controllers::Base_Controller::init_platform (
       " factory is creating platform %s\n", platform.c_str ()));
 
     platform_ = factory.create (platform);
+    algorithm_factory_.set_platform (platform_);
     
     init_vars (*platform_);
 
@@ -578,7 +1124,7 @@ void gams::controllers::Base_Controller::init_algorithm (algorithms::Base_Algori
     DLINFO "gams::controllers::Base_Controller::init_algorithm:" \
     " deleting old algorithm\n"));
 
-  delete algorithm_;
+  release_algorithm ();
   algorithm_ = algorithm;
   
   if (algorithm_)
@@ -606,6 +1152,7 @@ void gams::controllers::Base_Controller::init_platform (platforms::Base_Platform
 
   delete platform_;
   platform_ = platform;
+  algorithm_factory_.set_platform (platform_);
 
   if (platform_)
   {
@@ -640,7 +1187,7 @@ void gams::controllers::Base_Controller::init_algorithm (jobject algorithm)
     DLINFO "gams::controllers::Base_Controller::init_algorithm (java):" \
     " deleting old algorithm\n"));
 
-  delete algorithm_;
+  release_algorithm ();
 
   GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
     DLINFO "gams::controllers::Base_Controller::init_algorithm (java):" \
@@ -672,6 +1219,7 @@ void gams::controllers::Base_Controller::init_platform (jobject platform)
     " creating new Java platform\n"));
 
   platform_ = new gams::platforms::Java_Platform (platform);
+  algorithm_factory_.set_platform (platform_);
 
   if (platform_)
   {
@@ -719,6 +1267,7 @@ gams::controllers::Base_Controller::init_vars (platforms::Base_Platform & platfo
   platform.knowledge_ = &knowledge_;
   platform.self_ = &self_;
   platform.sensors_ = &sensors_;
+  platform.clock_ = clock_;
 }
 
 
@@ -734,6 +1283,7 @@ gams::controllers::Base_Controller::init_vars (algorithms::Base_Algorithm & algo
   algorithm.platform_ = platform_;
   algorithm.self_ = &self_;
   algorithm.sensors_ = &sensors_;
+  algorithm.clock_ = clock_;
 }
 
 gams::algorithms::Base_Algorithm *
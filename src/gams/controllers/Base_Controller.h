@@ -61,12 +61,22 @@
 #include "gams/variables/Sensor.h"
 #include "gams/variables/Algorithm_Status.h"
 #include "gams/variables/Platform_Status.h"
+#include "gams/variables/Loop_Statistics.h"
 #include "gams/algorithms/Base_Algorithm.h"
 #include "gams/platforms/Base_Platform.h"
 #include "gams/algorithms/Controller_Algorithm_Factory.h"
 #include "gams/platforms/Controller_Platform_Factory.h"
 #include "gams/algorithms/Algorithm_Factory.h"
 #include "gams/platforms/Platform_Factory.h"
+#include "gams/utility/Latency_Histogram.h"
+#include "gams/utility/Clock.h"
+#include "gams/controllers/Accent_Pool.h"
+#include "gams/controllers/Async_Sender.h"
+#include "gams/controllers/Change_Watcher.h"
+
+#include <map>
+
+#include "ace/High_Res_Timer.h"
 
 #ifdef _GAMS_JAVA_
 #include <jni.h>
@@ -76,6 +86,46 @@ namespace gams
 {
   namespace controllers
   {
+    /**
+     * Policies for handling loop iterations that take longer than a period
+     **/
+    enum Overrun_Policies
+    {
+      /// run missed iterations back to back until the schedule is caught up
+      OVERRUN_CATCH_UP = 0,
+      /// drop missed iterations and resume at the next period boundary
+      OVERRUN_SKIP = 1
+    };
+
+    /**
+     * Models for guarding the knowledge base during a loop iteration
+     **/
+    enum Execution_Models
+    {
+      /// hold the knowledge base lock for the entire MAPE iteration
+      EXECUTION_LOCKED = 0,
+      /**
+       * monitor and execute without the lock, and analyze and plan within
+       * one critical section. Values read by monitor may change before
+       * analyze, so this is not a snapshot of the whole iteration.
+       **/
+      EXECUTION_UNLOCKED_IO = 1
+    };
+
+    /**
+     * Phases of a control loop iteration that can be profiled
+     **/
+    enum Loop_Phases
+    {
+      PHASE_MONITOR = 0,
+      PHASE_ANALYZE = 1,
+      PHASE_PLAN = 2,
+      PHASE_EXECUTE = 3,
+      PHASE_ACCENTS = 4,
+      PHASE_SEND = 5,
+      NUM_LOOP_PHASES = 6
+    };
+
     class GAMS_Export Base_Controller
     {
     public:
@@ -122,7 +172,10 @@ namespace gams
       virtual int execute (void);
      
       /**
-       * Runs iterations of the MAPE loop with specified periods
+       * Runs iterations of the MAPE loop with specified periods. Iterations
+       * are scheduled against absolute deadlines on a monotonic clock, so
+       * a slow iteration does not shift the schedule of later ones. Timing
+       * statistics are published to .gams.perf.loop.* on every send.
        * @param  loop_period  time (in seconds) between executions of the loop.
        *                      0 period is meant to run loop iterations as fast
        *                      as possible. Negative loop periods are invalid.
@@ -130,11 +183,20 @@ namespace gams
        * @param  send_period  time (in seconds) between sending data.
        *                      If send_period <= 0, send period will use the
        *                      loop period.
-       * @return  the result of the MAPE loop
+       * @return  the result of the MAPE loop, or -1 if a simulated clock
+       *          has no positive loop period to advance by
        **/
       int run (double loop_period = 0.0,
         double max_runtime = -1,
         double send_period = -1.0);
+
+      /**
+       * Runs a single iteration of the MAPE loop and sends modified
+       * values. This is intended for external drivers, such as a
+       * Controller_Pool, that schedule many controllers themselves.
+       * @return  the result of the MAPE loop
+       **/
+      int run_once (void);
       
       /**
        * Runs iterations of the MAPE loop with specified hertz
@@ -169,6 +231,168 @@ namespace gams
         return run (loop_rate, max_runtime, send_rate);
       }
 
+      /**
+       * Sets the policy for iterations that overrun their period
+       * @param  policy   the overrun policy. @see Overrun_Policies
+       **/
+      void set_overrun_policy (int policy);
+
+      /**
+       * Gets the policy for iterations that overrun their period
+       * @return the overrun policy. @see Overrun_Policies
+       **/
+      int get_overrun_policy (void) const;
+
+      /**
+       * Sets how the knowledge base is locked during an iteration. In
+       * the unlocked I/O model, monitor and execute run without the
+       * knowledge base lock, so blocking platform calls do not stall
+       * the transport receive threads. Each variable access still locks
+       * the context for its own duration. Analyze and plan run within a
+       * single critical section, so no external updates arrive while they
+       * run, but updates that arrive between monitor and analyze are seen
+       * by analyze and plan.
+       * @param  model   the execution model. @see Execution_Models
+       **/
+      void set_execution_model (int model);
+
+      /**
+       * Gets how the knowledge base is locked during an iteration
+       * @return the execution model. @see Execution_Models
+       **/
+      int get_execution_model (void) const;
+
+      /**
+       * Enables or disables sending updates from a separate thread during
+       * run. When enabled, a slow transport does not delay iterations,
+       * and all writes made between two sends go out as one message at
+       * the send period. The send phase is then not profiled.
+       *
+       * The sender uses its own transport, created here from settings,
+       * which also receives updates into the knowledge base. The
+       * knowledge base should have no transport of its own, or updates
+       * are sent twice by anything else that calls send_modifieds.
+       * @param  enabled   true to send asynchronously
+       * @param  settings  settings of the sender's transport
+       **/
+      void set_async_send (bool enabled,
+        const Madara::Transport::QoS_Transport_Settings & settings);
+
+      /**
+       * Checks if updates are sent from a separate thread during run
+       * @return true if sends are asynchronous
+       **/
+      bool get_async_send (void) const;
+
+      /**
+       * Enables or disables event-driven iterations in run. Instead of
+       * sleeping until the next period, the loop wakes as soon as a
+       * watched variable changes. The device and swarm command variables
+       * are always watched. The loop period becomes the maximum time
+       * between iterations, and a period of 0 waits only for changes.
+       * @param  enabled   true to wake on changes
+       **/
+      void set_event_driven (bool enabled = true);
+
+      /**
+       * Checks if iterations are event-driven
+       * @return true if the loop wakes on changes
+       **/
+      bool get_event_driven (void) const;
+
+      /**
+       * Adds a variable that wakes the loop in event-driven mode
+       * @param  name   the name of the variable (e.g. "device.1.location")
+       **/
+      void watch (const std::string & name);
+
+      /**
+       * Sets the clock that schedules run and that the platform and
+       * algorithms read time from. With a utility::Virtual_Clock, run
+       * jumps to each deadline instead of sleeping, so a mission is
+       * stepped as fast as its iterations allow and is reproducible.
+       * A virtual clock needs a positive loop period to advance, and run
+       * returns -1 without iterating if it would never reach its max
+       * runtime.
+       * Event-driven waits and asynchronous sends still use real time.
+       * The controller does not take ownership of the clock.
+       * @param  clock   the clock. 0 uses the real time clock.
+       **/
+      void set_clock (utility::Clock * clock);
+
+      /**
+       * Gets the clock that schedules run
+       * @return the clock
+       **/
+      utility::Clock * get_clock (void);
+
+      /**
+       * Enables or disables caching of algorithms. When enabled, an
+       * algorithm that is replaced by init_algorithm is kept, and
+       * switching back to the same algorithm name and arguments
+       * reactivates it with its state intact instead of constructing it
+       * again. Disabling the cache deletes all inactive algorithms.
+       * @param  enabled   true to cache algorithms
+       **/
+      void set_algorithm_caching (bool enabled = true);
+
+      /**
+       * Deletes all inactive cached algorithms
+       **/
+      void clear_algorithm_cache (void);
+
+      /**
+       * Sets the number of threads that run accents. With more than one
+       * thread, accents that do not conflict according to their declared
+       * reads and writes run concurrently, and each phase waits for all
+       * of its accents. While concurrent accents run, the knowledge base
+       * lock of the iteration is released, so each accent access locks
+       * the context individually.
+       * @param  threads   the number of threads, including the loop
+       *                   thread. 0 or 1 runs accents in sequence.
+       **/
+      void set_accent_threads (unsigned int threads);
+
+      /**
+       * Gets the timing statistics of the last or current run
+       * @return the loop statistics
+       **/
+      const variables::Loop_Statistics & get_loop_statistics (void) const;
+
+      /**
+       * Enables or disables latency profiling of the loop phases. When
+       * enabled, run times monitor, analyze, plan, execute, the accents
+       * and send_modifieds on every iteration. Analyze, plan and execute
+       * include the time of their accents. Accents is the total time
+       * spent in accents during an iteration.
+       * @param  enabled   true to record phase latencies
+       **/
+      void enable_profiling (bool enabled = true);
+
+      /**
+       * Clears all recorded phase latencies
+       **/
+      void reset_profile (void);
+
+      /**
+       * Gets the latency histogram of a loop phase
+       * @param  phase   the phase to retrieve. @see Loop_Phases
+       * @return the histogram of phase latencies in nanoseconds
+       **/
+      const utility::Latency_Histogram & get_profile (int phase) const;
+
+      /**
+       * Publishes the p50, p99, max and count of each phase to the local
+       * variables .gams.perf.{phase}.* (latencies in seconds)
+       **/
+      void publish_profile (void);
+
+      /**
+       * Helper function for converting the phase latencies to a string
+       * @return a line per phase with latencies in microseconds
+       **/
+      std::string profile_to_string (void) const;
+
       /**
        * Adds an accent algorithm
        * @param  algorithm   the name of the accent algorithm to add
@@ -290,6 +514,56 @@ namespace gams
 
     protected:
 
+      /**
+       * Runs monitor, analyze, plan and execute once, locking the
+       * knowledge base according to the execution model
+       * @return  the result of the MAPE loop
+       **/
+      int run_iteration (void);
+
+      /**
+       * Sends modified values through the network
+       **/
+      void send_updates (void);
+
+      /**
+       * Records the latency of a phase if profiling is enabled and restarts
+       * the timer for the next phase
+       * @param  phase   the phase that just finished. @see Loop_Phases
+       * @param  timer   the timer that was started at the phase beginning
+       **/
+      void record_phase (int phase, ACE_High_Res_Timer & timer);
+
+      /**
+       * Builds the algorithm cache key of an algorithm name and arguments.
+       * Keys differ whenever the name, or the type or value of any
+       * argument, differs.
+       * @param  algorithm   the name of the algorithm
+       * @param  args        the arguments of the algorithm
+       * @return the cache key
+       **/
+      std::string get_algorithm_key (const std::string & algorithm,
+        const Madara::Knowledge_Vector & args) const;
+
+      /**
+       * Deletes the current algorithm, unless it is cached, and clears it
+       **/
+      void release_algorithm (void);
+
+      /**
+       * Calls a phase on every accent, concurrently if accent threads
+       * have been set
+       * @param  phase   the phase to call. @see Loop_Phases
+       **/
+      void run_accents (int phase);
+
+      /**
+       * Adds the time since the timer was started to the accent total
+       * of the current iteration if profiling is enabled
+       * @param  timer   the timer that was started before the accents
+       **/
+      void record_accents (ACE_High_Res_Timer & timer);
+
       /// accents on the primary algorithm
       algorithms::Algorithms accents_;
 
@@ -305,6 +579,48 @@ namespace gams
       /// knowledge base
       Madara::Knowledge_Engine::Knowledge_Base & knowledge_;
 
+      /// timing statistics of the control loop
+      variables::Loop_Statistics loop_stats_;
+
+      /// policy for iterations that overrun their period
+      int overrun_policy_;
+
+      /// how the knowledge base is locked during an iteration
+      int execution_model_;
+
+      /// flag for recording phase latencies
+      bool profiling_;
+
+      /// latency histograms of each loop phase
+      utility::Latency_Histogram profile_[NUM_LOOP_PHASES];
+
+      /// total accent time in the current iteration in nanoseconds
+      ACE_hrtime_t accent_time_;
+
+      /// threads for running accents concurrently
+      Accent_Pool * accent_pool_;
+
+      /// true while the loop holds the knowledge base lock
+      bool holds_lock_;
+
+      /// transport of the asynchronous sender, or 0 to send from the loop
+      Madara::Transport::Base * async_transport_;
+
+      /// flag for waking the loop on changes rather than periods
+      bool event_driven_;
+
+      /// variables, besides commands, that wake an event-driven loop
+      std::vector <std::string> watched_;
+
+      /// the source of time for the loop, platform and algorithms
+      utility::Clock * clock_;
+
+      /// flag for keeping replaced algorithms for reactivation
+      bool cache_algorithms_;
+
+      /// algorithms by name and arguments, including the current one
+      std::map <std::string, algorithms::Base_Algorithm *> algorithm_cache_;
+
       /// Platform on which the controller is running
       platforms::Base_Platform * platform_;
 
@@ -0,0 +1,200 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+#include "Change_Watcher.h"
+
+#include "ace/OS_NS_sys_time.h"
+#include "ace/OS_NS_unistd.h"
+#include "gams/utility/Logging.h"
+
+namespace
+{
+  /// how often wait_for_change checks the clocks itself, in microseconds
+  const suseconds_t POLL_PERIOD_USEC = 10000;
+}
+
+gams::controllers::Change_Watcher::Change_Watcher (
+  Madara::Knowledge_Engine::Knowledge_Base & knowledge)
+  : knowledge_ (knowledge), context_clock_ (0), changed_condition_ (mutex_),
+  changed_ (false), terminated_ (false), running_ (false)
+{
+}
+
+gams::controllers::Change_Watcher::~Change_Watcher ()
+{
+  stop ();
+}
+
+void
+gams::controllers::Change_Watcher::add (const std::string & name)
+{
+  if (name != "")
+  {
+    names_.push_back (name);
+    clocks_.push_back (knowledge_.get (name).clock);
+  }
+}
+
+void
+gams::controllers::Change_Watcher::start (void)
+{
+  if (!running_)
+  {
+    terminated_ = false;
+    changed_ = false;
+    context_clock_ = knowledge_.get_context ().get_clock ();
+    running_ = true;
+    activate (THR_NEW_LWP | THR_JOINABLE, 1);
+  }
+}
+
+void
+gams::controllers::Change_Watcher::stop (void)
+{
+  if (running_)
+  {
+    terminated_ = true;
+
+    // wake the helper thread without writing to the knowledge base. It
+    // may be between checking the flag and waiting, so keep waking it
+    // until it has exited.
+    while (thr_count () > 0)
+    {
+      knowledge_.signal ();
+      ACE_OS::sleep (ACE_Time_Value (0, 1000));
+    }
+
+    wait ();
+    running_ = false;
+  }
+}
+
+bool
+gams::controllers::Change_Watcher::wait_for_change (double max_wait)
+{
+  ACE_GUARD_RETURN (ACE_Thread_Mutex, guard, mutex_, false);
+
+  // condition timeouts are absolute times of day
+  ACE_Time_Value deadline;
+  deadline.set (max_wait);
+  deadline += ACE_OS::gettimeofday ();
+
+  /**
+   * The helper thread misses changes made between its check of the clocks
+   * and its next wait on the knowledge base, and MADARA's wait has no
+   * timeout, so the clocks are also checked here every poll period.
+   **/
+  while (!changed_ && !(changed_ = check ()))
+  {
+    ACE_Time_Value timeout = ACE_OS::gettimeofday ();
+    if (max_wait >= 0 && timeout >= deadline)
+      break;
+
+    timeout += ACE_Time_Value (0, POLL_PERIOD_USEC);
+    if (max_wait >= 0 && deadline < timeout)
+      timeout = deadline;
+
+    changed_condition_.wait (&timeout);
+  }
+
+  bool result = changed_;
+  changed_ = false;
+
+  return result;
+}
+
+bool
+gams::controllers::Change_Watcher::check (void)
+{
+  bool result (false);
+
+  // without watched variables, any change to the knowledge base counts
+  if (names_.size () == 0)
+  {
+    const uint64_t clock = knowledge_.get_context ().get_clock ();
+    result = clock != context_clock_;
+    context_clock_ = clock;
+  }
+
+  for (size_t i = 0; i < names_.size (); ++i)
+  {
+    uint64_t clock = knowledge_.get (names_[i]).clock;
+
+    if (clock != clocks_[i])
+    {
+      clocks_[i] = clock;
+      result = true;
+    }
+  }
+
+  return result;
+}
+
+int
+gams::controllers::Change_Watcher::svc (void)
+{
+  while (!terminated_)
+  {
+    knowledge_.wait_for_change ();
+
+    if (terminated_)
+      break;
+
+    ACE_GUARD_RETURN (ACE_Thread_Mutex, guard, mutex_, -1);
+
+    if (check () || names_.size () == 0)
+    {
+      GAMS_DEBUG (gams::utility::LOG_DETAILED_TRACE, (LM_DEBUG, 
+        DLINFO "gams::controllers::Change_Watcher::svc:" \
+        " watched variables changed. Waking loop.\n"));
+
+      changed_ = true;
+      changed_condition_.signal ();
+    }
+  }
+
+  return 0;
+}
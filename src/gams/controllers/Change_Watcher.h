@@ -0,0 +1,169 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+/**
+ * @file Change_Watcher.h
+ * @author James Edmondson <jedmondson@gmail.com>
+ *
+ * This file contains a helper for waking control loops on knowledge
+ * base changes
+ **/
+
+#ifndef   _GAMS_CONTROLLERS_CHANGE_WATCHER_H_
+#define   _GAMS_CONTROLLERS_CHANGE_WATCHER_H_
+
+#include <string>
+#include <vector>
+
+#include "gams/GAMS_Export.h"
+#include "madara/knowledge_engine/Knowledge_Base.h"
+
+#include "ace/Task.h"
+#include "ace/Thread_Mutex.h"
+#include "ace/Condition_Thread_Mutex.h"
+
+namespace gams
+{
+  namespace controllers
+  {
+    /**
+     * Blocks a control loop until a watched variable changes. A helper
+     * thread waits on the change notifications of the knowledge base,
+     * which are raised by local writes and by transport updates, and
+     * compares the clocks of the watched variables against the last
+     * ones seen by the loop. The waiting loop also compares the clocks
+     * every few milliseconds, for changes made while the helper thread
+     * was not waiting. With an empty watch set, every change wakes the
+     * loop.
+     **/
+    class GAMS_Export Change_Watcher : public ACE_Task_Base
+    {
+    public:
+      /**
+       * Constructor
+       * @param  knowledge    the knowledge base to watch
+       **/
+      Change_Watcher (Madara::Knowledge_Engine::Knowledge_Base & knowledge);
+
+      /**
+       * Destructor. Stops the watcher if it is running.
+       **/
+      virtual ~Change_Watcher ();
+
+      /**
+       * Adds a variable to the watch set. Should be called before start.
+       * @param  name   the name of the variable
+       **/
+      void add (const std::string & name);
+
+      /**
+       * Starts the helper thread
+       **/
+      void start (void);
+
+      /**
+       * Stops and joins the helper thread. The thread is woken through the
+       * change notifications of the knowledge base, so no variables are
+       * written.
+       **/
+      void stop (void);
+
+      /**
+       * Waits until a watched variable changes or the timeout expires.
+       * Changes are seen when the helper thread is woken by the knowledge
+       * base, or at the latest within a poll period of 10 ms.
+       * @param  max_wait   maximum time to wait in seconds. Negative
+       *                    waits without a timeout.
+       * @return true if a watched variable changed
+       **/
+      bool wait_for_change (double max_wait);
+
+      /**
+       * Runs the helper thread
+       * @return 0 on termination
+       **/
+      virtual int svc (void);
+
+    protected:
+      /**
+       * Checks the watched variables, or the knowledge base clock if no
+       * variables are watched, for new clocks and remembers them.
+       * Must be called with the mutex held.
+       * @return true if any watched variable has changed
+       **/
+      bool check (void);
+
+      /// the knowledge base to watch
+      Madara::Knowledge_Engine::Knowledge_Base & knowledge_;
+
+      /// the watched variable names
+      std::vector <std::string> names_;
+
+      /// the last clock seen for each watched variable
+      std::vector <uint64_t> clocks_;
+
+      /// the last knowledge base clock seen, if no variables are watched
+      uint64_t context_clock_;
+
+      /// guard for the change flag and clocks
+      ACE_Thread_Mutex mutex_;
+
+      /// signaled when a watched variable changes
+      ACE_Condition_Thread_Mutex changed_condition_;
+
+      /// true if a change has not been consumed by wait_for_change
+      bool changed_;
+
+      /// flag for the helper thread to exit
+      volatile bool terminated_;
+
+      /// true while the helper thread is running
+      bool running_;
+    };
+  }
+}
+
+#endif // _GAMS_CONTROLLERS_CHANGE_WATCHER_H_
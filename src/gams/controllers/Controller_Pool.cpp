@@ -0,0 +1,289 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+#include "Controller_Pool.h"
+
+#include "ace/High_Res_Timer.h"
+#include "ace/OS_NS_sys_time.h"
+#include "ace/OS_NS_unistd.h"
+#include "madara/utility/Utility.h"
+#include "gams/utility/Logging.h"
+
+gams::controllers::Controller_Pool::Controller_Pool (
+  unsigned int num_threads)
+  : num_threads_ (num_threads), barrier_ (0), next_worker_ (0),
+  steals_ (0), overruns_ (0), terminated_ (false)
+{
+  if (num_threads_ == 0)
+  {
+    long processors = ACE_OS::num_processors_online ();
+    num_threads_ = processors > 0 ? (unsigned int)processors : 1;
+  }
+
+  for (unsigned int i = 0; i < num_threads_; ++i)
+  {
+    queues_.push_back (new Worker_Queue ());
+  }
+}
+
+gams::controllers::Controller_Pool::~Controller_Pool ()
+{
+  for (unsigned int i = 0; i < queues_.size (); ++i)
+  {
+    delete queues_[i];
+  }
+
+  delete barrier_;
+}
+
+void
+gams::controllers::Controller_Pool::add (Base_Controller * controller)
+{
+  if (controller)
+  {
+    // rounds call run_once, which knows nothing of the loop settings
+    if (controller->get_clock () != utility::default_clock () ||
+      controller->get_overrun_policy () != OVERRUN_CATCH_UP ||
+      controller->get_async_send () || controller->get_event_driven ())
+    {
+      GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
+        DLINFO "gams::controllers::Controller_Pool::add:" \
+        " WARNING: the pool ignores the clock, overrun policy, async send" \
+        " and event-driven settings of controller %u\n",
+        (unsigned int)controllers_.size ()));
+    }
+
+    controllers_.push_back (controller);
+  }
+}
+
+size_t
+gams::controllers::Controller_Pool::size (void) const
+{
+  return controllers_.size ();
+}
+
+unsigned int
+gams::controllers::Controller_Pool::get_num_threads (void) const
+{
+  return num_threads_;
+}
+
+unsigned int
+gams::controllers::Controller_Pool::get_overruns (void) const
+{
+  return overruns_;
+}
+
+unsigned int
+gams::controllers::Controller_Pool::get_steals (void) const
+{
+  return steals_.value ();
+}
+
+unsigned int
+gams::controllers::Controller_Pool::run (
+  double loop_period, double max_runtime)
+{
+  unsigned int rounds (0);
+
+  GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
+    DLINFO "gams::controllers::Controller_Pool::run:" \
+    " running %u controllers on %u threads\n",
+    (unsigned int)controllers_.size (), num_threads_));
+
+  if (loop_period < 0.0)
+    return rounds;
+
+  overruns_ = 0;
+  steals_ = 0;
+  next_worker_ = 0;
+  terminated_ = false;
+
+  // the scheduler participates in every barrier with the workers
+  delete barrier_;
+  barrier_ = new ACE_Barrier (num_threads_ + 1);
+
+  activate (THR_NEW_LWP | THR_JOINABLE, (int)num_threads_);
+
+  ACE_Time_Value current = ACE_High_Res_Timer::gettimeofday_hr ();
+  ACE_Time_Value max_wait, next_epoch (current), poll_frequency;
+
+  max_wait.set (max_runtime);
+  max_wait = current + max_wait;
+  poll_frequency.set (loop_period);
+
+  while (rounds == 0 || max_runtime < 0 || current < max_wait)
+  {
+    next_epoch += poll_frequency;
+
+    // release the workers to queue their controllers
+    barrier_->wait ();
+
+    // wait for all queues to be filled before stealing is allowed
+    barrier_->wait ();
+
+    // wait for every controller to finish its iteration
+    barrier_->wait ();
+
+    ++rounds;
+
+    current = ACE_High_Res_Timer::gettimeofday_hr ();
+
+    if (loop_period > 0.0)
+    {
+      if (current < next_epoch)
+      {
+        Madara::Utility::sleep (next_epoch - current);
+
+        current = ACE_High_Res_Timer::gettimeofday_hr ();
+      }
+      else
+      {
+        GAMS_DEBUG (gams::utility::LOG_MINOR_EVENT, (LM_DEBUG, 
+          DLINFO "gams::controllers::Controller_Pool::run:" \
+          " round %u overran its period\n", rounds));
+
+        ++overruns_;
+      }
+    }
+    else
+    {
+      next_epoch = current;
+    }
+  }
+
+  // release the workers one last time so they see the termination
+  terminated_ = true;
+  barrier_->wait ();
+
+  wait ();
+
+  GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
+    DLINFO "gams::controllers::Controller_Pool::run:" \
+    " finished %u rounds with %u overruns and %u steals\n",
+    rounds, overruns_, steals_.value ()));
+
+  return rounds;
+}
+
+int
+gams::controllers::Controller_Pool::svc (void)
+{
+  unsigned int worker = next_worker_++;
+  Worker_Queue & queue = *queues_[worker];
+
+  for (;;)
+  {
+    barrier_->wait ();
+
+    if (terminated_)
+      break;
+
+    // queue this worker's share of the controllers
+    {
+      ACE_GUARD_RETURN (ACE_Thread_Mutex, guard, queue.mutex, -1);
+
+      for (size_t i = worker; i < controllers_.size (); i += num_threads_)
+      {
+        queue.controllers.push_back (controllers_[i]);
+      }
+    }
+
+    barrier_->wait ();
+
+    Base_Controller * controller;
+
+    while (pop (worker, controller) || steal (worker, controller))
+    {
+      controller->run_once ();
+    }
+
+    barrier_->wait ();
+  }
+
+  return 0;
+}
+
+bool
+gams::controllers::Controller_Pool::pop (unsigned int worker,
+  Base_Controller *& controller)
+{
+  Worker_Queue & queue = *queues_[worker];
+
+  ACE_GUARD_RETURN (ACE_Thread_Mutex, guard, queue.mutex, false);
+
+  if (queue.controllers.size () > 0)
+  {
+    controller = queue.controllers.front ();
+    queue.controllers.pop_front ();
+    return true;
+  }
+
+  return false;
+}
+
+bool
+gams::controllers::Controller_Pool::steal (unsigned int worker,
+  Base_Controller *& controller)
+{
+  for (unsigned int i = 1; i < num_threads_; ++i)
+  {
+    Worker_Queue & victim = *queues_[(worker + i) % num_threads_];
+
+    ACE_GUARD_RETURN (ACE_Thread_Mutex, guard, victim.mutex, false);
+
+    if (victim.controllers.size () > 0)
+    {
+      controller = victim.controllers.back ();
+      victim.controllers.pop_back ();
+      ++steals_;
+      return true;
+    }
+  }
+
+  return false;
+}
@@ -0,0 +1,209 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+/**
+ * @file Controller_Pool.h
+ * @author James Edmondson <jedmondson@gmail.com>
+ *
+ * This file contains a thread pool for running many controllers in one
+ * process
+ **/
+
+#ifndef   _GAMS_CONTROLLERS_CONTROLLER_POOL_H_
+#define   _GAMS_CONTROLLERS_CONTROLLER_POOL_H_
+
+#include <deque>
+#include <vector>
+
+#include "gams/GAMS_Export.h"
+#include "gams/controllers/Base_Controller.h"
+
+#include "ace/Task.h"
+#include "ace/Barrier.h"
+#include "ace/Thread_Mutex.h"
+#include "ace/Atomic_Op.h"
+
+namespace gams
+{
+  namespace controllers
+  {
+    /**
+     * Runs the MAPE loops of many controllers on a fixed set of threads.
+     * Each controller should have its own knowledge base. On every
+     * period, each worker queues its share of the controllers and runs
+     * them. Idle workers steal controllers from the back of the queues
+     * of busy workers, so a few slow agents do not hold up a round.
+     *
+     * Each controller runs one run_once per round, which runs an iteration
+     * and sends its updates. The pool's period and clock schedule the
+     * rounds, so the settings of Base_Controller::run do not apply: the
+     * controller's clock, overrun policy, asynchronous sender and
+     * event-driven mode are ignored, and its loop statistics are not
+     * recorded. Controllers using any of these are accepted with a
+     * warning.
+     **/
+    class GAMS_Export Controller_Pool : public ACE_Task_Base
+    {
+    public:
+      /**
+       * Constructor
+       * @param  num_threads   the number of worker threads. 0 uses the
+       *                       number of online processors.
+       **/
+      Controller_Pool (unsigned int num_threads = 0);
+
+      /**
+       * Destructor
+       **/
+      virtual ~Controller_Pool ();
+
+      /**
+       * Adds a controller to the pool. The pool does not take ownership,
+       * and controllers may not be added while the pool is running.
+       * Warns if the controller uses settings that only Base_Controller::run
+       * honors.
+       * @param  controller  the controller to run
+       **/
+      void add (Base_Controller * controller);
+
+      /**
+       * Gets the number of controllers in the pool
+       * @return the number of controllers
+       **/
+      size_t size (void) const;
+
+      /**
+       * Gets the number of worker threads
+       * @return the number of worker threads
+       **/
+      unsigned int get_num_threads (void) const;
+
+      /**
+       * Runs an iteration of every controller each period until the
+       * maximum runtime is reached. The calling thread schedules the
+       * rounds while the workers run the controllers.
+       * @param  loop_period  time (in seconds) between rounds. 0 runs
+       *                      rounds as fast as possible.
+       * @param  max_runtime  maximum total runtime. Negative runs forever.
+       * @return the number of rounds that were run
+       **/
+      unsigned int run (double loop_period = 0.0, double max_runtime = -1);
+
+      /**
+       * Gets the number of rounds that finished after their deadline
+       * during the last run
+       * @return the number of late rounds
+       **/
+      unsigned int get_overruns (void) const;
+
+      /**
+       * Gets the number of controllers run by a worker other than the
+       * one they were queued on during the last run
+       * @return the number of stolen controller iterations
+       **/
+      unsigned int get_steals (void) const;
+
+      /**
+       * Runs a worker thread
+       * @return 0 on termination
+       **/
+      virtual int svc (void);
+
+    protected:
+      /// a queue of controllers that are due in the current round
+      struct Worker_Queue
+      {
+        /// guard for the queue
+        ACE_Thread_Mutex mutex;
+
+        /// the controllers left in the round
+        std::deque <Base_Controller *> controllers;
+      };
+
+      /**
+       * Takes the next controller from the front of a worker's queue
+       * @param  worker      the index of the worker
+       * @param  controller  the taken controller
+       * @return true if a controller was taken
+       **/
+      bool pop (unsigned int worker, Base_Controller *& controller);
+
+      /**
+       * Takes a controller from the back of another worker's queue
+       * @param  worker      the index of the stealing worker
+       * @param  controller  the stolen controller
+       * @return true if a controller was stolen
+       **/
+      bool steal (unsigned int worker, Base_Controller *& controller);
+
+      /// the controllers in the pool
+      std::vector <Base_Controller *> controllers_;
+
+      /// the queue of each worker
+      std::vector <Worker_Queue *> queues_;
+
+      /// the number of worker threads
+      unsigned int num_threads_;
+
+      /// synchronizes the scheduler and the workers between rounds
+      ACE_Barrier * barrier_;
+
+      /// the index to give to the next started worker
+      ACE_Atomic_Op <ACE_Thread_Mutex, unsigned int> next_worker_;
+
+      /// the number of stolen controller iterations
+      ACE_Atomic_Op <ACE_Thread_Mutex, unsigned int> steals_;
+
+      /// the number of late rounds
+      unsigned int overruns_;
+
+      /// flag for workers to exit after the current round
+      volatile bool terminated_;
+    };
+  }
+}
+
+#endif // _GAMS_CONTROLLERS_CONTROLLER_POOL_H_
@@ -45,12 +45,18 @@
  **/
 
 #include "Mape_Loop.h"
+#include "Change_Watcher.h"
+
+#include "ace/High_Res_Timer.h"
+#include "ace/OS_NS_unistd.h"
+#include "gams/utility/Logging.h"
 
 typedef  Madara::Knowledge_Record::Integer  Integer;
 
 gams::controllers::Mape_Loop::Mape_Loop (
   Madara::Knowledge_Engine::Knowledge_Base & knowledge)
-  : knowledge_ (knowledge)
+  : knowledge_ (knowledge), event_driven_ (false), native_ (false),
+  monitor_ (0), analyze_ (0), plan_ (0), execute_ (0)
 {
   define_mape ();
 }
@@ -70,6 +76,13 @@ gams::controllers::Mape_Loop::define_analyze (
   knowledge_.define_function ("analyze", func);
 }
 
+void
+gams::controllers::Mape_Loop::define_analyze (Native_Function func)
+{
+  analyze_ = func;
+  native_ = true;
+}
+
 void gams::controllers::Mape_Loop::define_execute (
   Madara::Knowledge_Record (*func) (
     Madara::Knowledge_Engine::Function_Arguments &,
@@ -79,11 +92,19 @@ void gams::controllers::Mape_Loop::define_execute (
   knowledge_.define_function ("execute", func);
 }
 
+void
+gams::controllers::Mape_Loop::define_execute (Native_Function func)
+{
+  execute_ = func;
+  native_ = true;
+}
+
 void
 gams::controllers::Mape_Loop::define_mape (const std::string & loop)
 {
   // define the mape loop via KaRL compilation
   mape_loop_ = knowledge_.compile (loop);
+  native_ = false;
 }
 
 void
@@ -96,6 +117,13 @@ gams::controllers::Mape_Loop::define_monitor (
   knowledge_.define_function ("monitor", func);
 }
 
+void
+gams::controllers::Mape_Loop::define_monitor (Native_Function func)
+{
+  monitor_ = func;
+  native_ = true;
+}
+
 void gams::controllers::Mape_Loop::define_plan (
   Madara::Knowledge_Record (*func) (
     Madara::Knowledge_Engine::Function_Arguments &,
@@ -105,6 +133,13 @@ void gams::controllers::Mape_Loop::define_plan (
   knowledge_.define_function ("plan", func);
 }
 
+void
+gams::controllers::Mape_Loop::define_plan (Native_Function func)
+{
+  plan_ = func;
+  native_ = true;
+}
+
 void
 gams::controllers::Mape_Loop::init_vars (
   Madara::Knowledge_Engine::Knowledge_Base & knowledge,
@@ -117,15 +152,127 @@ gams::controllers::Mape_Loop::init_vars (
   self_.init_vars (knowledge, id);
 }
 
+void
+gams::controllers::Mape_Loop::set_event_driven (bool enabled)
+{
+  event_driven_ = enabled;
+}
+
+void
+gams::controllers::Mape_Loop::watch (const std::string & name)
+{
+  watched_.push_back (name);
+}
+
+Madara::Knowledge_Record
+gams::controllers::Mape_Loop::run_once (void)
+{
+  if (!native_)
+    return knowledge_.evaluate (mape_loop_);
+
+  int result (0);
+
+  // phases see a consistent context, like a KaRL evaluation
+  knowledge_.lock ();
+
+  if (monitor_)
+    result |= monitor_ (knowledge_);
+  if (analyze_)
+    result |= analyze_ (knowledge_);
+  if (plan_)
+    result |= plan_ (knowledge_);
+  if (execute_)
+    result |= execute_ (knowledge_);
+
+  knowledge_.unlock ();
+
+  knowledge_.send_modifieds ();
+
+  return Madara::Knowledge_Record (Integer (result));
+}
+
 Madara::Knowledge_Record
 gams::controllers::Mape_Loop::run (double period, double max_runtime)
 {
-  // initialize wait settings
-  Madara::Knowledge_Engine::Wait_Settings  settings;
-  settings.max_wait_time = max_runtime;
-  settings.poll_frequency = period;
+  if (!event_driven_ && !native_)
+  {
+    // initialize wait settings
+    Madara::Knowledge_Engine::Wait_Settings  settings;
+    settings.max_wait_time = max_runtime;
+    settings.poll_frequency = period;
+
+    // wait for the max_runtime or for monitor, analyze, plan, or execute
+    // to return non-zero
+    return knowledge_.wait (mape_loop_, settings);
+  }
+
+  // event-driven and native loops are timed here rather than in a wait
+  Change_Watcher watcher (knowledge_);
+
+  if (event_driven_)
+  {
+    watcher.add (self_.device.command.get_name ());
+    watcher.add (swarm_.command.get_name ());
+
+    for (size_t i = 0; i < watched_.size (); ++i)
+    {
+      watcher.add (watched_[i]);
+    }
+
+    watcher.start ();
+  }
+
+  ACE_Time_Value current = ACE_High_Res_Timer::gettimeofday_hr ();
+  ACE_Time_Value max_wait;
+  max_wait.set (max_runtime);
+  max_wait = current + max_wait;
+
+  Madara::Knowledge_Record result;
+
+  for (;;)
+  {
+    result = run_once ();
+
+    // like wait, stop when monitor, analyze, plan, or execute return
+    // non-zero
+    if (result.is_true ())
+      break;
+
+    current = ACE_High_Res_Timer::gettimeofday_hr ();
+
+    if (max_runtime >= 0 && current >= max_wait)
+      break;
+
+    // in event-driven mode, the period is only a fallback
+    double timeout (period > 0 ? period : (event_driven_ ? -1.0 : 0.0));
+
+    if (max_runtime >= 0)
+    {
+      ACE_Time_Value remaining = max_wait - current;
+      double remaining_seconds =
+        remaining.sec () + remaining.usec () / 1000000.0;
+
+      if (timeout < 0 || remaining_seconds < timeout)
+        timeout = remaining_seconds;
+    }
+
+    if (event_driven_)
+    {
+      GAMS_DEBUG (gams::utility::LOG_DETAILED_TRACE, (LM_DEBUG, 
+        DLINFO "gams::controllers::Mape_Loop::run:" \
+        " waiting up to %f seconds for a change\n", timeout));
+
+      watcher.wait_for_change (timeout);
+    }
+    else if (timeout > 0)
+    {
+      ACE_Time_Value poll;
+      poll.set (timeout);
+      ACE_OS::sleep (poll);
+    }
+  }
+
+  watcher.stop ();
 
-  // wait for the max_runtime or for monitor, analyze, plan, or execute
-  // to return non-zero
-  return knowledge_.wait (mape_loop_, settings);
+  return result;
 }
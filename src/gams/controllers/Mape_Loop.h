@@ -72,6 +72,14 @@ namespace gams
 {
   namespace controllers
   {
+    /**
+     * A MAPE phase implemented in C++ and called without going through
+     * KaRL. Like the KaRL phases, it should return 0 unless the MAPE loop
+     * should stop.
+     **/
+    typedef int (*Native_Function) (
+      Madara::Knowledge_Engine::Knowledge_Base &);
+
     class GAMS_Export Mape_Loop
     {
     public:
@@ -87,7 +95,9 @@ namespace gams
       ~Mape_Loop ();
 
       /**
-       * Defines the MAPE loop
+       * Defines the MAPE loop as a KaRL expression. This also switches the
+       * loop back from native phases to KaRL evaluation.
+       * @param  loop   the KaRL expression to evaluate every iteration
        **/
       void define_mape (const std::string & loop =
         "monitor (); analyze (); plan (); execute ()");
@@ -101,6 +111,13 @@ namespace gams
         Madara::Knowledge_Record (*func) (
           Madara::Knowledge_Engine::Function_Arguments &,
           Madara::Knowledge_Engine::Variables &));
+
+      /**
+       * Defines a native monitor function, which switches the loop to
+       * calling its native phases directly instead of evaluating KaRL.
+       * @param  func   the function to call
+       **/
+      void define_monitor (Native_Function func);
       
       /**
        * Defines the analyze function (the A of MAPE). This function should
@@ -111,6 +128,13 @@ namespace gams
         Madara::Knowledge_Record (*func) (
           Madara::Knowledge_Engine::Function_Arguments &,
           Madara::Knowledge_Engine::Variables &));
+
+      /**
+       * Defines a native analyze function, which switches the loop to
+       * calling its native phases directly instead of evaluating KaRL.
+       * @param  func   the function to call
+       **/
+      void define_analyze (Native_Function func);
       
       /**
        * Defines the plan function (the P of MAPE). This function should
@@ -121,6 +145,13 @@ namespace gams
         Madara::Knowledge_Record (*func) (
           Madara::Knowledge_Engine::Function_Arguments &,
           Madara::Knowledge_Engine::Variables &));
+
+      /**
+       * Defines a native plan function, which switches the loop to
+       * calling its native phases directly instead of evaluating KaRL.
+       * @param  func   the function to call
+       **/
+      void define_plan (Native_Function func);
       
       /**
        * Defines the execute function (the E of MAPE). This function should
@@ -132,6 +163,13 @@ namespace gams
           Madara::Knowledge_Engine::Function_Arguments &,
           Madara::Knowledge_Engine::Variables &));
 
+      /**
+       * Defines a native execute function, which switches the loop to
+       * calling its native phases directly instead of evaluating KaRL.
+       * @param  func   the function to call
+       **/
+      void define_execute (Native_Function func);
+
       /**
        * Initializes global variable containers
        * @param   knowledge  the knowledge base to reference
@@ -142,6 +180,30 @@ namespace gams
         const Madara::Knowledge_Record::Integer & id = 0,
         const Madara::Knowledge_Record::Integer & processes = -1);
 
+      /**
+       * Enables or disables event-driven iterations in run. Instead of
+       * polling every period, the loop runs as soon as a watched variable
+       * changes. The device and swarm command variables are always
+       * watched, and the period becomes the maximum time between
+       * iterations.
+       * @param  enabled   true to wake on changes
+       **/
+      void set_event_driven (bool enabled = true);
+
+      /**
+       * Adds a variable that wakes the loop in event-driven mode
+       * @param  name   the name of the variable (e.g. "device.1.location")
+       **/
+      void watch (const std::string & name);
+
+      /**
+       * Runs a single iteration of the MAPE loop. In native mode, the
+       * defined native phases are called in order while the knowledge base
+       * is locked, and modifications are sent afterwards.
+       * @return  non-zero if any phase asked the loop to stop
+       **/
+      Madara::Knowledge_Record run_once (void);
+
       /**
        * Runs one iteration of the MAPE loop
        * @param  period       time between executions of the loop
@@ -170,6 +232,27 @@ namespace gams
 
       /// Containers for swarm-related variables
       variables::Swarm swarm_;
+
+      /// flag for waking the loop on changes rather than periods
+      bool event_driven_;
+
+      /// variables, besides commands, that wake an event-driven loop
+      std::vector <std::string> watched_;
+
+      /// flag for calling native phases rather than evaluating KaRL
+      bool native_;
+
+      /// native monitor function
+      Native_Function monitor_;
+
+      /// native analyze function
+      Native_Function analyze_;
+
+      /// native plan function
+      Native_Function plan_;
+
+      /// native execute function
+      Native_Function execute_;
     };
   }
 }
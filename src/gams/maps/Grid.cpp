@@ -43,36 +43,460 @@
  *      This material has been approved for public release and unlimited
  *      distribution.
  **/
+
+/**
+ * @file Grid.cpp
+ * @author James Edmondson <jedmondson@gmail.com>
+ *
+ * This file contains the implementation of a tiled grid map with typed cell
+ * layers, neighborhood and line queries, and knowledge base sync of
+ * changed tiles
+ **/
+
 #include "Grid.h"
 
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+#include "gams/utility/Logging.h"
+
 typedef  Madara::Knowledge_Record::Integer  Integer;
 
+namespace
+{
+  /// the names of the layers in knowledge base variables
+  const char * layer_names [gams::maps::NUM_GRID_LAYERS] =
+  {
+    "last_seen", "pheromone", "occupancy", "priority"
+  };
+}
 
-gams::variables::Grid::Grid ()
+gams::maps::Grid::Sent_Tile::Sent_Tile ()
+  : sequence (0)
 {
+  for (int i = 0; i < TILE_CELLS; ++i)
+    cells[i] = 0;
 }
 
-gams::variables::Grid::~Grid ()
+gams::maps::Grid::Grid ()
+  : knowledge_ (0), name_ ("grid")
+{
+}
+
+gams::maps::Grid::~Grid ()
 {
 }
 
 void
-gams::variables::Grid::operator= (const Grid & rhs)
+gams::maps::Grid::operator= (const Grid & rhs)
 {
   if (this != &rhs)
   {
+    this->last_seen = rhs.last_seen;
+    this->pheromone = rhs.pheromone;
+    this->occupancy = rhs.occupancy;
+    this->priority = rhs.priority;
+    this->knowledge_ = rhs.knowledge_;
+    this->name_ = rhs.name_;
+    this->received_ = rhs.received_;
+    this->applied_ = rhs.applied_;
+    this->sent_ = rhs.sent_;
+  }
+}
+
+void
+gams::maps::Grid::init_vars (
+  Madara::Knowledge_Engine::Knowledge_Base & knowledge,
+  const std::string & name)
+{
+  knowledge_ = &knowledge;
+  name_ = name;
+  received_.clear ();
+  applied_.clear ();
+  sent_.clear ();
+}
+
+std::string
+gams::maps::Grid::get_name (void) const
+{
+  return name_;
+}
+
+template <typename T>
+size_t
+gams::maps::Grid::send_layer (Grid_Layer <T> & layer,
+  const std::string & name,
+  const Madara::Knowledge_Engine::Eval_Settings & settings)
+{
+  std::vector <Tile_Id> ids;
+  layer.get_dirty_tiles (ids);
+
+  const Integer self = knowledge_->get (".id").to_integer ();
+
+  std::vector <double> values;
+  for (size_t i = 0; i < ids.size (); ++i)
+  {
+    const typename Grid_Layer <T>::Tile * tile = layer.find_tile (ids[i]);
+
+    std::stringstream buffer;
+    buffer << "grid." << name_ << "." << name << "." <<
+      get_tile_x (ids[i]) / TILE_SIZE << "x" <<
+      get_tile_y (ids[i]) / TILE_SIZE << "." << self;
+
+    Sent_Tile & sent = sent_[buffer.str ()];
+    ++sent.sequence;
+
+    // the record is the send number, one bit mask of written cells per
+    // row, then the value and last changing send of each written cell
+    values.assign (1 + TILE_SIZE, 0.0);
+    values[0] = (double)sent.sequence;
+    for (int j = 0; j < TILE_CELLS; ++j)
+    {
+      if (tile->dirty[j >> 6] & ((uint64_t)1 << (j & 63)))
+        sent.cells[j] = sent.sequence;
+
+      if (sent.cells[j] != 0)
+      {
+        values[1 + (j >> TILE_BITS)] +=
+          (double)(1 << (j & (TILE_SIZE - 1)));
+        values.push_back ((double)tile->values[j]);
+        values.push_back ((double)sent.cells[j]);
+      }
+    }
+
+    knowledge_->set (buffer.str (), values, settings);
+
+    // our own write is not news on the next receive
+    received_[buffer.str ()] = knowledge_->get (buffer.str ()).clock;
   }
+
+  layer.clear_dirty ();
+
+  return ids.size ();
 }
 
+size_t
+gams::maps::Grid::send_tiles (
+  const Madara::Knowledge_Engine::Eval_Settings & settings)
+{
+  if (knowledge_ == 0)
+    return 0;
+
+  size_t result (0);
+
+  // keep the records of all layers consistent with each other
+  knowledge_->lock ();
+  result += send_layer (last_seen, layer_names[LAYER_LAST_SEEN], settings);
+  result += send_layer (pheromone, layer_names[LAYER_PHEROMONE], settings);
+  result += send_layer (occupancy, layer_names[LAYER_OCCUPANCY], settings);
+  result += send_layer (priority, layer_names[LAYER_PRIORITY], settings);
+  knowledge_->unlock ();
+
+  GAMS_DEBUG (gams::utility::LOG_DETAILED_TRACE, (LM_DEBUG, 
+    DLINFO "gams::maps::Grid::send_tiles:" \
+    " wrote %d tile records\n", (int)result));
+
+  return result;
+}
 
+template <typename T>
 void
-gams::variables::Grid::init_vars (
-  Madara::Knowledge_Engine::Knowledge_Base & /*knowledge*/)
+gams::maps::Grid::apply_tile (Grid_Layer <T> & layer, Tile_Id id,
+  const std::vector <double> & values, uint64_t applied, bool keep_max)
 {
+  // received values are not local changes, so the dirty marks stay as is
+  typename Grid_Layer <T>::Tile * tile = layer.get_tile (id);
+
+  size_t next = 1 + TILE_SIZE;
+  for (int j = 0; j < TILE_CELLS; ++j)
+  {
+    const unsigned int mask = (unsigned int)values[1 + (j >> TILE_BITS)];
+    if (!(mask & (1u << (j & (TILE_SIZE - 1)))))
+      continue;
+
+    const T value = (T)values[next];
+    const uint64_t changed = (uint64_t)values[next + 1];
+    next += 2;
+
+    if (keep_max)
+    {
+      if (tile->values[j] < value)
+        tile->values[j] = value;
+    }
+    else if (changed > applied &&
+      !(tile->dirty[j >> 6] & ((uint64_t)1 << (j & 63))))
+    {
+      tile->values[j] = value;
+    }
+  }
+}
+
+size_t
+gams::maps::Grid::receive_tiles (void)
+{
+  if (knowledge_ == 0)
+    return 0;
+
+  size_t result (0);
+  const std::string prefix = "grid." + name_ + ".";
+
+  knowledge_->lock ();
+
+  const Integer self = knowledge_->get (".id").to_integer ();
+
+  std::map <std::string, Madara::Knowledge_Record> records =
+    knowledge_->to_map (prefix);
+
+  for (std::map <std::string, Madara::Knowledge_Record>::iterator i =
+    records.begin (); i != records.end (); ++i)
+  {
+    // skip records that have not changed since the last receive
+    std::map <std::string, uint64_t>::iterator previous =
+      received_.find (i->first);
+    if (previous != received_.end () && previous->second == i->second.clock)
+      continue;
+
+    // the remainder of the name is {layer}.{tile x}x{tile y}.{id}
+    const std::string suffix = i->first.substr (prefix.size ());
+    const std::string::size_type dot = suffix.find ('.');
+    if (dot == std::string::npos)
+      continue;
+
+    const std::string layer = suffix.substr (0, dot);
+    int tile_x, tile_y;
+    long long sender;
+    if (sscanf (suffix.c_str () + dot + 1, "%dx%d.%lld",
+      &tile_x, &tile_y, &sender) != 3 || sender == (long long)self)
+      continue;
+
+    // check that the record holds a value and send for each written cell
+    const std::vector <double> values = i->second.to_doubles ();
+    if (values.size () < (size_t)(1 + TILE_SIZE))
+      continue;
+
+    size_t written (0);
+    for (int row = 0; row < TILE_SIZE; ++row)
+    {
+      for (unsigned int mask = (unsigned int)values[1 + row]; mask;
+        mask &= mask - 1)
+      {
+        ++written;
+      }
+    }
+    if (values.size () != 1 + TILE_SIZE + 2 * written)
+      continue;
+
+    const Tile_Id id = get_tile_id (tile_x * TILE_SIZE, tile_y * TILE_SIZE);
+    const uint64_t applied = applied_[i->first];
+
+    if (layer == layer_names[LAYER_LAST_SEEN])
+      apply_tile (last_seen, id, values, applied, true);
+    else if (layer == layer_names[LAYER_PHEROMONE])
+      apply_tile (pheromone, id, values, applied, false);
+    else if (layer == layer_names[LAYER_OCCUPANCY])
+      apply_tile (occupancy, id, values, applied, false);
+    else if (layer == layer_names[LAYER_PRIORITY])
+      apply_tile (priority, id, values, applied, false);
+    else
+      continue;
+
+    received_[i->first] = i->second.clock;
+    applied_[i->first] = (uint64_t)values[0];
+    ++result;
+  }
+
+  knowledge_->unlock ();
+
+  GAMS_DEBUG (gams::utility::LOG_DETAILED_TRACE, (LM_DEBUG, 
+    DLINFO "gams::maps::Grid::receive_tiles:" \
+    " applied %d tile records\n", (int)result));
+
+  return result;
 }
 
 void
-gams::variables::Grid::init_vars (
-  Madara::Knowledge_Engine::Variables & /*knowledge*/)
+gams::maps::Grid::clear (void)
 {
+  last_seen.clear ();
+  pheromone.clear ();
+  occupancy.clear ();
+  priority.clear ();
+}
+
+void
+gams::maps::Grid::get_neighborhood (int x, int y, double radius,
+  std::vector <utility::Position> & cells)
+{
+  const int extent = (int)floor (radius);
+  const double radius_2 = radius * radius;
+
+  for (int i = -extent; i <= extent; ++i)
+  {
+    for (int j = -extent; j <= extent; ++j)
+    {
+      if (i * i + j * j <= radius_2)
+        cells.push_back (utility::Position (x + i, y + j));
+    }
+  }
+}
+
+void
+gams::maps::Grid::get_line (const utility::Position & start,
+  const utility::Position & end, std::vector <utility::Position> & cells)
+{
+  // supercover line walk between cell centers (Amanatides and Woo)
+  int x = (int)start.x;
+  int y = (int)start.y;
+  const int end_x = (int)end.x;
+  const int end_y = (int)end.y;
+  const int dx = abs (end_x - x);
+  const int dy = abs (end_y - y);
+  const int step_x = end_x > x ? 1 : -1;
+  const int step_y = end_y > y ? 1 : -1;
+
+  cells.push_back (utility::Position (x, y));
+
+  // compare crossings of cell borders in integer units of 1 / (2 dx dy)
+  int64_t error = (int64_t)dx - dy;
+  for (int remaining = dx + dy; remaining > 0; --remaining)
+  {
+    if (error > 0)
+    {
+      x += step_x;
+      error -= 2 * (int64_t)dy;
+    }
+    else if (error < 0)
+    {
+      y += step_y;
+      error += 2 * (int64_t)dx;
+    }
+    else
+    {
+      // the line passes exactly through a cell corner
+      x += step_x;
+      y += step_y;
+      error += 2 * ((int64_t)dx - dy);
+      --remaining;
+    }
+
+    cells.push_back (utility::Position (x, y));
+  }
+}
+
+void
+gams::maps::Grid::get_corridor (const utility::Position & start,
+  const utility::Position & end, double radius,
+  std::vector <utility::Position> & cells)
+{
+  std::vector <Column_Span> spans;
+  get_corridor_spans (start, end, radius, spans);
+
+  for (size_t i = 0; i < spans.size (); ++i)
+  {
+    for (int y = spans[i].min_y; y <= spans[i].max_y; ++y)
+      cells.push_back (utility::Position (spans[i].x, y));
+  }
+}
+
+void
+gams::maps::Grid::get_corridor_spans (const utility::Position & start,
+  const utility::Position & end, double radius,
+  std::vector <Column_Span> & spans)
+{
+  // edges this close to a cell center are settled with the exact test
+  const double EDGE_EPSILON = 1e-6;
+
+  const double ax = start.x, ay = start.y;
+  const double dx = end.x - ax, dy = end.y - ay;
+  const double length = sqrt (dx * dx + dy * dy);
+
+  const int min_x = (int)floor ((dx < 0 ? end.x : ax) - radius);
+  const int max_x = (int)ceil ((dx < 0 ? ax : end.x) + radius);
+
+  for (int x = min_x; x <= max_x; ++x)
+  {
+    // the corridor is convex, so it meets each column in one interval:
+    // the hull of the parts inside both end disks and the band between.
+    // Cells exactly at the radius are outside, so parts that only touch
+    // the column are left out.
+    double low = DBL_MAX, high = -DBL_MAX;
+
+    const double ends[2][2] = { { ax, ay }, { end.x, end.y } };
+    for (int e = 0; e < 2; ++e)
+    {
+      const double offset = x - ends[e][0];
+      if (fabs (offset) < radius)
+      {
+        const double half = sqrt (radius * radius - offset * offset);
+        low = std::min (low, ends[e][1] - half);
+        high = std::max (high, ends[e][1] + half);
+      }
+    }
+
+    if (length > 0 && dx != 0)
+    {
+      // perpendicular distance within the radius
+      const double base = ay + (x - ax) * dy / dx;
+      const double spread = fabs (radius * length / dx);
+      double band_low = base - spread, band_high = base + spread;
+
+      // projection onto the segment between its ends
+      if (dy != 0)
+      {
+        double t_low = ay + (0 - (x - ax) * dx) / dy;
+        double t_high = ay + (length * length - (x - ax) * dx) / dy;
+        if (t_low > t_high)
+          std::swap (t_low, t_high);
+        band_low = std::max (band_low, t_low);
+        band_high = std::min (band_high, t_high);
+      }
+      else if ((x - ax) * dx < 0 || (x - ax) * dx > length * length)
+      {
+        band_low = DBL_MAX;
+        band_high = -DBL_MAX;
+      }
+
+      if (band_low < band_high)
+      {
+        low = std::min (low, band_low);
+        high = std::max (high, band_high);
+      }
+    }
+    else if (length > 0 && fabs (x - ax) < radius)
+    {
+      // a segment along the column
+      low = std::min (low, std::min (ay, end.y));
+      high = std::max (high, std::max (ay, end.y));
+    }
+
+    if (low > high)
+      continue;
+
+    Column_Span span;
+    span.x = x;
+    span.min_y = (int)ceil (low);
+    span.max_y = (int)floor (high);
+
+    // cells on or next to the boundary need the strict distance test
+    if (span.min_y - low < EDGE_EPSILON &&
+      start.distance_to_2d (end, utility::Position (x, span.min_y)) >= radius)
+      ++span.min_y;
+    else if (low - (span.min_y - 1) < EDGE_EPSILON &&
+      start.distance_to_2d (end, utility::Position (x, span.min_y - 1)) < radius)
+      --span.min_y;
+
+    if (high - span.max_y < EDGE_EPSILON &&
+      start.distance_to_2d (end, utility::Position (x, span.max_y)) >= radius)
+      --span.max_y;
+    else if ((span.max_y + 1) - high < EDGE_EPSILON &&
+      start.distance_to_2d (end, utility::Position (x, span.max_y + 1)) < radius)
+      ++span.max_y;
+
+    if (span.min_y <= span.max_y)
+      spans.push_back (span);
+  }
 }
@@ -48,22 +48,366 @@
  * @file Grid.h
  * @author James Edmondson <jedmondson@gmail.com>
  *
- * This file contains the definition of helper functions for grid-based
- * interactions
+ * This file contains the definition of a tiled grid map with typed cell
+ * layers, neighborhood and line queries, and knowledge base sync of
+ * changed tiles
  **/
 
-#ifndef   _GAMS_VARIABLES_GRID_H_
-#define   _GAMS_VARIABLES_GRID_H_
+#ifndef   _GAMS_MAPS_GRID_H_
+#define   _GAMS_MAPS_GRID_H_
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
 
 #include "gams/GAMS_Export.h"
-#include "madara/knowledge_engine/containers/Double.h"
-#include "madara/knowledge_engine/containers/Map.h"
+#include "gams/utility/Position.h"
 #include "madara/knowledge_engine/Knowledge_Base.h"
 
 namespace gams
 {
-  namespace variables
+  namespace maps
   {
+    /// identifies a tile by its tile coordinates
+    typedef int64_t Tile_Id;
+
+    /// the number of bits of a cell index that select a cell within a tile
+    const int TILE_BITS = 4;
+
+    /// the number of cells along each side of a tile
+    const int TILE_SIZE = 1 << TILE_BITS;
+
+    /// the number of cells in a tile
+    const int TILE_CELLS = TILE_SIZE * TILE_SIZE;
+
+    /**
+     * Gets the tile that holds a cell
+     * @param  x   the x index of the cell
+     * @param  y   the y index of the cell
+     * @return the id of the tile
+     **/
+    inline Tile_Id get_tile_id (int x, int y)
+    {
+      // arithmetic shifts keep negative cells in negative tiles
+      return (Tile_Id)(((uint64_t)(uint32_t)(x >> TILE_BITS) << 32) |
+        (uint32_t)(y >> TILE_BITS));
+    }
+
+    /**
+     * Gets the x index of the first cell in a tile
+     * @param  id   the id of the tile
+     * @return the lowest x index in the tile
+     **/
+    inline int get_tile_x (Tile_Id id)
+    {
+      return (int)(id >> 32) * TILE_SIZE;
+    }
+
+    /**
+     * Gets the y index of the first cell in a tile
+     * @param  id   the id of the tile
+     * @return the lowest y index in the tile
+     **/
+    inline int get_tile_y (Tile_Id id)
+    {
+      return (int)(int32_t)(uint32_t)id * TILE_SIZE;
+    }
+
+    /**
+     * Gets the position of a cell within its tile
+     * @param  x   the x index of the cell
+     * @param  y   the y index of the cell
+     * @return the offset of the cell in the tile
+     **/
+    inline int get_tile_cell (int x, int y)
+    {
+      return ((y & (TILE_SIZE - 1)) << TILE_BITS) | (x & (TILE_SIZE - 1));
+    }
+
+    /**
+     * One layer of typed cell values, stored in fixed-size tiles that are
+     * allocated the first time one of their cells is written. Reading a
+     * cell in a missing tile returns the default value. Every write marks
+     * the cell and its tile as dirty until clear_dirty.
+     **/
+    template <typename T>
+    class Grid_Layer
+    {
+    public:
+      /**
+       * The values of one tile
+       **/
+      struct Tile
+      {
+        /// cell values, row by row along x
+        T values[TILE_CELLS];
+
+        /// one bit per cell written since the last clear_dirty
+        uint64_t dirty[TILE_CELLS / 64];
+
+        /// true if any bit of dirty is set
+        bool is_dirty;
+      };
+
+      /// tiles by id
+      typedef std::map <Tile_Id, Tile *> Tile_Map;
+
+      /**
+       * Constructor
+       * @param  default_value   the value of cells that were never written
+       **/
+      Grid_Layer (const T & default_value = T ())
+        : default_ (default_value), last_id_ (0), last_tile_ (0)
+      {
+      }
+
+      /**
+       * Copy constructor
+       * @param  rhs   the layer to copy
+       **/
+      Grid_Layer (const Grid_Layer & rhs)
+        : default_ (rhs.default_), last_id_ (0), last_tile_ (0)
+      {
+        copy_tiles (rhs);
+      }
+
+      /**
+       * Destructor
+       **/
+      ~Grid_Layer ()
+      {
+        clear ();
+      }
+
+      /**
+       * Assignment operator
+       * @param  rhs   values to copy
+       **/
+      void operator= (const Grid_Layer & rhs)
+      {
+        if (this != &rhs)
+        {
+          clear ();
+          default_ = rhs.default_;
+          copy_tiles (rhs);
+        }
+      }
+
+      /**
+       * Gets the value of a cell
+       * @param  x   the x index of the cell
+       * @param  y   the y index of the cell
+       * @return the cell value, or the default if it was never written
+       **/
+      T get (int x, int y) const
+      {
+        const Tile * tile = find_tile (get_tile_id (x, y));
+        return tile ? tile->values[get_tile_cell (x, y)] : default_;
+      }
+
+      /**
+       * Sets the value of a cell and marks it dirty
+       * @param  x       the x index of the cell
+       * @param  y       the y index of the cell
+       * @param  value   the new value
+       **/
+      void set (int x, int y, const T & value)
+      {
+        Tile * tile = get_tile (get_tile_id (x, y));
+        const int cell = get_tile_cell (x, y);
+        tile->values[cell] = value;
+        tile->dirty[cell >> 6] |= (uint64_t)1 << (cell & 63);
+        tile->is_dirty = true;
+      }
+
+      /**
+       * Checks if a cell was written since the last clear_dirty
+       * @param  x   the x index of the cell
+       * @param  y   the y index of the cell
+       * @return true if the cell is marked dirty
+       **/
+      bool is_dirty (int x, int y) const
+      {
+        const Tile * tile = find_tile (get_tile_id (x, y));
+        const int cell = get_tile_cell (x, y);
+        return tile && tile->is_dirty &&
+          (tile->dirty[cell >> 6] >> (cell & 63) & 1);
+      }
+
+      /**
+       * Gets the value of cells that were never written
+       * @return the default value
+       **/
+      const T & get_default (void) const
+      {
+        return default_;
+      }
+
+      /**
+       * Finds an allocated tile
+       * @param  id   the id of the tile
+       * @return the tile, or 0 if it has not been allocated
+       **/
+      const Tile * find_tile (Tile_Id id) const
+      {
+        if (last_tile_ && last_id_ == id)
+          return last_tile_;
+
+        typename Tile_Map::const_iterator found = tiles_.find (id);
+        if (found == tiles_.end ())
+          return 0;
+
+        // consecutive accesses usually fall in the same tile
+        last_id_ = id;
+        last_tile_ = found->second;
+        return last_tile_;
+      }
+
+      /**
+       * Gets a tile, allocating it with default values if needed
+       * @param  id   the id of the tile
+       * @return the tile
+       **/
+      Tile * get_tile (Tile_Id id)
+      {
+        Tile * tile = const_cast <Tile *> (find_tile (id));
+        if (tile == 0)
+        {
+          tile = new Tile;
+          for (int i = 0; i < TILE_CELLS; ++i)
+            tile->values[i] = default_;
+          for (int i = 0; i < TILE_CELLS / 64; ++i)
+            tile->dirty[i] = 0;
+          tile->is_dirty = false;
+
+          tiles_[id] = tile;
+          last_id_ = id;
+          last_tile_ = tile;
+        }
+
+        return tile;
+      }
+
+      /**
+       * Gets all allocated tiles
+       * @return the tiles by id
+       **/
+      const Tile_Map & get_tiles (void) const
+      {
+        return tiles_;
+      }
+
+      /**
+       * Gets the tiles with cells written since the last clear_dirty
+       * @param  ids   list to append the tile ids to
+       **/
+      void get_dirty_tiles (std::vector <Tile_Id> & ids) const
+      {
+        for (typename Tile_Map::const_iterator i = tiles_.begin ();
+          i != tiles_.end (); ++i)
+        {
+          if (i->second->is_dirty)
+            ids.push_back (i->first);
+        }
+      }
+
+      /**
+       * Clears the dirty marks of all cells
+       **/
+      void clear_dirty (void)
+      {
+        for (typename Tile_Map::iterator i = tiles_.begin ();
+          i != tiles_.end (); ++i)
+        {
+          if (i->second->is_dirty)
+          {
+            for (int j = 0; j < TILE_CELLS / 64; ++j)
+              i->second->dirty[j] = 0;
+            i->second->is_dirty = false;
+          }
+        }
+      }
+
+      /**
+       * Deletes all tiles
+       **/
+      void clear (void)
+      {
+        for (typename Tile_Map::iterator i = tiles_.begin ();
+          i != tiles_.end (); ++i)
+        {
+          delete i->second;
+        }
+
+        tiles_.clear ();
+        last_tile_ = 0;
+      }
+
+    protected:
+      /**
+       * Copies the tiles of another layer
+       * @param  rhs   the layer to copy
+       **/
+      void copy_tiles (const Grid_Layer & rhs)
+      {
+        for (typename Tile_Map::const_iterator i = rhs.tiles_.begin ();
+          i != rhs.tiles_.end (); ++i)
+        {
+          tiles_[i->first] = new Tile (*i->second);
+        }
+      }
+
+      /// the tiles that have been written
+      Tile_Map tiles_;
+
+      /// the value of cells that were never written
+      T default_;
+
+      /// the id of the most recently accessed tile
+      mutable Tile_Id last_id_;
+
+      /// the most recently accessed tile
+      mutable Tile * last_tile_;
+    };
+
+    /**
+     * A run of cells in one column of the grid
+     **/
+    struct Column_Span
+    {
+      /// the x index of the column
+      int x;
+
+      /// the lowest y index in the run
+      int min_y;
+
+      /// the highest y index in the run
+      int max_y;
+    };
+
+    /**
+     * The cell layers of a grid map
+     **/
+    enum Grid_Layers
+    {
+      LAYER_LAST_SEEN = 0,
+      LAYER_PHEROMONE = 1,
+      LAYER_OCCUPANCY = 2,
+      LAYER_PRIORITY = 3,
+      NUM_GRID_LAYERS = 4
+    };
+
+    /**
+     * A map of grid cells shared by algorithms and platforms. Cells use the
+     * same integer (x, y) indices as variables::Sensor. Changed cells are
+     * synchronized through the knowledge base as one record per layer, tile
+     * and agent, under grid.{name}.{layer}.{tile x}x{tile y}.{id}. A record
+     * holds every cell of the tile that the agent has written, each with
+     * the number of the send that last changed it, so receivers apply only
+     * the cells that changed since the send they last applied, and a
+     * receiver that misses sends still gets every change.
+     **/
     class GAMS_Export Grid
     {
     public:
@@ -84,18 +428,160 @@ namespace gams
       void operator= (const Grid & rhs);
 
       /**
-       * Initializes variable containers
+       * Initializes the knowledge base used for sync
        * @param   knowledge  the variable context
+       * @param   name       the name of the grid
        **/
-      void init_vars (Madara::Knowledge_Engine::Knowledge_Base & knowledge);
+      void init_vars (Madara::Knowledge_Engine::Knowledge_Base & knowledge,
+        const std::string & name = "grid");
 
       /**
-       * Initializes variable containers
-       * @param   knowledge  the variable context
+       * Gets the name of the grid
+       * @return the name used in knowledge base variables
+       **/
+      std::string get_name (void) const;
+
+      /**
+       * Writes the records of the changed tiles of every layer to the
+       * knowledge base and clears their dirty marks
+       * @param   settings   settings to use for mutating values
+       * @return  the number of tile records written
+       **/
+      size_t send_tiles (
+        const Madara::Knowledge_Engine::Eval_Settings & settings =
+          Madara::Knowledge_Engine::Eval_Settings ());
+
+      /**
+       * Applies the cells of other agents' tile records that changed since
+       * the last call. Cells with unsent local changes keep the local value,
+       * except that the last-seen layer always keeps the latest time of each
+       * cell. Other cells of the same tile are still applied.
+       * @return  the number of tile records applied
+       **/
+      size_t receive_tiles (void);
+
+      /**
+       * Deletes all tiles of every layer
        **/
-      void init_vars (Madara::Knowledge_Engine::Variables & knowledge);
+      void clear (void);
+
+      /**
+       * Gets the cells whose centers are within a radius of a cell
+       * @param  x       the x index of the center cell
+       * @param  y       the y index of the center cell
+       * @param  radius  the radius in cells
+       * @param  cells   list to append the cells to
+       **/
+      static void get_neighborhood (int x, int y, double radius,
+        std::vector <utility::Position> & cells);
+
+      /**
+       * Gets every cell that a line between two cell centers passes
+       * through, in order from start to end
+       * @param  start   the first cell
+       * @param  end     the last cell
+       * @param  cells   list to append the cells to
+       **/
+      static void get_line (const utility::Position & start,
+        const utility::Position & end,
+        std::vector <utility::Position> & cells);
+
+      /**
+       * Gets the cells whose centers are closer than a radius to the segment
+       * between two cells, i.e., where start.distance_to_2d (end, cell) is
+       * less than the radius. Only cells near the segment are examined.
+       * @param  start   the first end of the segment
+       * @param  end     the second end of the segment
+       * @param  radius  the radius in cells
+       * @param  cells   list to append the cells to
+       **/
+      static void get_corridor (const utility::Position & start,
+        const utility::Position & end, double radius,
+        std::vector <utility::Position> & cells);
+
+      /**
+       * Gets the cells of get_corridor as one run per column, which lets
+       * callers sum values over the corridor with column prefix sums
+       * @param  start   the first end of the segment
+       * @param  end     the second end of the segment
+       * @param  radius  the radius in cells
+       * @param  spans   list to append the runs to, by increasing x
+       **/
+      static void get_corridor_spans (const utility::Position & start,
+        const utility::Position & end, double radius,
+        std::vector <Column_Span> & spans);
+
+      /// time of the last observation of each cell
+      Grid_Layer <Madara::Knowledge_Record::Integer> last_seen;
+
+      /// pheromone concentration of each cell
+      Grid_Layer <double> pheromone;
+
+      /// occupancy of each cell (0 for free or unknown)
+      Grid_Layer <unsigned char> occupancy;
+
+      /// search priority of each cell
+      Grid_Layer <double> priority;
+
+    protected:
+      /**
+       * The cells of one tile record that this agent has written
+       **/
+      struct Sent_Tile
+      {
+        /**
+         * Constructor
+         **/
+        Sent_Tile ();
+
+        /// the number of times the record has been sent
+        uint64_t sequence;
+
+        /// the send that last changed each cell, or 0 for unwritten cells
+        uint64_t cells[TILE_CELLS];
+      };
+
+      /**
+       * Writes the changed tiles of one layer
+       * @param  layer      the layer to write
+       * @param  name       the name of the layer
+       * @param  settings   settings to use for mutating values
+       * @return the number of tile records written
+       **/
+      template <typename T>
+      size_t send_layer (Grid_Layer <T> & layer, const std::string & name,
+        const Madara::Knowledge_Engine::Eval_Settings & settings);
+
+      /**
+       * Applies the cells of a received tile record that were changed after
+       * a given send
+       * @param  layer      the layer to update
+       * @param  id         the tile to update
+       * @param  values     the values of the record
+       * @param  applied    the last send of the record that was applied
+       * @param  keep_max   true to keep the larger of local and remote values
+       **/
+      template <typename T>
+      void apply_tile (Grid_Layer <T> & layer, Tile_Id id,
+        const std::vector <double> & values, uint64_t applied,
+        bool keep_max);
+
+      /// knowledge base used for sync
+      Madara::Knowledge_Engine::Knowledge_Base * knowledge_;
+
+      /// name of the grid
+      std::string name_;
+
+      /// the clocks of tile records at the last receive, by variable name
+      std::map <std::string, uint64_t> received_;
+
+      /// the last send applied from each remote record, by variable name
+      std::map <std::string, uint64_t> applied_;
+
+      /// the cells written to each of our own records, by variable name
+      std::map <std::string, Sent_Tile> sent_;
     };
   }
 }
 
-#endif // _GAMS_VARIABLES_GRID_H_
+#endif // _GAMS_MAPS_GRID_H_
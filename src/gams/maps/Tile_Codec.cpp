@@ -0,0 +1,171 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+/**
+ * @file Tile_Codec.cpp
+ * @author James Edmondson <jedmondson@gmail.com>
+ *
+ * This file contains a compact binary encoding of the changed cells of a
+ * grid layer, for sending many cell updates as one knowledge record
+ **/
+
+#include "Tile_Codec.h"
+
+#include <cmath>
+
+void
+gams::maps::encode_varint (uint64_t value,
+  std::vector <unsigned char> & buffer)
+{
+  while (value >= 0x80)
+  {
+    buffer.push_back ((unsigned char)(value | 0x80));
+    value >>= 7;
+  }
+  buffer.push_back ((unsigned char)value);
+}
+
+bool
+gams::maps::decode_varint (const unsigned char *& current,
+  const unsigned char * end, uint64_t & value)
+{
+  value = 0;
+  for (int shift = 0; current < end && shift < 64; shift += 7)
+  {
+    const unsigned char byte = *current++;
+    value |= (uint64_t)(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0)
+      return true;
+  }
+
+  return false;
+}
+
+size_t
+gams::maps::encode_changes (const Grid_Layer <double> & layer,
+  double scale, std::vector <unsigned char> & buffer)
+{
+  std::vector <Tile_Id> ids;
+  layer.get_dirty_tiles (ids);
+
+  buffer.push_back (TILE_CODEC_VERSION);
+  encode_varint (ids.size (), buffer);
+
+  size_t cells (0);
+  int64_t previous (0);
+  for (size_t i = 0; i < ids.size (); ++i)
+  {
+    const Grid_Layer <double>::Tile * tile = layer.find_tile (ids[i]);
+
+    encode_varint (zigzag_encode (get_tile_x (ids[i]) / TILE_SIZE), buffer);
+    encode_varint (zigzag_encode (get_tile_y (ids[i]) / TILE_SIZE), buffer);
+
+    for (int j = 0; j < TILE_CELLS / 64; ++j)
+      for (int k = 0; k < 64; k += 8)
+        buffer.push_back ((unsigned char)(tile->dirty[j] >> k));
+
+    for (int j = 0; j < TILE_CELLS; ++j)
+    {
+      if (tile->dirty[j >> 6] >> (j & 63) & 1)
+      {
+        const int64_t current =
+          (int64_t)floor (tile->values[j] * scale + 0.5);
+        encode_varint (zigzag_encode (current - previous), buffer);
+        previous = current;
+        ++cells;
+      }
+    }
+  }
+
+  return cells;
+}
+
+int
+gams::maps::decode_changes (const unsigned char * data, size_t size,
+  double scale, Grid_Layer <double> & layer)
+{
+  const unsigned char * current = data;
+  const unsigned char * end = data + size;
+
+  uint64_t tiles;
+  if (size == 0 || *current++ != TILE_CODEC_VERSION ||
+    !decode_varint (current, end, tiles))
+    return -1;
+
+  int cells (0);
+  int64_t previous (0);
+  for (uint64_t i = 0; i < tiles; ++i)
+  {
+    uint64_t tile_x, tile_y;
+    if (!decode_varint (current, end, tile_x) ||
+      !decode_varint (current, end, tile_y) ||
+      end - current < TILE_CELLS / 8)
+      return -1;
+
+    const int min_x = (int)zigzag_decode (tile_x) * TILE_SIZE;
+    const int min_y = (int)zigzag_decode (tile_y) * TILE_SIZE;
+
+    const unsigned char * bitmap = current;
+    current += TILE_CELLS / 8;
+
+    for (int j = 0; j < TILE_CELLS; ++j)
+    {
+      if (bitmap[j >> 3] >> (j & 7) & 1)
+      {
+        uint64_t delta;
+        if (!decode_varint (current, end, delta))
+          return -1;
+
+        previous += zigzag_decode (delta);
+        layer.set (min_x + (j & (TILE_SIZE - 1)), min_y + (j >> TILE_BITS),
+          previous / scale);
+        ++cells;
+      }
+    }
+  }
+
+  return cells;
+}
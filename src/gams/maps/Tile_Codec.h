@@ -0,0 +1,140 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+/**
+ * @file Tile_Codec.h
+ * @author James Edmondson <jedmondson@gmail.com>
+ *
+ * This file contains a compact binary encoding of the changed cells of a
+ * grid layer, for sending many cell updates as one knowledge record
+ **/
+
+#ifndef   _GAMS_MAPS_TILE_CODEC_H_
+#define   _GAMS_MAPS_TILE_CODEC_H_
+
+#include <vector>
+#include <stdint.h>
+
+#include "gams/GAMS_Export.h"
+#include "gams/maps/Grid.h"
+
+namespace gams
+{
+  namespace maps
+  {
+    /// the version byte at the start of an encoded change set
+    const unsigned char TILE_CODEC_VERSION = 1;
+
+    /**
+     * Maps a signed integer onto an unsigned one so that values of small
+     * magnitude have few significant bits
+     * @param  value   the signed value
+     * @return the zigzag encoded value
+     **/
+    inline uint64_t zigzag_encode (int64_t value)
+    {
+      return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    }
+
+    /**
+     * Inverts zigzag_encode
+     * @param  value   the zigzag encoded value
+     * @return the signed value
+     **/
+    inline int64_t zigzag_decode (uint64_t value)
+    {
+      return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+    }
+
+    /**
+     * Appends an unsigned integer in 7 bit groups, low group first, with
+     * the high bit of each byte marking that more bytes follow
+     * @param  value    the value to encode
+     * @param  buffer   the buffer to append to
+     **/
+    GAMS_Export void encode_varint (uint64_t value,
+      std::vector <unsigned char> & buffer);
+
+    /**
+     * Reads an integer written by encode_varint
+     * @param  current  the read position, advanced past the value
+     * @param  end      the end of the buffer
+     * @param  value    the decoded value
+     * @return false if the buffer ends before the value does
+     **/
+    GAMS_Export bool decode_varint (const unsigned char *& current,
+      const unsigned char * end, uint64_t & value);
+
+    /**
+     * Encodes the dirty cells of a layer. The format is a version byte and
+     * the number of tiles, followed for each dirty tile by its zigzag tile
+     * coordinates, a 32 byte bitmap of the changed cells, and one zigzag
+     * varint per changed cell. Values are rounded to multiples of 1 / scale
+     * and each is stored as the difference from the previous value, so runs
+     * of cells marked with the same time cost a byte each.
+     * @param  layer    the layer with cells marked dirty
+     * @param  scale    the number of encoded steps per unit of value
+     * @param  buffer   the buffer to write the encoding to
+     * @return the number of cells encoded
+     **/
+    GAMS_Export size_t encode_changes (const Grid_Layer <double> & layer,
+      double scale, std::vector <unsigned char> & buffer);
+
+    /**
+     * Decodes cells written by encode_changes into a layer. Each decoded
+     * cell is set, and so marked dirty, in the layer.
+     * @param  data     the encoded changes
+     * @param  size     the number of bytes in data
+     * @param  scale    the scale the changes were encoded with
+     * @param  layer    the layer to write the cells to
+     * @return the number of cells decoded, or -1 if data is malformed
+     **/
+    GAMS_Export int decode_changes (const unsigned char * data, size_t size,
+      double scale, Grid_Layer <double> & layer);
+  }
+}
+
+#endif // _GAMS_MAPS_TILE_CODEC_H_
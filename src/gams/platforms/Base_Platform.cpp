@@ -57,7 +57,8 @@ gams::platforms::Base_Platform::Base_Platform (
   Madara::Knowledge_Engine::Knowledge_Base * knowledge,
   variables::Sensors * sensors,
   variables::Self * self)
-  : knowledge_ (knowledge), self_ (self), sensors_ (sensors)
+  : knowledge_ (knowledge), self_ (self), sensors_ (sensors),
+  clock_ (utility::default_clock ())
 {
 }
 
@@ -74,6 +75,7 @@ gams::platforms::Base_Platform::operator= (const Base_Platform & rhs)
     this->sensors_ = rhs.sensors_;
     this->status_ = rhs.status_;
     this->self_ = rhs.self_;
+    this->clock_ = rhs.clock_;
   }
 }
 
@@ -270,3 +272,15 @@ gams::platforms::Base_Platform::get_platform_status (void)
 {
   return &status_;
 }
+
+void
+gams::platforms::Base_Platform::set_clock (utility::Clock * clock)
+{
+  clock_ = clock ? clock : utility::default_clock ();
+}
+
+gams::utility::Clock *
+gams::platforms::Base_Platform::get_clock (void)
+{
+  return clock_;
+}
@@ -61,6 +61,7 @@
 #include "gams/variables/Platform_Status.h"
 #include "gams/utility/GPS_Position.h"
 #include "gams/utility/Axes.h"
+#include "gams/utility/Clock.h"
 #include "madara/knowledge_engine/Knowledge_Base.h"
 
 namespace gams
@@ -263,6 +264,20 @@ namespace gams
        **/
       variables::Platform_Status * get_platform_status (void);
 
+      /**
+       * Sets the clock the platform should read time from
+       * @param  clock     the clock. 0 uses the real time clock.
+       **/
+      virtual void set_clock (utility::Clock * clock);
+
+      /**
+       * Gets the clock of the controller running the platform. Use this
+       * instead of the system time so the platform also works in
+       * simulated time.
+       * @return the clock
+       **/
+      utility::Clock * get_clock (void);
+
     protected:
       /// movement speed for platform in meters/second
       double move_speed_;
@@ -278,6 +293,9 @@ namespace gams
 
       /// provides access to status information for this platform
       variables::Platform_Status status_;
+
+      /// the source of time
+      utility::Clock * clock_;
     };
 
     // deprecated typdef. Please use Base_Platform instead.
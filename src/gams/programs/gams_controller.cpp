@@ -58,6 +58,8 @@ using std::endl;
 #include "madara/knowledge_engine/Knowledge_Base.h"
 #include "gams/controllers/Base_Controller.h"
 #include "gams/utility/Logging.h"
+#include "gams/utility/Clock.h"
+#include "gams/utility/Trace_Buffer.h"
 
 const std::string default_broadcast ("192.168.1.255:15000");
 // default transport settings
@@ -74,10 +76,20 @@ typedef Record::Integer Integer;
 std::string platform ("debug");
 std::string algorithm ("debug");
 std::vector <std::string> accents;
+unsigned int accent_threads (0);
+bool async_send (false);
+bool event_driven (false);
+std::vector <std::string> watched;
+bool virtual_clock (false);
+bool algorithm_cache (false);
 
 // controller variables
 double period (1.0);
 double loop_time (50.0);
+int overrun_policy (controllers::OVERRUN_CATCH_UP);
+int execution_model (controllers::EXECUTION_LOCKED);
+bool profile (false);
+std::string trace_file;
 
 // madara commands from a file
 std::string madara_commands = "";
@@ -95,9 +107,18 @@ void print_usage (char* prog_name)
 "     Loop controller setup for gams\n" \
 " [-A |--algorithm type]        algorithm to start with\n" \
 " [-a |--accent type]           accent algorithm to start with\n" \
+" [--accent-threads threads]    threads for running non-conflicting accents\n" \
+"                               concurrently (def:0, in sequence)\n" \
+" [--algorithm-cache]           keep replaced algorithms for reactivation\n" \
+" [--async-send]                send updates from a separate thread\n" \
 " [-b |--broadcast ip:port]     the broadcast ip to send and listen to\n" \
 " [-d |--domain domain]         the knowledge domain to send and listen to\n" \
 " [-e |--rebroadcasts num]      number of hops for rebroadcasting messages\n" \
+" [--event-driven]              run iterations when commands or watched\n" \
+"                               variables change, with the period as the\n" \
+"                               maximum time between iterations\n" \
+" [--execution-model model]     knowledge base locking during an iteration\n" \
+"                               (locked or unlocked-io, def:locked)\n" \
 " [-f |--logfile file]          log to a file\n" \
 " [-i |--id id]                 the id of this agent (should be non-negative)\n" \
 " [--madara-level level]        the MADARA logger level (0+, higher is higher detail)\n" \
@@ -108,12 +129,21 @@ void print_usage (char* prog_name)
 "                               multiple space-delimited files can be used\n" \
 " [-n |--num_agents <number>]   the number of agents in the swarm\n" \
 " [-o |--host hostname]         the hostname of this process (def:localhost)\n" \
+" [--overrun-policy policy]     handling of late loop iterations\n" \
+"                               (catch-up or skip, def:catch-up)\n" \
 " [-p |--platform type]         platform for loop (vrep, dronerk)\n" \
+" [--profile]                   record per-phase loop latencies and print\n" \
+"                               them on exit\n" \
 " [-P |--period period]         time, in seconds, between control loop executions\n" \
 " [-q |--queue-length length]   length of transport queue in bytes\n" \
 " [-r |--reduced]               use the reduced message header\n" \
 " [-t |--target path]           file system location to save received files (NYI)\n" \
+" [--trace file]                record binary trace events and write them\n" \
+"                               to a file on exit (see gams_trace)\n" \
 " [-u |--udp ip:port]           a udp ip to send to (first is self to bind to)\n" \
+" [--virtual-clock]             step the loop in simulated time without\n" \
+"                               sleeping (requires a positive period)\n" \
+" [--watch variable]            a variable that wakes an event-driven loop\n" \
 "\n",
         prog_name));
   exit (0);
@@ -144,6 +174,26 @@ void handle_arguments (int argc, char ** argv)
 
       ++i;
     }
+    else if (arg1 == "--algorithm-cache")
+    {
+      algorithm_cache = true;
+    }
+    else if (arg1 == "--accent-threads")
+    {
+      if (i + 1 < argc && argv[i + 1][0] != '-')
+      {
+        std::stringstream buffer (argv[i + 1]);
+        buffer >> accent_threads;
+      }
+      else
+        print_usage (argv[0]);
+
+      ++i;
+    }
+    else if (arg1 == "--async-send")
+    {
+      async_send = true;
+    }
     else if (arg1 == "-b" || arg1 == "--broadcast")
     {
       if (i + 1 < argc && argv[i + 1][0] != '-')
@@ -181,6 +231,10 @@ void handle_arguments (int argc, char ** argv)
 
       ++i;
     }
+    else if (arg1 == "--event-driven")
+    {
+      event_driven = true;
+    }
     else if (arg1 == "-f" || arg1 == "--logfile")
     {
       if (i + 1 < argc && argv[i + 1][0] != '-')
@@ -287,6 +341,42 @@ void handle_arguments (int argc, char ** argv)
 
       ++i;
     }
+    else if (arg1 == "--execution-model")
+    {
+      if (i + 1 < argc && argv[i + 1][0] != '-')
+      {
+        std::string model (argv[i + 1]);
+
+        if (model == "unlocked-io")
+          execution_model = controllers::EXECUTION_UNLOCKED_IO;
+        else if (model == "locked")
+          execution_model = controllers::EXECUTION_LOCKED;
+        else
+          print_usage (argv[0]);
+      }
+      else
+        print_usage (argv[0]);
+
+      ++i;
+    }
+    else if (arg1 == "--overrun-policy")
+    {
+      if (i + 1 < argc && argv[i + 1][0] != '-')
+      {
+        std::string policy (argv[i + 1]);
+
+        if (policy == "skip")
+          overrun_policy = controllers::OVERRUN_SKIP;
+        else if (policy == "catch-up")
+          overrun_policy = controllers::OVERRUN_CATCH_UP;
+        else
+          print_usage (argv[0]);
+      }
+      else
+        print_usage (argv[0]);
+
+      ++i;
+    }
     else if (arg1 == "-p" || arg1 == "--platform")
     {
       if (i + 1 < argc && argv[i + 1][0] != '-')
@@ -296,6 +386,19 @@ void handle_arguments (int argc, char ** argv)
 
       ++i;
     }
+    else if (arg1 == "--trace")
+    {
+      if (i + 1 < argc && argv[i + 1][0] != '-')
+        trace_file = argv[i + 1];
+      else
+        print_usage (argv[0]);
+
+      ++i;
+    }
+    else if (arg1 == "--profile")
+    {
+      profile = true;
+    }
     else if (arg1 == "-P" || arg1 == "--period")
     {
       if (i + 1 < argc && argv[i + 1][0] != '-')
@@ -345,11 +448,32 @@ void handle_arguments (int argc, char ** argv)
 
       ++i;
     }
+    else if (arg1 == "--virtual-clock")
+    {
+      virtual_clock = true;
+    }
+    else if (arg1 == "--watch")
+    {
+      if (i + 1 < argc && argv[i + 1][0] != '-')
+        watched.push_back (argv[i + 1]);
+      else
+        print_usage (argv[0]);
+
+      ++i;
+    }
     else
     {
       print_usage (argv[0]);
     }
   }
+
+  // simulated time only moves to the deadlines of a positive period
+  if (virtual_clock && period <= 0)
+  {
+    MADARA_DEBUG (MADARA_LOG_EMERGENCY, (LM_DEBUG, 
+      "--virtual-clock requires a positive --period\n"));
+    print_usage (argv[0]);
+  }
 }
 
 // perform main logic of program
@@ -358,8 +482,15 @@ int main (int argc, char ** argv)
   // handle all user arguments
   handle_arguments (argc, argv);
   
+  // with async sends, the sender owns the transport so that sends never
+  // hold the knowledge base lock
+  Madara::Transport::QoS_Transport_Settings knowledge_settings (settings);
+  if (async_send)
+    knowledge_settings.type = Madara::Transport::NO_TRANSPORT;
+
   // create knowledge base and a control loop
-  Madara::Knowledge_Engine::Knowledge_Base knowledge (host, settings);
+  Madara::Knowledge_Engine::Knowledge_Base knowledge (host,
+    knowledge_settings);
   controllers::Base_Controller loop (knowledge);
 
   // initialize variables and function stubs
@@ -373,6 +504,7 @@ int main (int argc, char ** argv)
   }
 
   // initialize the platform and algorithm
+  loop.set_algorithm_caching (algorithm_cache);
   loop.init_platform (platform);
   loop.init_algorithm (algorithm);
 
@@ -383,10 +515,39 @@ int main (int argc, char ** argv)
   }
 
   // run a mape loop every 1s for 50s
+  loop.set_overrun_policy (overrun_policy);
+  loop.set_execution_model (execution_model);
+  loop.set_accent_threads (accent_threads);
+  loop.set_async_send (async_send, settings);
+  loop.set_event_driven (event_driven);
+
+  for (unsigned int i = 0; i < watched.size (); ++i)
+  {
+    loop.watch (watched[i]);
+  }
+
+  // in simulated time, the loop jumps to every deadline
+  gams::utility::Virtual_Clock clock;
+  if (virtual_clock)
+    loop.set_clock (&clock);
+
+  loop.enable_profiling (profile);
+  gams::utility::enable_tracing (trace_file != "");
   loop.run (period, loop_time);
+  gams::utility::enable_tracing (false);
 
   // print all knowledge values
   knowledge.print ();
 
+  if (profile)
+  {
+    std::cerr << "\nMAPE phase latencies:\n" << loop.profile_to_string ();
+  }
+
+  if (trace_file != "")
+  {
+    gams::utility::dump_trace (trace_file);
+  }
+
   return 0;
 }
@@ -0,0 +1,410 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+/**
+ * @file gams_swarm.cpp
+ * @author James Edmondson <jedmondson@gmail.com>
+ *
+ * This file contains a driver that runs many GAMS controllers, each with
+ * its own knowledge base and id, in a single process.
+ **/
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+using std::cerr;
+using std::endl;
+
+#include "madara/knowledge_engine/Knowledge_Base.h"
+#include "gams/controllers/Base_Controller.h"
+#include "gams/controllers/Controller_Pool.h"
+#include "gams/utility/Logging.h"
+
+// default transport settings
+std::string host ("");
+Madara::Transport::QoS_Transport_Settings settings;
+
+// create shortcuts to MADARA classes and namespaces
+namespace engine = Madara::Knowledge_Engine;
+namespace controllers = gams::controllers;
+typedef Madara::Knowledge_Record   Record;
+typedef Record::Integer Integer;
+
+std::string platform ("debug");
+std::string algorithm ("debug");
+
+// controller variables
+double period (1.0);
+double loop_time (50.0);
+
+// pool variables
+unsigned int num_threads (0);
+
+// madara commands from a file
+std::string madara_commands = "";
+
+// number of agents to run in this process
+Integer num_agents (100);
+
+void print_usage (char* prog_name)
+{
+      MADARA_DEBUG (MADARA_LOG_EMERGENCY, (LM_DEBUG, 
+"\nProgram summary for %s:\n\n" \
+"     Runs many gams controllers in one process\n" \
+" [-A |--algorithm type]        algorithm to start with\n" \
+" [-b |--broadcast ip:port]     the broadcast ip to send and listen to\n" \
+" [-d |--domain domain]         the knowledge domain to send and listen to\n" \
+" [-i |--id id]                 the id of the first agent (def:0)\n" \
+" [--madara-level level]        the MADARA logger level (0+, higher is higher detail)\n" \
+" [--gams-level level]          the GAMS logger level (0+, higher is higher detail)\n" \
+" [-L |--loop-time time]        time to execute loop\n"\
+" [-m |--multicast ip:port]     the multicast ip to send and listen to\n" \
+" [-M |--madara-file <file>]    file containing madara commands to execute\n" \
+"                               on every agent\n" \
+" [-n |--num_agents <number>]   the number of agents to run (def:100)\n" \
+" [-o |--host hostname]         the hostname of this process (def:localhost)\n" \
+" [-p |--platform type]         platform for loop (vrep, dronerk)\n" \
+" [-P |--period period]         time, in seconds, between control loop executions\n" \
+" [-t |--threads threads]       worker threads (def:number of processors)\n" \
+" [-u |--udp ip:port]           a udp ip to send to (first is self to bind to).\n" \
+"                               Agent i binds to the first port plus i and\n" \
+"                               sends to the ports of the other agents\n" \
+"\n",
+        prog_name));
+  exit (0);
+}
+
+// handle command line arguments
+void handle_arguments (int argc, char ** argv)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg1 (argv[i]);
+
+    if (arg1 == "-A" || arg1 == "--algorithm")
+    {
+      if (i + 1 < argc && argv[i + 1][0] != '-')
+        algorithm = argv[i + 1];
+      else
+        print_usage (argv[0]);
+
+      ++i;
+    }
+    else if (arg1 == "-b" || arg1 == "--broadcast")
+    {
+      if (i + 1 < argc && argv[i + 1][0] != '-')
+      {
+        settings.hosts.push_back (argv[i + 1]);
+        settings.type = Madara::Transport::BROADCAST;
+      }
+      else
+        print_usage (argv[0]);
+
+      ++i;
+    }
+    else if (arg1 == "-d" || arg1 == "--domain")
+    {
+      if (i + 1 < argc && argv[i + 1][0] != '-')
+        settings.domains = argv[i + 1];
+      else
+        print_usage (argv[0]);
+
+      ++i;
+    }
+    else if (arg1 == "-i" || arg1 == "--id")
+    {
+      if (i + 1 < argc && argv[i +1][0] != '-')
+      {
+        std::stringstream buffer (argv[i + 1]);
+        buffer >> settings.id;
+      }
+      else
+        print_usage (argv[0]);
+
+      ++i;
+    }
+    else if (arg1 == "--madara-level")
+    {
+      if (i + 1 < argc && argv[i + 1][0] != '-')
+      {
+        std::stringstream buffer (argv[i + 1]);
+        buffer >> MADARA_debug_level;
+      }
+      else
+        print_usage (argv[0]);
+
+      ++i;
+    }
+    else if (arg1 == "--gams-level")
+    {
+      if (i + 1 < argc && argv[i + 1][0] != '-')
+      {
+        std::stringstream buffer (argv[i + 1]);
+        buffer >> GAMS_debug_level;
+      }
+      else
+        print_usage (argv[0]);
+
+      ++i;
+    }
+    else if (arg1 == "-L" || arg1 == "--loop-time")
+    {
+      if (i + 1 < argc && argv[i + 1][0] != '-')
+      {
+        std::stringstream buffer (argv[i + 1]);
+        buffer >> loop_time;
+      }
+      else
+        print_usage (argv[0]);
+
+      ++i;
+    }
+    else if (arg1 == "-m" || arg1 == "--multicast")
+    {
+      if (i + 1 < argc && argv[i + 1][0] != '-')
+      {
+        settings.hosts.push_back (argv[i + 1]);
+        settings.type = Madara::Transport::MULTICAST;
+      }
+      else
+        print_usage (argv[0]);
+
+      ++i;
+    }
+    else if (arg1 == "-M" || arg1 == "--madara-file")
+    {
+      bool files = false;
+      ++i;
+      for (;i < argc && argv[i][0] != '-'; ++i)
+      {
+        madara_commands += Madara::Utility::file_to_string (argv[i]);
+        madara_commands += ";\r\n";
+        files = true;
+      }
+      --i;
+
+      if (!files)
+        print_usage (argv[0]);
+    }
+    else if (arg1 == "-n" || arg1 == "--num_agents")
+    {
+      if (i + 1 < argc && argv[i + 1][0] != '-')
+      {
+        std::stringstream buffer (argv[i + 1]);
+        buffer >> num_agents;
+      }
+      else
+        print_usage (argv[0]);
+
+      ++i;
+    }
+    else if (arg1 == "-o" || arg1 == "--host")
+    {
+      if (i + 1 < argc && argv[i + 1][0] != '-')
+        host = argv[i + 1];
+      else
+        print_usage (argv[0]);
+
+      ++i;
+    }
+    else if (arg1 == "-p" || arg1 == "--platform")
+    {
+      if (i + 1 < argc && argv[i + 1][0] != '-')
+        platform = argv[i + 1];
+      else
+        print_usage (argv[0]);
+
+      ++i;
+    }
+    else if (arg1 == "-P" || arg1 == "--period")
+    {
+      if (i + 1 < argc && argv[i + 1][0] != '-')
+      {
+        std::stringstream buffer (argv[i + 1]);
+        buffer >> period;
+      }
+      else
+        print_usage (argv[0]);
+
+      ++i;
+    }
+    else if (arg1 == "-t" || arg1 == "--threads")
+    {
+      if (i + 1 < argc && argv[i + 1][0] != '-')
+      {
+        std::stringstream buffer (argv[i + 1]);
+        buffer >> num_threads;
+      }
+      else
+        print_usage (argv[0]);
+
+      ++i;
+    }
+    else if (arg1 == "-u" || arg1 == "--udp")
+    {
+      if (i + 1 < argc && argv[i + 1][0] != '-')
+      {
+        settings.hosts.push_back (argv[i + 1]);
+        settings.type = Madara::Transport::UDP;
+      }
+      else
+        print_usage (argv[0]);
+
+      ++i;
+    }
+    else
+    {
+      print_usage (argv[0]);
+    }
+  }
+}
+
+/**
+ * Gives an agent its own UDP port, since only one socket can bind to each.
+ * Agent i binds to the first host's port plus i and sends to the ports of
+ * the other agents, followed by any other hosts given on the command line.
+ * @param  index   the index of the agent in this process
+ * @param  hosts   the hosts given on the command line
+ * @param  result  the hosts of the agent
+ * @return false if the first host has no valid port
+ **/
+bool get_udp_hosts (Integer index, const std::vector <std::string> & hosts,
+  std::vector <std::string> & result)
+{
+  const std::string::size_type colon = hosts[0].rfind (':');
+  if (colon == std::string::npos)
+    return false;
+
+  const std::string ip = hosts[0].substr (0, colon);
+  std::stringstream buffer (hosts[0].substr (colon + 1));
+  Integer port;
+  if (!(buffer >> port) || port <= 0 || port + num_agents - 1 > 65535)
+    return false;
+
+  result.clear ();
+  for (Integer i = -1; i < num_agents; ++i)
+  {
+    // our own port comes first, so the transport binds to it
+    if (i == index)
+      continue;
+
+    std::stringstream agent_host;
+    agent_host << ip << ":" << port + (i < 0 ? index : i);
+    result.push_back (agent_host.str ());
+  }
+
+  result.insert (result.end (), hosts.begin () + 1, hosts.end ());
+
+  return true;
+}
+
+// perform main logic of program
+int main (int argc, char ** argv)
+{
+  // handle all user arguments
+  handle_arguments (argc, argv);
+
+  const std::vector <std::string> hosts = settings.hosts;
+  if (settings.type == Madara::Transport::UDP &&
+    !get_udp_hosts (0, hosts, settings.hosts))
+  {
+    cerr << "ERROR: the first udp host needs a port for each of the " <<
+      num_agents << " agents\n";
+    return -1;
+  }
+
+  std::vector <engine::Knowledge_Base *> knowledge_bases;
+  std::vector <controllers::Base_Controller *> loops;
+  controllers::Controller_Pool pool (num_threads);
+
+  const Integer first_id = settings.id;
+
+  // each agent gets its own knowledge base and id
+  for (Integer i = 0; i < num_agents; ++i)
+  {
+    settings.id = (uint32_t)(first_id + i);
+
+    if (settings.type == Madara::Transport::UDP)
+      get_udp_hosts (i, hosts, settings.hosts);
+
+    engine::Knowledge_Base * knowledge =
+      new engine::Knowledge_Base (host, settings);
+    controllers::Base_Controller * loop =
+      new controllers::Base_Controller (*knowledge);
+
+    loop->init_vars (settings.id, num_agents);
+
+    if (madara_commands != "")
+    {
+      knowledge->evaluate (madara_commands,
+        Madara::Knowledge_Engine::Eval_Settings(false, true));
+    }
+
+    loop->init_platform (platform);
+    loop->init_algorithm (algorithm);
+
+    knowledge_bases.push_back (knowledge);
+    loops.push_back (loop);
+    pool.add (loop);
+  }
+
+  cerr << "Running " << num_agents << " agents on " <<
+    pool.get_num_threads () << " threads for " << loop_time << "s\n";
+
+  unsigned int rounds = pool.run (period, loop_time);
+
+  cerr << "Finished " << rounds << " rounds with " << pool.get_overruns () <<
+    " overruns and " << pool.get_steals () << " steals\n";
+
+  // controllers must be deleted before the knowledge bases they reference
+  for (size_t i = 0; i < loops.size (); ++i)
+  {
+    delete loops[i];
+    delete knowledge_bases[i];
+  }
+
+  return 0;
+}
@@ -0,0 +1,154 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+/**
+ * @file gams_trace.cpp
+ * @author James Edmondson <jedmondson@gmail.com>
+ *
+ * This file contains a tool that decodes binary trace files written by
+ * gams::utility::dump_trace.
+ **/
+
+#include <iostream>
+#include <cstdlib>
+#include <iomanip>
+#include <map>
+#include <string>
+#include <vector>
+using std::cerr;
+using std::cout;
+using std::endl;
+
+#include "gams/utility/Trace_Buffer.h"
+
+// the trace file to decode
+std::string filename;
+
+// print a count of events per label instead of the events
+bool summary (false);
+
+void print_usage (char* prog_name)
+{
+  cerr << "\nProgram summary for " << prog_name << ":\n\n" \
+"     Decodes a gams binary trace file\n" \
+" [-f |--file file]             the trace file to decode\n" \
+" [-s |--summary]               print event counts per label\n" \
+"\n";
+  exit (0);
+}
+
+// handle command line arguments
+void handle_arguments (int argc, char ** argv)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg1 (argv[i]);
+
+    if (arg1 == "-f" || arg1 == "--file")
+    {
+      if (i + 1 < argc)
+        filename = argv[i + 1];
+      else
+        print_usage (argv[0]);
+
+      ++i;
+    }
+    else if (arg1 == "-s" || arg1 == "--summary")
+    {
+      summary = true;
+    }
+    else if (filename == "" && arg1[0] != '-')
+    {
+      filename = arg1;
+    }
+    else
+    {
+      print_usage (argv[0]);
+    }
+  }
+
+  if (filename == "")
+    print_usage (argv[0]);
+}
+
+int main (int argc, char ** argv)
+{
+  handle_arguments (argc, argv);
+
+  std::vector <gams::utility::Trace_Event> events;
+  if (gams::utility::load_trace (filename, events) != 0)
+  {
+    cerr << "Unable to read trace file " << filename << endl;
+    return -1;
+  }
+
+  if (summary)
+  {
+    std::map <std::string, size_t> counts;
+    for (size_t i = 0; i < events.size (); ++i)
+      ++counts[events[i].label];
+
+    for (std::map <std::string, size_t>::iterator i = counts.begin ();
+      i != counts.end (); ++i)
+    {
+      cout << std::setw (10) << i->second << " " << i->first << endl;
+    }
+  }
+  else
+  {
+    // time in microseconds, thread, label and arguments
+    for (size_t i = 0; i < events.size (); ++i)
+    {
+      const gams::utility::Trace_Event & event = events[i];
+      cout << std::fixed << std::setprecision (3) <<
+        std::setw (14) << event.time / 1000.0 << " " <<
+        std::setw (4) << event.thread << " " << event.label << " " <<
+        event.arg0 << " " << event.arg1 << endl;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,190 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+/**
+ * @file Clock.h
+ * @author James Edmondson <jedmondson@gmail.com>
+ *
+ * This file contains the clocks used to schedule control loops
+ **/
+
+#ifndef _GAMS_UTILITY_CLOCK_H_
+#define _GAMS_UTILITY_CLOCK_H_
+
+#include "gams/GAMS_Export.h"
+
+#include "ace/Time_Value.h"
+
+namespace gams
+{
+  namespace utility
+  {
+    /**
+     * A source of monotonic time for control loops, algorithms and
+     * platforms
+     **/
+    class GAMS_Export Clock
+    {
+    public:
+      /**
+       * Destructor
+       **/
+      virtual ~Clock ();
+
+      /**
+       * Gets the current time
+       * @return the current time
+       **/
+      virtual ACE_Time_Value now (void) const = 0;
+
+      /**
+       * Waits until a time has been reached
+       * @param  time   the time to wait for
+       **/
+      virtual void sleep_until (const ACE_Time_Value & time) = 0;
+
+      /**
+       * Gets the current time in seconds
+       * @return the current time in seconds
+       **/
+      double now_seconds (void) const;
+
+      /**
+       * Checks if the clock only moves when slept on or advanced
+       * @return true for simulated time. False by default.
+       **/
+      virtual bool is_simulated (void) const;
+    };
+
+    /**
+     * A clock that follows the high resolution system timer and sleeps
+     * in real time
+     **/
+    class GAMS_Export Real_Clock : public Clock
+    {
+    public:
+      /**
+       * Destructor
+       **/
+      virtual ~Real_Clock ();
+
+      /**
+       * Gets the current time of the high resolution timer
+       * @return the current time
+       **/
+      virtual ACE_Time_Value now (void) const;
+
+      /**
+       * Sleeps until a time has been reached
+       * @param  time   the time to wait for
+       **/
+      virtual void sleep_until (const ACE_Time_Value & time);
+    };
+
+    /**
+     * A clock that only moves when it is told to. Sleeping jumps directly
+     * to the requested time, so a control loop on a virtual clock runs
+     * as fast as its iterations allow and is reproducible. The clock is
+     * not thread-safe and should only be advanced by the loop thread.
+     **/
+    class GAMS_Export Virtual_Clock : public Clock
+    {
+    public:
+      /**
+       * Constructor
+       * @param  start   the initial time
+       **/
+      Virtual_Clock (const ACE_Time_Value & start = ACE_Time_Value::zero);
+
+      /**
+       * Destructor
+       **/
+      virtual ~Virtual_Clock ();
+
+      /**
+       * Gets the simulated time
+       * @return the current time
+       **/
+      virtual ACE_Time_Value now (void) const;
+
+      /**
+       * Advances the simulated time to a time, if it is later
+       * @param  time   the time to wait for
+       **/
+      virtual void sleep_until (const ACE_Time_Value & time);
+
+      /**
+       * Checks if the clock only moves when slept on or advanced
+       * @return true
+       **/
+      virtual bool is_simulated (void) const;
+
+      /**
+       * Advances the simulated time
+       * @param  delta   the amount of time to add
+       **/
+      void advance (const ACE_Time_Value & delta);
+
+      /**
+       * Sets the simulated time
+       * @param  time   the new time
+       **/
+      void set (const ACE_Time_Value & time);
+
+    protected:
+      /// the simulated time
+      ACE_Time_Value current_;
+    };
+
+    /**
+     * Gets a shared real time clock, used when no clock has been set
+     * @return the default clock
+     **/
+    GAMS_Export Clock * default_clock (void);
+  }
+}
+
+#endif // _GAMS_UTILITY_CLOCK_H_
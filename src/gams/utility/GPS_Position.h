@@ -180,7 +180,8 @@ namespace gams
         const unsigned int precision = 8) const;
 
       /**
-       * Convert to position using reference location
+       * Convert to position using reference location. Use Local_Frame to
+       * convert many positions around the same reference.
        * @param ref   Reference location
        * @return Position object relative to ref
        **/
@@ -0,0 +1,187 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+/**
+ * @file Latency_Histogram.cpp
+ * @author James Edmondson <jedmondson@gmail.com>
+ *
+ * This file contains a fixed-bucket histogram for recording latencies
+ **/
+
+#include <sstream>
+#include <cstring>
+
+#include "Latency_Histogram.h"
+
+gams::utility::Latency_Histogram::Latency_Histogram ()
+{
+  reset ();
+}
+
+gams::utility::Latency_Histogram::~Latency_Histogram ()
+{
+}
+
+void
+gams::utility::Latency_Histogram::record (uint64_t nanoseconds)
+{
+  ++counts_[get_bucket (nanoseconds)];
+  ++count_;
+  total_ += (double)nanoseconds;
+
+  if (nanoseconds < min_)
+    min_ = nanoseconds;
+  if (nanoseconds > max_)
+    max_ = nanoseconds;
+}
+
+void
+gams::utility::Latency_Histogram::reset (void)
+{
+  memset (counts_, 0, sizeof (counts_));
+  count_ = 0;
+  min_ = (uint64_t)-1;
+  max_ = 0;
+  total_ = 0.0;
+}
+
+uint64_t
+gams::utility::Latency_Histogram::get_count (void) const
+{
+  return count_;
+}
+
+uint64_t
+gams::utility::Latency_Histogram::get_max (void) const
+{
+  return max_;
+}
+
+uint64_t
+gams::utility::Latency_Histogram::get_min (void) const
+{
+  return count_ > 0 ? min_ : 0;
+}
+
+double
+gams::utility::Latency_Histogram::get_mean (void) const
+{
+  return count_ > 0 ? total_ / count_ : 0.0;
+}
+
+uint64_t
+gams::utility::Latency_Histogram::get_percentile (double percentile) const
+{
+  if (count_ == 0)
+    return 0;
+
+  if (percentile < 0.0)
+    percentile = 0.0;
+  else if (percentile > 100.0)
+    percentile = 100.0;
+
+  // the rank of the sample we are looking for (at least the first)
+  uint64_t rank = (uint64_t)(percentile / 100.0 * count_ + 0.5);
+  if (rank == 0)
+    rank = 1;
+
+  uint64_t seen = 0;
+  for (unsigned int i = 0; i < NUM_BUCKETS; ++i)
+  {
+    seen += counts_[i];
+    if (seen >= rank)
+    {
+      uint64_t result = get_bucket_max (i);
+      return result < max_ ? result : max_;
+    }
+  }
+
+  return max_;
+}
+
+std::string
+gams::utility::Latency_Histogram::to_string (double scale) const
+{
+  std::stringstream buffer;
+  buffer << "count=" << count_;
+  buffer << " min=" << get_min () / scale;
+  buffer << " p50=" << get_percentile (50.0) / scale;
+  buffer << " p99=" << get_percentile (99.0) / scale;
+  buffer << " max=" << get_max () / scale;
+
+  return buffer.str ();
+}
+
+unsigned int
+gams::utility::Latency_Histogram::get_bucket (uint64_t value)
+{
+  // find the most significant bit of the value
+  unsigned int msb = 0;
+#if defined (__GNUC__)
+  if (value != 0)
+    msb = 63 - __builtin_clzll (value);
+#else
+  for (uint64_t remaining = value >> 1; remaining != 0; remaining >>= 1)
+    ++msb;
+#endif
+
+  // values below 2 * SUB_BUCKETS are stored exactly
+  unsigned int shift = msb > SUB_BUCKET_BITS ? msb - SUB_BUCKET_BITS : 0;
+
+  return shift * SUB_BUCKETS + (unsigned int)(value >> shift);
+}
+
+uint64_t
+gams::utility::Latency_Histogram::get_bucket_max (unsigned int bucket)
+{
+  if (bucket < 2 * SUB_BUCKETS)
+    return bucket;
+
+  unsigned int shift = bucket / SUB_BUCKETS - 1;
+  uint64_t sub_bucket = bucket % SUB_BUCKETS + SUB_BUCKETS;
+
+  return ((sub_bucket + 1) << shift) - 1;
+}
@@ -0,0 +1,178 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+/**
+ * @file Latency_Histogram.h
+ * @author James Edmondson <jedmondson@gmail.com>
+ *
+ * This file contains a fixed-bucket histogram for recording latencies
+ **/
+
+#ifndef _GAMS_UTILITY_LATENCY_HISTOGRAM_H_
+#define _GAMS_UTILITY_LATENCY_HISTOGRAM_H_
+
+#include <string>
+#include <stdint.h>
+
+#include "gams/GAMS_Export.h"
+
+namespace gams
+{
+  namespace utility
+  {
+    /**
+     * A histogram of latencies in nanoseconds. Buckets are log-linear:
+     * every power of two is split into 16 linear sub-buckets, which keeps
+     * the relative error of any reported value under 1/16 while using a
+     * fixed amount of memory. Recording a sample never allocates.
+     **/
+    class GAMS_Export Latency_Histogram
+    {
+    public:
+      /// the number of linear sub-buckets per power of two, as a shift
+      static const unsigned int SUB_BUCKET_BITS = 4;
+
+      /// the number of linear sub-buckets per power of two
+      static const unsigned int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+
+      /// the total number of buckets needed to cover 64 bit values
+      static const unsigned int NUM_BUCKETS =
+        (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+      /**
+       * Constructor
+       **/
+      Latency_Histogram ();
+
+      /**
+       * Destructor
+       **/
+      ~Latency_Histogram ();
+
+      /**
+       * Records a latency sample
+       * @param  nanoseconds   the latency to record
+       **/
+      void record (uint64_t nanoseconds);
+
+      /**
+       * Clears all samples
+       **/
+      void reset (void);
+
+      /**
+       * Gets the number of recorded samples
+       * @return the sample count
+       **/
+      uint64_t get_count (void) const;
+
+      /**
+       * Gets the largest recorded sample
+       * @return the maximum latency in nanoseconds
+       **/
+      uint64_t get_max (void) const;
+
+      /**
+       * Gets the smallest recorded sample
+       * @return the minimum latency in nanoseconds
+       **/
+      uint64_t get_min (void) const;
+
+      /**
+       * Gets the mean of all recorded samples
+       * @return the mean latency in nanoseconds
+       **/
+      double get_mean (void) const;
+
+      /**
+       * Gets the latency at a percentile. The result is the upper bound of
+       * the bucket the percentile falls in, capped by the maximum sample.
+       * @param  percentile   the percentile to retrieve (0-100)
+       * @return the latency in nanoseconds
+       **/
+      uint64_t get_percentile (double percentile) const;
+
+      /**
+       * Helper function for converting the histogram summary to a string
+       * @param  scale   divisor for all printed values (e.g. 1000 for us)
+       * @return count, min, p50, p99 and max of the histogram
+       **/
+      std::string to_string (double scale = 1.0) const;
+
+    protected:
+      /**
+       * Gets the bucket a value belongs to
+       * @param  value   the value to place
+       * @return the index of the bucket
+       **/
+      static unsigned int get_bucket (uint64_t value);
+
+      /**
+       * Gets the largest value that falls in a bucket
+       * @param  bucket  the index of the bucket
+       * @return the upper bound of the bucket
+       **/
+      static uint64_t get_bucket_max (unsigned int bucket);
+
+      /// the number of samples in each bucket
+      uint64_t counts_[NUM_BUCKETS];
+
+      /// the number of samples
+      uint64_t count_;
+
+      /// the smallest sample
+      uint64_t min_;
+
+      /// the largest sample
+      uint64_t max_;
+
+      /// the sum of all samples
+      double total_;
+    };
+  }
+}
+
+#endif // _GAMS_UTILITY_LATENCY_HISTOGRAM_H_
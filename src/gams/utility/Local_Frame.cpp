@@ -0,0 +1,151 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+/**
+ * @file Local_Frame.cpp
+ * @author James Edmondson <jedmondson@gmail.com>
+ *
+ * This file contains a utility class for converting many positions between
+ * GPS coordinates and meters around a reference point
+ **/
+
+#include <cmath>
+
+#include "gams/utility/Local_Frame.h"
+
+using std::vector;
+
+#define DEG_TO_RAD(x) ((x) * M_PI / 180.0)
+
+/**
+ * The terms below are evaluated in the same order as GPS_Position, so the
+ * results match it to the bit.
+ **/
+
+// assume the Earth is a perfect sphere
+static const double EARTH_RADIUS = 6371000.0;
+
+gams::utility::Local_Frame::Local_Frame (const GPS_Position & origin) :
+  origin_ (origin), circumference_ (2 * EARTH_RADIUS * M_PI)
+{
+  const double r_prime = EARTH_RADIUS * cos (DEG_TO_RAD (origin.x));
+  lon_circumference_ = 2 * r_prime * M_PI;
+}
+
+const gams::utility::GPS_Position &
+gams::utility::Local_Frame::get_origin () const
+{
+  return origin_;
+}
+
+gams::utility::Position
+gams::utility::Local_Frame::to_position (const GPS_Position & pos) const
+{
+  Position ret;
+  to_positions (&pos.x, &pos.y, 1, &ret.x, &ret.y);
+  ret.z = pos.z - origin_.z;
+  return ret;
+}
+
+gams::utility::GPS_Position
+gams::utility::Local_Frame::to_gps_position (const Position & pos) const
+{
+  GPS_Position ret;
+  to_gps_positions (&pos.x, &pos.y, 1, &ret.x, &ret.y);
+  ret.z = origin_.z + pos.z;
+  return ret;
+}
+
+void
+gams::utility::Local_Frame::to_positions (
+  const double * lat, const double * lon, size_t n,
+  double * x, double * y) const
+{
+  const double origin_lat = origin_.x;
+  const double origin_lon = origin_.y;
+  const double circumference = circumference_;
+  for (size_t i = 0; i < n; ++i)
+  {
+    // the length of a degree of longitude at the latitude of the point
+    const double r_prime = EARTH_RADIUS * cos (DEG_TO_RAD (lat[i]));
+    x[i] = (lat[i] - origin_lat) / 360.0 * circumference;
+    y[i] = (lon[i] - origin_lon) / 360.0 * (2 * r_prime * M_PI);
+  }
+}
+
+void
+gams::utility::Local_Frame::to_gps_positions (
+  const double * x, const double * y, size_t n,
+  double * lat, double * lon) const
+{
+  const double origin_lat = origin_.x;
+  const double origin_lon = origin_.y;
+  const double circumference = circumference_;
+  const double lon_circumference = lon_circumference_;
+  for (size_t i = 0; i < n; ++i)
+  {
+    lat[i] = x[i] * 360.0 / circumference + origin_lat;
+    lon[i] = y[i] / lon_circumference * 360 + origin_lon;
+  }
+}
+
+void
+gams::utility::Local_Frame::to_positions (
+  const vector <GPS_Position> & positions, vector <Position> & result) const
+{
+  result.resize (positions.size ());
+  for (size_t i = 0; i < positions.size (); ++i)
+    result[i] = to_position (positions[i]);
+}
+
+void
+gams::utility::Local_Frame::to_gps_positions (
+  const vector <Position> & positions, vector <GPS_Position> & result) const
+{
+  result.resize (positions.size ());
+  for (size_t i = 0; i < positions.size (); ++i)
+    result[i] = to_gps_position (positions[i]);
+}
@@ -0,0 +1,159 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+/**
+ * @file Local_Frame.h
+ * @author James Edmondson <jedmondson@gmail.com>
+ *
+ * This file contains a utility class for converting many positions between
+ * GPS coordinates and meters around a reference point
+ **/
+
+#ifndef  _GAMS_UTILITY_LOCAL_FRAME_H_
+#define  _GAMS_UTILITY_LOCAL_FRAME_H_
+
+#include <vector>
+
+#include "gams/GAMS_Export.h"
+#include "gams/utility/Position.h"
+#include "gams/utility/GPS_Position.h"
+
+namespace gams
+{
+  namespace utility
+  {
+    /**
+     * The equirectangular projection of GPS_Position::to_position and
+     * GPS_Position::to_gps_position around a fixed reference. The
+     * circumferences are computed once, and the conversions give exactly
+     * the same results as the GPS_Position functions. The batch functions
+     * work on contiguous arrays so the compiler can vectorize them.
+     **/
+    class GAMS_Export Local_Frame
+    {
+    public:
+      /**
+       * Constructor
+       * @param  origin   the reference of the frame
+       **/
+      Local_Frame (const GPS_Position & origin = GPS_Position ());
+
+      /**
+       * Gets origin
+       * @return GPS origin
+       **/
+      const GPS_Position & get_origin () const;
+
+      /**
+       * Converts a GPS position to meters from the origin. As with
+       * GPS_Position::to_position, the length of a degree of longitude
+       * is taken at the latitude of the position.
+       * @param  pos   GPS position to convert
+       * @return position in meters
+       **/
+      Position to_position (const GPS_Position & pos) const;
+
+      /**
+       * Converts meters from the origin to a GPS position. As with
+       * GPS_Position::to_gps_position, the length of a degree of longitude
+       * is taken at the latitude of the origin.
+       * @param  pos   position in meters to convert
+       * @return GPS position
+       **/
+      GPS_Position to_gps_position (const Position & pos) const;
+
+      /**
+       * Converts GPS positions to meters from the origin
+       * @param  lat   latitudes to convert
+       * @param  lon   longitudes to convert
+       * @param  n     number of positions
+       * @param  x     set to meters north of the origin
+       * @param  y     set to meters east of the origin
+       **/
+      void to_positions (const double * lat, const double * lon, size_t n,
+        double * x, double * y) const;
+
+      /**
+       * Converts meters from the origin to GPS positions
+       * @param  x     meters north of the origin
+       * @param  y     meters east of the origin
+       * @param  n     number of positions
+       * @param  lat   set to the latitudes
+       * @param  lon   set to the longitudes
+       **/
+      void to_gps_positions (const double * x, const double * y, size_t n,
+        double * lat, double * lon) const;
+
+      /**
+       * Converts a list of GPS positions to meters from the origin
+       * @param  positions   GPS positions to convert
+       * @param  result      list to store the positions in meters in
+       **/
+      void to_positions (const std::vector <GPS_Position> & positions,
+        std::vector <Position> & result) const;
+
+      /**
+       * Converts a list of positions in meters to GPS positions
+       * @param  positions   positions in meters to convert
+       * @param  result      list to store the GPS positions in
+       **/
+      void to_gps_positions (const std::vector <Position> & positions,
+        std::vector <GPS_Position> & result) const;
+
+    protected:
+      /// the reference of the frame
+      GPS_Position origin_;
+
+      /// meters around the Earth along a meridian
+      double circumference_;
+
+      /// meters around the Earth along the parallel of the origin
+      double lon_circumference_;
+    }; // class Local_Frame
+  } // namespace utility
+} // namespace gams
+
+#endif // _GAMS_UTILITY_LOCAL_FRAME_H_
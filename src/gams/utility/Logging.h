@@ -52,6 +52,13 @@ extern GAMS_Export int GAMS_debug_level;
 /// used to display extremely fine-grained trace information
 #define GAMS_LOG_DETAILED_TRACE      10
 
+/// The least important log level that is compiled in. Logging statements
+/// with a higher level are removed by the compiler, whatever the runtime
+/// log level. Defaults to keeping every level.
+#if !defined (GAMS_MIN_LOG_LEVEL)
+#  define GAMS_MIN_LOG_LEVEL GAMS_LOG_DETAILED_TRACE
+#endif
+
 namespace gams
 {
   namespace utility
@@ -134,7 +141,7 @@ namespace gams
 # if !defined (GAMS_ERROR)
 #  define GAMS_ERROR(L, X) \
   do { \
-    if (GAMS_debug_level >= L) \
+    if ((L) <= GAMS_MIN_LOG_LEVEL && GAMS_debug_level >= L) \
       { \
         int const __ace_error = ACE_Log_Msg::last_error_adapter (); \
         ACE_Log_Msg *ace___ = ACE_Log_Msg::instance ();               \
@@ -146,7 +153,7 @@ namespace gams
 # if !defined (GAMS_DEBUG)
 #  define GAMS_DEBUG(L, X) \
   do { \
-    if (GAMS_debug_level >= L) \
+    if ((L) <= GAMS_MIN_LOG_LEVEL && GAMS_debug_level >= L) \
       { \
         int const __ace_error = ACE_Log_Msg::last_error_adapter (); \
         ACE_Log_Msg *ace___ = ACE_Log_Msg::instance (); \
@@ -158,7 +165,7 @@ namespace gams
 # if !defined (GAMS_LOG_TRACE)
 #  define GAMS_LOG_TRACE(L, X) \
   do { \
-    if (GAMS_debug_level >= L) \
+    if ((L) <= GAMS_MIN_LOG_LEVEL && GAMS_debug_level >= L) \
       { \
         int const __ace_error = ACE_Log_Msg::last_error_adapter (); \
         ACE_Log_Msg *ace___ = ACE_Log_Msg::instance (); \
@@ -170,7 +177,7 @@ namespace gams
 # if !defined (GAMS_ERROR_RETURN)
 #  define GAMS_ERROR_RETURN(L, X, Y) \
   do { \
-    if (GAMS_debug_level >= L) \
+    if ((L) <= GAMS_MIN_LOG_LEVEL && GAMS_debug_level >= L) \
       { \
         int const __ace_error = ACE_Log_Msg::last_error_adapter (); \
         ACE_Log_Msg *ace___ = ACE_Log_Msg::instance (); \
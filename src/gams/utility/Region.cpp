@@ -55,17 +55,51 @@
 #include <string>
 #include <vector>
 #include <cmath>
+#include <algorithm>
 
 #include "Region.h"
+#include "Local_Frame.h"
 #include "madara/utility/Utility.h"
 #include "Logging.h"
 
+#if defined (__AVX2__)
+  #define GAMS_KERNELS_AVX2
+  #include <immintrin.h>
+#elif defined (__SSE2__) || defined (_M_X64)
+  #define GAMS_KERNELS_SSE2
+  #include <emmintrin.h>
+#endif
+
 using std::string;
 using std::stringstream;
 using std::vector;
 
 typedef  Madara::Knowledge_Record::Integer Integer;
 
+namespace
+{
+  /**
+   * Regions with more edges than this search a segment hierarchy
+   **/
+  const size_t MIN_HIERARCHY_EDGES = 32;
+
+  /**
+   * Number of edges in a leaf of the segment hierarchy
+   **/
+  const size_t SEGMENT_LEAF_SIZE = 8;
+
+  /**
+   * Distance from a point to an axis aligned box
+   **/
+  double box_distance (double x, double y,
+    double min_x, double min_y, double max_x, double max_y)
+  {
+    const double dx = x < min_x ? min_x - x : (x > max_x ? x - max_x : 0);
+    const double dy = y < min_y ? min_y - y : (y > max_y ? y - max_y : 0);
+    return sqrt (dx * dx + dy * dy);
+  }
+}
+
 gams::utility::Region::Region (const std::vector <GPS_Position> & init_vertices) :
   vertices (init_vertices)
 {
@@ -118,21 +152,7 @@ gams::utility::Region::contains (const GPS_Position & p) const
 
   // check if point in polygon code from 
   // http://www.ecse.rpi.edu/Homepages/wrf/Research/Short_Notes/pnpoly.html
-  size_t i, j;
-  bool ret = false;
-  for (i = 0, j = vertices.size() - 1; i < vertices.size(); j = i++)
-  {
-    if ( (vertices[i].longitude () > p.longitude ()) !=
-        (vertices[j].longitude () > p.longitude ()))
-    {
-      if (p.latitude () < (vertices[j].latitude () - vertices[i].latitude ()) * (p.longitude () - vertices[i].longitude ()) / 
-                (vertices[j].longitude () - vertices[i].longitude ()) + 
-                 vertices[i].latitude ())
-      {
-        ret = !ret;
-      }
-    }
-  }
+  bool ret = get_crossing_parity (p.latitude (), p.longitude ());
 
   // check if this is a vertex point
   if (!ret)
@@ -146,6 +166,104 @@ gams::utility::Region::contains (const GPS_Position & p) const
   return ret;
 }
 
+void
+gams::utility::Region::contains (const double * lat, const double * lon,
+  size_t n, uint8_t * out) const
+{
+  const size_t num_edges = edge_lat_.size ();
+  size_t k = 0;
+
+  // crossing parity of several points per step, one edge at a time. The
+  // intersection is computed with the same operations as the scalar test,
+  // so both agree exactly. Lanes where the edge does not straddle the
+  // point may divide by zero, but they are masked out.
+#if defined (GAMS_KERNELS_AVX2)
+  for (; k + 4 <= n; k += 4)
+  {
+    const __m256d p_lat = _mm256_loadu_pd (lat + k);
+    const __m256d p_lon = _mm256_loadu_pd (lon + k);
+    __m256d parity = _mm256_setzero_pd ();
+    for (size_t e = 0; e < num_edges; ++e)
+    {
+      const __m256d lon_i = _mm256_set1_pd (edge_lon_[e]);
+      const __m256d straddle = _mm256_xor_pd (
+        _mm256_cmp_pd (lon_i, p_lon, _CMP_GT_OQ),
+        _mm256_cmp_pd (_mm256_set1_pd (edge_prev_lon_[e]), p_lon, _CMP_GT_OQ));
+      const __m256d crossing = _mm256_add_pd (_mm256_div_pd (
+        _mm256_mul_pd (_mm256_set1_pd (edge_dlat_[e]),
+          _mm256_sub_pd (p_lon, lon_i)),
+        _mm256_set1_pd (edge_dlon_[e])), _mm256_set1_pd (edge_lat_[e]));
+      parity = _mm256_xor_pd (parity, _mm256_and_pd (straddle,
+        _mm256_cmp_pd (p_lat, crossing, _CMP_LT_OQ)));
+    }
+    const int mask = _mm256_movemask_pd (parity);
+    for (size_t l = 0; l < 4; ++l)
+      out[k + l] = (mask >> l) & 1;
+  }
+#elif defined (GAMS_KERNELS_SSE2)
+  for (; k + 2 <= n; k += 2)
+  {
+    const __m128d p_lat = _mm_loadu_pd (lat + k);
+    const __m128d p_lon = _mm_loadu_pd (lon + k);
+    __m128d parity = _mm_setzero_pd ();
+    for (size_t e = 0; e < num_edges; ++e)
+    {
+      const __m128d lon_i = _mm_set1_pd (edge_lon_[e]);
+      const __m128d straddle = _mm_xor_pd (_mm_cmpgt_pd (lon_i, p_lon),
+        _mm_cmpgt_pd (_mm_set1_pd (edge_prev_lon_[e]), p_lon));
+      const __m128d crossing = _mm_add_pd (_mm_div_pd (
+        _mm_mul_pd (_mm_set1_pd (edge_dlat_[e]), _mm_sub_pd (p_lon, lon_i)),
+        _mm_set1_pd (edge_dlon_[e])), _mm_set1_pd (edge_lat_[e]));
+      parity = _mm_xor_pd (parity, _mm_and_pd (straddle,
+        _mm_cmplt_pd (p_lat, crossing)));
+    }
+    const int mask = _mm_movemask_pd (parity);
+    out[k] = mask & 1;
+    out[k + 1] = (mask >> 1) & 1;
+  }
+#endif
+
+  // remaining points, or all of them without vector instructions
+  for (; k < n; ++k)
+    out[k] = get_crossing_parity (lat[k], lon[k]);
+
+  // bounding box and vertex checks as in the single point test
+  for (k = 0; k < n; ++k)
+  {
+    if (lat[k] < min_lat_ || lat[k] > max_lat_ ||
+        lon[k] < min_lon_ || lon[k] > max_lon_)
+    {
+      out[k] = 0;
+    }
+    else if (!out[k])
+    {
+      for (size_t i = 0; i < vertices.size () && !out[k]; ++i)
+      {
+        out[k] = vertices[i].latitude () == lat[k] &&
+          vertices[i].longitude () == lon[k] && vertices[i].altitude () == 0;
+      }
+    }
+  }
+}
+
+bool
+gams::utility::Region::get_crossing_parity (double lat, double lon) const
+{
+  bool ret = false;
+  for (size_t e = 0; e < edge_lat_.size (); ++e)
+  {
+    if ((edge_lon_[e] > lon) != (edge_prev_lon_[e] > lon))
+    {
+      if (lat < edge_dlat_[e] * (lon - edge_lon_[e]) / edge_dlon_[e] +
+        edge_lat_[e])
+      {
+        ret = !ret;
+      }
+    }
+  }
+  return ret;
+}
+
 double
 gams::utility::Region::distance (const GPS_Position& p) const
 {
@@ -155,19 +273,67 @@ gams::utility::Region::distance (const GPS_Position& p) const
 
   // convert to cartesian coords with equirectangular projection
   const GPS_Position sw (min_lat_, min_lon_);
-  vector<Position> local_vertices;
-  for (size_t i = 0; i < vertices.size (); ++i)
-    local_vertices.push_back (vertices[i].to_position (sw));
-  Position local_p = p.to_position (sw);
+  const Position local_p = p.to_position (sw);
+  const size_t num_vertices = local_vertices_.size ();
 
   // else we check for distance from each edge
   double min_dist = DBL_MAX;
-  for (size_t i = 0; i < local_vertices.size (); ++i)
+  if (segment_nodes_.empty ())
   {
-    const size_t i_1 = (i + 1) % local_vertices.size();
-    double dist = local_vertices[i].distance_to_2d (local_vertices[i_1], local_p);
-    if (dist < min_dist)
-      min_dist = dist;
+    for (size_t i = 0; i < num_vertices; ++i)
+    {
+      const size_t i_1 = (i + 1) % num_vertices;
+      double dist = local_vertices_[i].distance_to_2d (
+        local_vertices_[i_1], local_p);
+      if (dist < min_dist)
+        min_dist = dist;
+    }
+    return min_dist;
+  }
+
+  // descend the hierarchy, skipping boxes farther than the closest edge.
+  // The slack keeps rounding from pruning an edge that ties the minimum.
+  size_t stack[64];
+  size_t depth = 0;
+  stack[depth++] = 0;
+  while (depth > 0)
+  {
+    const Segment_Node & node = segment_nodes_[stack[--depth]];
+    if (box_distance (local_p.x, local_p.y, node.min_x, node.min_y,
+      node.max_x, node.max_y) > min_dist * (1 + 1e-9) + 1e-9)
+    {
+      continue;
+    }
+
+    if (node.left == 0)
+    {
+      for (size_t i = node.begin; i < node.end; ++i)
+      {
+        const size_t i_1 = (i + 1) % num_vertices;
+        double dist = local_vertices_[i].distance_to_2d (
+          local_vertices_[i_1], local_p);
+        if (dist < min_dist)
+          min_dist = dist;
+      }
+    }
+    else
+    {
+      // visit the closer child first
+      const Segment_Node & left = segment_nodes_[node.left];
+      const Segment_Node & right = segment_nodes_[node.right];
+      if (box_distance (local_p.x, local_p.y, left.min_x, left.min_y,
+        left.max_x, left.max_y) < box_distance (local_p.x, local_p.y,
+        right.min_x, right.min_y, right.max_x, right.max_y))
+      {
+        stack[depth++] = node.right;
+        stack[depth++] = node.left;
+      }
+      else
+      {
+        stack[depth++] = node.left;
+        stack[depth++] = node.right;
+      }
+    }
   }
 
   return min_dist;
@@ -209,6 +375,7 @@ gams::utility::Region::get_bounding_box () const
   p.altitude (0);
   ret.vertices.push_back (p);
 
+  ret.calculate_bounding_box ();
   ret.min_lat_ = this->min_lat_;
   ret.max_lat_ = this->max_lat_;
   ret.min_lon_ = this->min_lon_;
@@ -222,29 +389,7 @@ gams::utility::Region::get_bounding_box () const
 double
 gams::utility::Region::get_area () const
 {
-  if (vertices.size() < 3)
-    return 0; // degenerate polygon
-
-  // see http://geomalgorithms.com/a01-_area.html
-  // Convert all units to cartesian
-  vector<Position> cart_vertices;
-  for (unsigned int i = 0; i < vertices.size(); ++i)
-  {
-    Position p = vertices[i].to_position (vertices[0]);
-    cart_vertices.push_back (p);
-  }
-
-  // perform calculations with cartesian vertices
-  double area = 0.0;
-  size_t i, j, k;
-  size_t num_vertices = cart_vertices.size ();
-  for (i = 1, j = 2, k = 0; i < num_vertices; ++i, ++j, ++k)
-  {
-    area += cart_vertices[i].x *
-      (cart_vertices[j % num_vertices].y - cart_vertices[k].y);
-  }
-  area += cart_vertices[0].x * (cart_vertices[1].y - cart_vertices[num_vertices - 1].y);
-  return fabs(area / 2);
+  return area_;
 }
 
 string
@@ -308,6 +453,96 @@ gams::utility::Region::calculate_bounding_box ()
     max_alt_ = (max_alt_ < vertices[i].altitude ()) ?
       vertices[i].altitude () : max_alt_;
   }
+
+  const size_t num_vertices = vertices.size ();
+  edge_lat_.resize (num_vertices);
+  edge_lon_.resize (num_vertices);
+  edge_prev_lon_.resize (num_vertices);
+  edge_dlat_.resize (num_vertices);
+  edge_dlon_.resize (num_vertices);
+  for (size_t i = 0, j = num_vertices - 1; i < num_vertices; j = i++)
+  {
+    edge_lat_[i] = vertices[i].latitude ();
+    edge_lon_[i] = vertices[i].longitude ();
+    edge_prev_lon_[i] = vertices[j].longitude ();
+    edge_dlat_[i] = vertices[j].latitude () - vertices[i].latitude ();
+    edge_dlon_[i] = vertices[j].longitude () - vertices[i].longitude ();
+  }
+
+  // project the vertices for distance queries
+  const Local_Frame sw (GPS_Position (min_lat_, min_lon_));
+  sw.to_positions (vertices, local_vertices_);
+
+  segment_nodes_.clear ();
+  if (num_vertices > MIN_HIERARCHY_EDGES)
+  {
+    segment_nodes_.reserve (2 * num_vertices / SEGMENT_LEAF_SIZE + 1);
+    build_segment_nodes (0, num_vertices);
+  }
+
+  area_ = 0.0;
+  if (num_vertices < 3)
+    return; // degenerate polygon
+
+  // see http://geomalgorithms.com/a01-_area.html
+  // Convert all units to cartesian
+  vector<Position> cart_vertices;
+  Local_Frame (vertices[0]).to_positions (vertices, cart_vertices);
+
+  // perform calculations with cartesian vertices
+  size_t i, j, k;
+  for (i = 1, j = 2, k = 0; i < num_vertices; ++i, ++j, ++k)
+  {
+    area_ += cart_vertices[i].x *
+      (cart_vertices[j % num_vertices].y - cart_vertices[k].y);
+  }
+  area_ += cart_vertices[0].x *
+    (cart_vertices[1].y - cart_vertices[num_vertices - 1].y);
+  area_ = fabs (area_ / 2);
+}
+
+size_t
+gams::utility::Region::build_segment_nodes (size_t begin, size_t end)
+{
+  const size_t index = segment_nodes_.size ();
+  segment_nodes_.push_back (Segment_Node ());
+
+  Segment_Node node;
+  node.min_x = node.min_y = DBL_MAX;
+  node.max_x = node.max_y = -DBL_MAX;
+  node.begin = begin;
+  node.end = end;
+  node.left = node.right = 0;
+
+  if (end - begin > SEGMENT_LEAF_SIZE)
+  {
+    // edges are in order around the polygon, so halves stay compact
+    const size_t middle = begin + (end - begin) / 2;
+    node.left = build_segment_nodes (begin, middle);
+    node.right = build_segment_nodes (middle, end);
+
+    const Segment_Node & left = segment_nodes_[node.left];
+    const Segment_Node & right = segment_nodes_[node.right];
+    node.min_x = std::min (left.min_x, right.min_x);
+    node.min_y = std::min (left.min_y, right.min_y);
+    node.max_x = std::max (left.max_x, right.max_x);
+    node.max_y = std::max (left.max_y, right.max_y);
+  }
+  else
+  {
+    for (size_t i = begin; i < end; ++i)
+    {
+      const Position & a = local_vertices_[i];
+      const Position & b = local_vertices_[(i + 1) % local_vertices_.size ()];
+      node.min_x = std::min (node.min_x, std::min (a.x, b.x));
+      node.min_y = std::min (node.min_y, std::min (a.y, b.y));
+      node.max_x = std::max (node.max_x, std::max (a.x, b.x));
+      node.max_y = std::max (node.max_y, std::max (a.y, b.y));
+    }
+  }
+
+  segment_nodes_[index] = node;
+  return index;
 }
 
 void
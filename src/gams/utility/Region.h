@@ -56,6 +56,7 @@
 
 #include <vector>
 #include <string>
+#include <stdint.h>
 
 #include "gams/GAMS_Export.h"
 #include "madara/knowledge_engine/containers/String_Vector.h"
@@ -109,7 +110,23 @@ namespace gams
       bool contains (const Position & p, const GPS_Position& ref) const;
 
       /**
-       * Get distance from any point in this region
+       * Determine if a batch of points is in region. Points are tested in
+       * lat/lon only, as if they were at altitude 0, against a
+       * structure-of-arrays copy of the edges so that several points are
+       * tested per instruction where the compiler targets SSE2 or AVX2.
+       * @param   lat   latitudes of the points
+       * @param   lon   longitudes of the points
+       * @param   n     number of points
+       * @param   out   set to 1 for each point in region or on a vertex,
+       *                0 otherwise
+       **/
+      void contains (const double * lat, const double * lon, size_t n,
+        uint8_t * out) const;
+
+      /**
+       * Get distance from any point in this region. Vertices are projected
+       * once when the region changes, and the edges of large regions are
+       * searched through a hierarchy of bounding boxes.
        * @param   p     point to check
        * @return 0 if in region, otherwise distance from region
        **/
@@ -122,7 +139,7 @@ namespace gams
       Region get_bounding_box () const;
 
       /**
-       * Get area of the region
+       * Get area of the region, computed when the region changes
        * @return area of this region
        **/
       double get_area () const;
@@ -166,9 +183,58 @@ namespace gams
 
     protected:
       /**
-       * populate bounding box values
+       * Bounding box of a range of edges in the segment hierarchy
+       **/
+      struct Segment_Node
+      {
+        /// bounding box of the edges in meters
+        double min_x, min_y, max_x, max_y;
+
+        /// range of edges, edge i runs from local vertex i to i + 1
+        size_t begin, end;
+
+        /// child nodes, 0 for leaves since the root is node 0
+        size_t left, right;
+      };
+
+      /**
+       * populate bounding box values, the edge arrays, the projected
+       * vertices, the area and the segment hierarchy
        **/
       void calculate_bounding_box ();
+
+      /**
+       * Adds a node of the segment hierarchy and its children
+       * @param   begin   first edge of the node
+       * @param   end     one past the last edge of the node
+       * @return  index of the node in segment_nodes_
+       **/
+      size_t build_segment_nodes (size_t begin, size_t end);
+
+      /**
+       * Computes the crossing number parity of a point against the edge
+       * arrays
+       * @param   lat   latitude of the point
+       * @param   lon   longitude of the point
+       * @return  true if an odd number of edges cross above the point
+       **/
+      bool get_crossing_parity (double lat, double lon) const;
+
+      /// edges as arrays, edge i runs from vertex i - 1 to vertex i
+      std::vector <double> edge_lat_;
+      std::vector <double> edge_lon_;
+      std::vector <double> edge_prev_lon_;
+      std::vector <double> edge_dlat_;
+      std::vector <double> edge_dlon_;
+
+      /// vertices projected to meters from the south west corner
+      std::vector <Position> local_vertices_;
+
+      /// area in square meters
+      double area_;
+
+      /// segment hierarchy over the edges, empty for small regions
+      std::vector <Segment_Node> segment_nodes_;
     }; // class Region
 
     /**
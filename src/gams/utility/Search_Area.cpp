@@ -57,37 +57,111 @@
 #include <string>
 #include <algorithm>
 #include <vector>
-#include <set>
 #include <algorithm>
 #include <cmath>
 #include <iostream>
 
 #include "gams/utility/Region.h"
 #include "gams/utility/GPS_Position.h"
+#include "gams/utility/Local_Frame.h"
 #include "madara/utility/Utility.h"
 
 using std::cerr;
-using std::copy;
 using std::endl;
 using std::max;
-using std::set;
+using std::min;
 using std::sort;
 using std::string;
 using std::stringstream;
-using std::swap;
 using std::vector;
 
 namespace mutility = Madara::Utility;
 typedef Madara::Knowledge_Record::Integer Integer;
 
+namespace
+{
+  /**
+   * Upper limit on bucket rows and columns
+   **/
+  const size_t MAX_INDEX_SIDE = 64;
+
+  /**
+   * Orders region indices by priority from highest to lowest
+   **/
+  struct Higher_Priority
+  {
+    Higher_Priority (
+      const vector<gams::utility::Prioritized_Region> & regions) :
+      regions_ (regions)
+    {
+    }
+
+    bool operator() (size_t lhs, size_t rhs) const
+    {
+      return regions_[lhs].priority > regions_[rhs].priority;
+    }
+
+    const vector<gams::utility::Prioritized_Region> & regions_;
+  };
+
+  /**
+   * Maps a coordinate to its bucket row or column. The mapping is monotone,
+   * so a point inside a bounding box always falls between the buckets of
+   * the box corners.
+   **/
+  size_t get_bucket (double value, double origin, double size, size_t count)
+  {
+    if (size <= 0 || value <= origin)
+      return 0;
+    const double bucket = (value - origin) / size;
+    return bucket >= count ? count - 1 : size_t (bucket);
+  }
+
+  /**
+   * Orders point indices by projected coordinates, west to east and then
+   * south to north
+   **/
+  struct West_To_East
+  {
+    West_To_East (const vector<double> & east, const vector<double> & north)
+      : east_ (east), north_ (north)
+    {
+    }
+
+    bool operator() (size_t lhs, size_t rhs) const
+    {
+      return east_[lhs] < east_[rhs] ||
+        (east_[lhs] == east_[rhs] && north_[lhs] < north_[rhs]);
+    }
+
+    const vector<double> & east_;
+    const vector<double> & north_;
+  };
+
+  /**
+   * Cross product of a to b and a to c in projected coordinates
+   * @return positive if a, b, c turn counterclockwise
+   **/
+  double get_turn (const vector<double> & east, const vector<double> & north,
+    size_t a, size_t b, size_t c)
+  {
+    return (east[b] - east[a]) * (north[c] - north[a]) -
+      (north[b] - north[a]) * (east[c] - east[a]);
+  }
+}
+
 gams::utility::Search_Area::Search_Area ()
 {
+  calculate_bounding_box ();
+  build_index ();
 }
 
 gams::utility::Search_Area::Search_Area (const Prioritized_Region& region)
 {
   regions_.push_back (region);
   calculate_bounding_box ();
+  build_index ();
+  update_convex_hull (region.vertices);
 }
 
 gams::utility::Search_Area::Search_Area (
@@ -95,6 +169,13 @@ gams::utility::Search_Area::Search_Area (
   regions_ (regions)
 {
   calculate_bounding_box ();
+  build_index ();
+
+  vector<GPS_Position> points;
+  for (size_t i = 0; i < regions_.size (); ++i)
+    points.insert (points.end (),
+      regions_[i].vertices.begin (), regions_[i].vertices.end ());
+  update_convex_hull (points);
 }
 
 gams::utility::Search_Area::~Search_Area ()
@@ -113,6 +194,13 @@ gams::utility::Search_Area::operator= (const Search_Area & rhs)
     this->max_lon_ = rhs.max_lon_;
     this->min_alt_ = rhs.min_alt_;
     this->max_alt_ = rhs.max_alt_;
+    this->index_rows_ = rhs.index_rows_;
+    this->index_cols_ = rhs.index_cols_;
+    this->index_lat_size_ = rhs.index_lat_size_;
+    this->index_lon_size_ = rhs.index_lon_size_;
+    this->index_starts_ = rhs.index_starts_;
+    this->index_regions_ = rhs.index_regions_;
+    this->hull_ = rhs.hull_;
   }
 }
 
@@ -129,111 +217,91 @@ gams::utility::Search_Area::add_prioritized_region (const Prioritized_Region& r)
   max_lat_ = (max_lat_ < r.max_lat_) ? r.max_lat_ : max_lat_;
   max_lon_ = (max_lon_ < r.max_lon_) ? r.max_lon_ : max_lon_;
   max_alt_ = (max_alt_ < r.max_alt_) ? r.max_alt_ : max_alt_;
-}
-
-// sort points by angle with point, for use in get_convex_hull
-struct sort_by_angle
-{
-  const gams::utility::GPS_Position anchor;
-
-  sort_by_angle (const gams::utility::GPS_Position& p) : anchor (p) {}
 
-  bool operator() (const gams::utility::GPS_Position& gp1,
-    const gams::utility::GPS_Position& gp2)
-  {
-    gams::utility::Position p1 = gp1.to_position (anchor);
-    gams::utility::Position p2 = gp2.to_position (anchor);
-
-    double angle1 = atan2 (p1.x, p1.y) + 2 * M_PI;
-    double angle2 = atan2 (p2.x, p2.y) + 2 * M_PI;
-    
-    if (angle1 == angle2)
-      return (anchor.distance_to(gp1) < anchor.distance_to(gp2));
-    else
-      return (angle1 < angle2);
-  }
-};
+  build_index ();
+  update_convex_hull (r.vertices);
+}
 
 gams::utility::Region
 gams::utility::Search_Area::get_convex_hull () const
+{
+  return Region (hull_);
+}
+
+void
+gams::utility::Search_Area::update_convex_hull (
+  const vector<GPS_Position> & points)
 {
   /**
-   * Use Graham Scan algorithm
-   * Time complexity is O(n * log n)
-   * pseudocode at https://en.wikipedia.org/wiki/Graham_scan
+   * Use the monotone chain algorithm over the current hull and the new
+   * points. Time complexity is O(n * log n)
+   * pseudocode at https://en.wikibooks.org/wiki/Algorithm_Implementation/
+   *   Geometry/Convex_hull/Monotone_chain
    */
-  // get all points, filter out duplicates
-  set<GPS_Position> s_points;
-  for (size_t i = 0; i < regions_.size (); ++i)
-    for (size_t j = 0; j < regions_[i].vertices.size (); ++j)
-      s_points.insert (regions_[i].vertices[j]);
-  const size_t N = s_points.size ();
-
-  // create array of points
-  vector <GPS_Position> points (N + 1);
-  vector <GPS_Position>::iterator start = points.begin ();
-  ++start;
-  copy (s_points.begin (), s_points.end (), start);
-//  for (int i = 0; i < N+1; ++i)
-//    cerr << std::setprecision(10) << points[i].latitude() << " " << points[i].longitude() << endl;
-
-  // find point with lowest y/lat coord...
-  size_t lowest = 1;
-  double min_lat = points[1].latitude (); 
-  for (size_t i = 2; i <= N; ++i)
+  vector<GPS_Position> candidates (hull_);
+  candidates.insert (candidates.end (), points.begin (), points.end ());
+  const size_t n = candidates.size ();
+  hull_.clear ();
+  if (n == 0)
+    return;
+
+  // project each point once
+  vector<double> lat (n), lon (n), north (n), east (n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    lat[i] = candidates[i].latitude ();
+    lon[i] = candidates[i].longitude ();
+  }
+  Local_Frame (GPS_Position (min_lat_, min_lon_)).to_positions (
+    &lat[0], &lon[0], n, &north[0], &east[0]);
+
+  // sort west to east, then south to north
+  vector<size_t> order (n);
+  for (size_t i = 0; i < n; ++i)
+    order[i] = i;
+  sort (order.begin (), order.end (), West_To_East (east, north));
+
+  // lower chain, then upper chain, dropping collinear and duplicate points
+  vector<size_t> chain (2 * n);
+  size_t k = 0;
+  for (size_t i = 0; i < n; ++i)
   {
-    if (points[i].latitude () < min_lat)
+    while (k >= 2 && get_turn (east, north,
+      chain[k - 2], chain[k - 1], order[i]) <= 0)
     {
-      lowest = i;
-      min_lat = points[i].latitude ();
+      --k;
     }
-    else if (points[i].latitude () == min_lat)
+    chain[k++] = order[i];
+  }
+  for (size_t i = n - 1, lower = k + 1; i > 0; --i)
+  {
+    while (k >= lower && get_turn (east, north,
+      chain[k - 2], chain[k - 1], order[i - 1]) <= 0)
     {
-      // select western-most point
-      if (points[i].longitude () < points[lowest].longitude ())
-        lowest = i;
+      --k;
     }
+    chain[k++] = order[i - 1];
   }
 
-  // ...and swap with points[1]
-  swap (points[lowest], points[1]);
-  //cerr << "selected " << points[1].latitude() << " " << points[1].longitude() << " as lowest" << endl;
-
-  // sort positions
-  sort (&points[2], &points[N + 1], sort_by_angle (points[1]));
-//  cerr << "sorting points" << endl;
-//  for (int i = 0; i < N+1; ++i)
-//    cerr << points[i].latitude() << " " << points[i].longitude() << endl;
+  // the upper chain ends where the lower chain started
+  if (k > 1)
+    --k;
 
-  // copy sentinel point
-  points[0] = points[N];
-
-  // find convex hull
-  unsigned int M = 1;
-  for (unsigned int i = 2; i <= N; ++i)
+  // start from the southernmost point, west-most on ties
+  size_t lowest = 0;
+  for (size_t i = 1; i < k; ++i)
   {
-    // find next valid point on convex hull
-    while (cross (points[M - 1], points[M], points[i]) <= 0)
+    if (lat[chain[i]] < lat[chain[lowest]] ||
+      (lat[chain[i]] == lat[chain[lowest]] &&
+       lon[chain[i]] < lon[chain[lowest]]))
     {
-      if (M > 1)
-        M -= 1;
-      else if (i == N)
-        break;
-      else
-        i += 1;
+      lowest = i;
     }
-
-    // update M and swap points to the correct place
-    M += 1;
-    swap (points[M], points[i]);
   }
 
-  // fill vector of points
-  vector<GPS_Position> temp (M);
-  copy (&points[1], &points[M + 1], temp.begin ());
-//  for (vector<GPS_Position>::iterator it = temp.begin(); it != temp.end(); ++it)
-//    cerr << "\t" << it->latitude () << " " << it->longitude () << endl;
-  return Region (temp);
+  hull_.resize (k);
+  for (size_t i = 0; i < k; ++i)
+    hull_[i] = candidates[chain[(lowest + i) % k]];
 }
 
 const vector<gams::utility::Prioritized_Region>&
@@ -245,26 +313,143 @@ gams::utility::Search_Area::get_regions () const
 Madara::Knowledge_Record::Integer
 gams::utility::Search_Area::get_priority (const GPS_Position& pos) const
 {
-  Madara::Knowledge_Record::Integer priority = 0;
-  for (vector<Prioritized_Region>::const_iterator it = regions_.begin ();
-    it != regions_.end (); ++it)
+  // candidates are sorted by priority, so the first match is the highest
+  size_t begin, end;
+  if (get_candidates (pos, begin, end))
   {
-    if (it->contains (pos))
-      priority = max (priority, it->priority);
+    for (; begin < end; ++begin)
+    {
+      const Prioritized_Region & region = regions_[index_regions_[begin]];
+      if (region.priority <= 0)
+        break;
+      if (region.contains (pos))
+        return region.priority;
+    }
   }
 
-  return priority;
+  return 0;
 }
 
 bool
 gams::utility::Search_Area::contains (const GPS_Position & p) const
 {
-  for (unsigned int i = 0; i < regions_.size(); ++i)
-    if (regions_[i].contains (p))
-      return true;
+  size_t begin, end;
+  if (get_candidates (p, begin, end))
+  {
+    for (; begin < end; ++begin)
+      if (regions_[index_regions_[begin]].contains (p))
+        return true;
+  }
   return false;
 }
 
+void
+gams::utility::Search_Area::build_index ()
+{
+  index_starts_.clear ();
+  index_regions_.clear ();
+  index_rows_ = index_cols_ = 1;
+  index_lat_size_ = index_lon_size_ = 0;
+  if (regions_.empty ())
+  {
+    index_starts_.resize (2, 0);
+    return;
+  }
+
+  // buckets are about as large as the average region
+  double lat_extent = 0, lon_extent = 0;
+  for (size_t i = 0; i < regions_.size (); ++i)
+  {
+    lat_extent += regions_[i].max_lat_ - regions_[i].min_lat_;
+    lon_extent += regions_[i].max_lon_ - regions_[i].min_lon_;
+  }
+  lat_extent /= regions_.size ();
+  lon_extent /= regions_.size ();
+
+  const double lat_range = max_lat_ - min_lat_;
+  const double lon_range = max_lon_ - min_lon_;
+  if (lat_range > 0)
+  {
+    index_rows_ = lat_extent > 0 ?
+      size_t (min (lat_range / lat_extent, double (MAX_INDEX_SIDE))) :
+      MAX_INDEX_SIDE;
+    index_rows_ = max (index_rows_, size_t (1));
+    index_lat_size_ = lat_range / index_rows_;
+  }
+  if (lon_range > 0)
+  {
+    index_cols_ = lon_extent > 0 ?
+      size_t (min (lon_range / lon_extent, double (MAX_INDEX_SIDE))) :
+      MAX_INDEX_SIDE;
+    index_cols_ = max (index_cols_, size_t (1));
+    index_lon_size_ = lon_range / index_cols_;
+  }
+
+  // regions in order of priority, so each bucket inherits the order
+  vector<size_t> order (regions_.size ());
+  for (size_t i = 0; i < order.size (); ++i)
+    order[i] = i;
+  std::stable_sort (order.begin (), order.end (), Higher_Priority (regions_));
+
+  // count the regions of each bucket, then fill them
+  const size_t num_buckets = index_rows_ * index_cols_;
+  index_starts_.assign (num_buckets + 1, 0);
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    vector<size_t> next;
+    if (pass == 1)
+    {
+      for (size_t b = 0; b < num_buckets; ++b)
+        index_starts_[b + 1] += index_starts_[b];
+      index_regions_.resize (index_starts_[num_buckets]);
+      next.assign (index_starts_.begin (), index_starts_.end () - 1);
+    }
+
+    for (size_t i = 0; i < order.size (); ++i)
+    {
+      const Prioritized_Region & region = regions_[order[i]];
+      const size_t min_row = get_bucket (region.min_lat_, min_lat_,
+        index_lat_size_, index_rows_);
+      const size_t max_row = get_bucket (region.max_lat_, min_lat_,
+        index_lat_size_, index_rows_);
+      const size_t min_col = get_bucket (region.min_lon_, min_lon_,
+        index_lon_size_, index_cols_);
+      const size_t max_col = get_bucket (region.max_lon_, min_lon_,
+        index_lon_size_, index_cols_);
+      for (size_t row = min_row; row <= max_row; ++row)
+      {
+        for (size_t col = min_col; col <= max_col; ++col)
+        {
+          const size_t b = row * index_cols_ + col;
+          if (pass == 0)
+            ++index_starts_[b + 1];
+          else
+            index_regions_[next[b]++] = order[i];
+        }
+      }
+    }
+  }
+}
+
+bool
+gams::utility::Search_Area::get_candidates (const GPS_Position & p,
+  size_t & begin, size_t & end) const
+{
+  // every region lies within the bounding box of the search area
+  if (p.latitude () < min_lat_ || p.latitude () > max_lat_ ||
+      p.longitude () < min_lon_ || p.longitude () > max_lon_)
+  {
+    return false;
+  }
+
+  const size_t b = get_bucket (p.latitude (), min_lat_,
+    index_lat_size_, index_rows_) * index_cols_ +
+    get_bucket (p.longitude (), min_lon_, index_lon_size_, index_cols_);
+  begin = index_starts_[b];
+  end = index_starts_[b + 1];
+  return true;
+}
+
 string
 gams::utility::Search_Area::to_string () const
 {
@@ -292,22 +477,13 @@ gams::utility::Search_Area::calculate_bounding_box ()
   }
 }
 
-double
-gams::utility::Search_Area::cross (const GPS_Position& gp1, const GPS_Position& gp2,
-  const GPS_Position& gp3) const
-{
-  Position p1 = gp1.to_position (gp3);
-  Position p2 = gp2.to_position (gp3);
-  // p3 is (0,0) as it is the reference for p1 and p2
-  return (p2.y - p1.y) * (0 - p1.x) -
-    (p2.x- p1.x) * (0 - p1.y);
-}
-
 void
 gams::utility::Search_Area::init (
   Madara::Knowledge_Engine::Knowledge_Base & knowledge,
   const string & prefix)
 {
+  const size_t first_region = regions_.size ();
+
   // get size of search_area in number of regions
   if (mutility::begins_with (prefix, "search_area"))
   {
@@ -323,16 +499,26 @@ gams::utility::Search_Area::init (
       region << search_area_prefix << i;
 
       // get prioritized region and add to search area
-      add_prioritized_region (
+      regions_.push_back (
         parse_prioritized_region (knowledge,
           knowledge.get (region.str ()).to_string ()));
     }
   }
   else // this is just a region
   {
-    add_prioritized_region (
+    regions_.push_back (
       parse_prioritized_region (knowledge, prefix));
   }
+
+  // index the regions and merge them into the hull once they are all known
+  calculate_bounding_box ();
+  build_index ();
+
+  vector<GPS_Position> points;
+  for (size_t i = first_region; i < regions_.size (); ++i)
+    points.insert (points.end (),
+      regions_[i].vertices.begin (), regions_[i].vertices.end ());
+  update_convex_hull (points);
 }
 
 gams::utility::Search_Area
@@ -101,7 +101,8 @@ namespace gams
       void add_prioritized_region (const Prioritized_Region& r);
 
       /**
-       * Find the convex hull
+       * Find the convex hull. The hull is kept up to date as regions are
+       * added, so this only copies it.
        * @return Convex hull of the regions
        **/
       Region get_convex_hull () const;
@@ -113,7 +114,8 @@ namespace gams
       const std::vector<Prioritized_Region>& get_regions () const;
 
       /**
-       * Get priority of a gps position
+       * Get priority of a gps position. Only the regions in the bucket of
+       * the position are tested, highest priority first.
        * @param pos   position to get priority of
        * @return priority of position
        */
@@ -152,16 +154,47 @@ namespace gams
       void calculate_bounding_box ();
 
       /**
-       * Helper function for convex hull calculations
-       * @param gp1  start point
-       * @param gp2  pivot point
-       * @param gp3  end point
-       */
-      double cross (const GPS_Position& gp1, const GPS_Position& gp2, 
-        const GPS_Position& gp3) const;
+       * Builds the uniform bucket grid over the region bounding boxes. Each
+       * bucket lists the regions whose bounding box overlaps it, sorted by
+       * priority from highest to lowest.
+       **/
+      void build_index ();
+
+      /**
+       * Gets the candidate regions of a point from the bucket grid
+       * @param p       point to look up
+       * @param begin   set to the first candidate in index_regions_
+       * @param end     set to one past the last candidate
+       * @return false if the point is outside of the bounding box
+       **/
+      bool get_candidates (const GPS_Position & p,
+        size_t & begin, size_t & end) const;
+
+      /**
+       * Merges points into the convex hull with the monotone chain
+       * algorithm. The hull of the regions is the hull of the current hull
+       * and the new points, so regions can be added one at a time.
+       * @param points   points to merge
+       **/
+      void update_convex_hull (const std::vector<GPS_Position> & points);
 
       /// collection of prioritized regions
       std::vector<Prioritized_Region> regions_;
+
+      /// vertices of the convex hull, counterclockwise from the southernmost
+      std::vector<GPS_Position> hull_;
+
+      /// number of bucket rows (latitude) and columns (longitude)
+      size_t index_rows_, index_cols_;
+
+      /// size of a bucket in degrees
+      double index_lat_size_, index_lon_size_;
+
+      /// candidates of bucket b are index_starts_[b] to index_starts_[b + 1]
+      std::vector<size_t> index_starts_;
+
+      /// region indices of all buckets
+      std::vector<size_t> index_regions_;
     }; // class Search_Area
 
     /**
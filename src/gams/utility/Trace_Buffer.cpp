@@ -0,0 +1,307 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+/**
+ * @file Trace_Buffer.cpp
+ * @author James Edmondson <jedmondson@gmail.com>
+ *
+ * This file contains per-thread ring buffers of binary trace records
+ **/
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <cstring>
+
+#include "Trace_Buffer.h"
+
+#include "ace/High_Res_Timer.h"
+#include "ace/Thread_Mutex.h"
+#include "ace/Guard_T.h"
+#include "ace/TSS_T.h"
+
+bool GAMS_trace_enabled = false;
+
+namespace
+{
+  /// identifies trace files and their format version
+  const char trace_magic[8] = { 'G', 'A', 'M', 'S', 'T', 'R', 'C', '1' };
+
+  /// a record with the index of the thread that wrote it
+  struct Thread_Record
+  {
+    gams::utility::Trace_Record record;
+    uint32_t thread;
+
+    bool operator< (const Thread_Record & rhs) const
+    {
+      return record.time < rhs.record.time;
+    }
+  };
+
+  /// the calling thread's buffer, held per thread
+  struct Trace_Slot
+  {
+    Trace_Slot () : buffer (0) {}
+    gams::utility::Trace_Buffer * buffer;
+  };
+
+  /// protects the list of buffers
+  ACE_Thread_Mutex buffers_mutex;
+
+  /// the buffers of all threads that have recorded events
+  std::vector <gams::utility::Trace_Buffer *> buffers;
+
+  /// the buffer of each thread
+  ACE_TSS <Trace_Slot> slot;
+
+  template <typename T>
+  void write_value (std::ofstream & output, const T & value)
+  {
+    output.write ((const char *)&value, sizeof (value));
+  }
+
+  template <typename T>
+  bool read_value (std::ifstream & input, T & value)
+  {
+    return (bool)input.read ((char *)&value, sizeof (value));
+  }
+}
+
+gams::utility::Trace_Buffer::Trace_Buffer (uint32_t thread)
+  : next_ (0), thread_ (thread)
+{
+}
+
+void
+gams::utility::Trace_Buffer::get_records (
+  std::vector <Trace_Record> & records) const
+{
+  uint64_t first = next_ > CAPACITY ? next_ - CAPACITY : 0;
+
+  for (uint64_t i = first; i < next_; ++i)
+    records.push_back (records_[i & (CAPACITY - 1)]);
+}
+
+uint32_t
+gams::utility::Trace_Buffer::get_thread (void) const
+{
+  return thread_;
+}
+
+void
+gams::utility::Trace_Buffer::clear (void)
+{
+  next_ = 0;
+}
+
+gams::utility::Trace_Buffer *
+gams::utility::get_trace_buffer (void)
+{
+  Trace_Slot * current = slot;
+
+  if (current->buffer == 0)
+  {
+    ACE_GUARD_RETURN (ACE_Thread_Mutex, guard, buffers_mutex, 0);
+
+    current->buffer = new Trace_Buffer ((uint32_t)buffers.size ());
+    buffers.push_back (current->buffer);
+  }
+
+  return current->buffer;
+}
+
+int
+gams::utility::dump_trace (const std::string & filename)
+{
+  std::vector <Thread_Record> records;
+
+  {
+    ACE_GUARD_RETURN (ACE_Thread_Mutex, guard, buffers_mutex, -1);
+
+    std::vector <Trace_Record> thread_records;
+    for (size_t i = 0; i < buffers.size (); ++i)
+    {
+      thread_records.clear ();
+      buffers[i]->get_records (thread_records);
+
+      for (size_t j = 0; j < thread_records.size (); ++j)
+      {
+        Thread_Record entry;
+        entry.record = thread_records[j];
+        entry.thread = buffers[i]->get_thread ();
+        records.push_back (entry);
+      }
+    }
+  }
+
+  std::stable_sort (records.begin (), records.end ());
+
+  // labels are written once and referenced by index
+  std::map <const char *, uint32_t> label_indices;
+  std::vector <const char *> labels;
+  for (size_t i = 0; i < records.size (); ++i)
+  {
+    const char * label = records[i].record.label;
+    if (label_indices.find (label) == label_indices.end ())
+    {
+      label_indices[label] = (uint32_t)labels.size ();
+      labels.push_back (label);
+    }
+  }
+
+  std::ofstream output (filename.c_str (),
+    std::ios::out | std::ios::binary | std::ios::trunc);
+
+  if (!output)
+  {
+    GAMS_DEBUG (gams::utility::LOG_ERROR, (LM_DEBUG, 
+      DLINFO "gams::utility::dump_trace:" \
+      " unable to open %s\n", filename.c_str ()));
+
+    return -1;
+  }
+
+  output.write (trace_magic, sizeof (trace_magic));
+  write_value (output, (uint32_t)labels.size ());
+  write_value (output, (uint64_t)records.size ());
+
+  for (size_t i = 0; i < labels.size (); ++i)
+  {
+    uint32_t length = (uint32_t)strlen (labels[i]);
+    write_value (output, length);
+    output.write (labels[i], length);
+  }
+
+  // timer ticks are converted to nanoseconds since the first record
+  uint64_t start = records.size () > 0 ? records[0].record.time : 0;
+  uint64_t scale = ACE_High_Res_Timer::global_scale_factor ();
+  if (scale == 0)
+    scale = 1000;
+
+  for (size_t i = 0; i < records.size (); ++i)
+  {
+    const Trace_Record & record = records[i].record;
+    write_value (output, (uint64_t)((record.time - start) * 1000 / scale));
+    write_value (output, records[i].thread);
+    write_value (output, label_indices[record.label]);
+    write_value (output, record.arg0);
+    write_value (output, record.arg1);
+  }
+
+  return output ? 0 : -1;
+}
+
+int
+gams::utility::load_trace (const std::string & filename,
+  std::vector <Trace_Event> & events)
+{
+  std::ifstream input (filename.c_str (), std::ios::in | std::ios::binary);
+
+  char magic[sizeof (trace_magic)];
+  if (!input || !input.read (magic, sizeof (magic)) ||
+    memcmp (magic, trace_magic, sizeof (magic)) != 0)
+  {
+    GAMS_DEBUG (gams::utility::LOG_ERROR, (LM_DEBUG, 
+      DLINFO "gams::utility::load_trace:" \
+      " %s is not a trace file\n", filename.c_str ()));
+
+    return -1;
+  }
+
+  uint32_t num_labels (0);
+  uint64_t num_records (0);
+  if (!read_value (input, num_labels) || !read_value (input, num_records))
+    return -1;
+
+  std::vector <std::string> labels;
+  for (uint32_t i = 0; i < num_labels; ++i)
+  {
+    uint32_t length (0);
+    if (!read_value (input, length))
+      return -1;
+
+    std::string label (length, '\0');
+    if (length > 0 && !input.read (&label[0], length))
+      return -1;
+
+    labels.push_back (label);
+  }
+
+  for (uint64_t i = 0; i < num_records; ++i)
+  {
+    Trace_Event event;
+    uint32_t label (0);
+
+    if (!read_value (input, event.time) ||
+      !read_value (input, event.thread) ||
+      !read_value (input, label) ||
+      !read_value (input, event.arg0) ||
+      !read_value (input, event.arg1) ||
+      label >= labels.size ())
+    {
+      GAMS_DEBUG (gams::utility::LOG_ERROR, (LM_DEBUG, 
+        DLINFO "gams::utility::load_trace:" \
+        " %s is truncated\n", filename.c_str ()));
+
+      return -1;
+    }
+
+    event.label = labels[label];
+    events.push_back (event);
+  }
+
+  return 0;
+}
+
+void
+gams::utility::clear_trace (void)
+{
+  ACE_GUARD (ACE_Thread_Mutex, guard, buffers_mutex);
+
+  for (size_t i = 0; i < buffers.size (); ++i)
+    buffers[i]->clear ();
+}
@@ -0,0 +1,243 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+/**
+ * @file Trace_Buffer.h
+ * @author James Edmondson <jedmondson@gmail.com>
+ *
+ * This file contains per-thread ring buffers of binary trace records
+ **/
+
+#ifndef _GAMS_UTILITY_TRACE_BUFFER_H_
+#define _GAMS_UTILITY_TRACE_BUFFER_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "gams/GAMS_Export.h"
+#include "gams/utility/Logging.h"
+#include "ace/OS_NS_time.h"
+
+extern GAMS_Export bool GAMS_trace_enabled;
+
+namespace gams
+{
+  namespace utility
+  {
+    /**
+     * A trace record as it is kept in memory
+     **/
+    struct Trace_Record
+    {
+      /// the high resolution time of the record, in timer ticks
+      uint64_t time;
+
+      /// the label of the record, which must be a string literal
+      const char * label;
+
+      /// the first user argument
+      int64_t arg0;
+
+      /// the second user argument
+      int64_t arg1;
+    };
+
+    /**
+     * A trace record as it is read back from a trace file
+     **/
+    struct Trace_Event
+    {
+      /// nanoseconds since the earliest record in the file
+      uint64_t time;
+
+      /// the index of the thread that recorded the event
+      uint32_t thread;
+
+      /// the label of the record
+      std::string label;
+
+      /// the first user argument
+      int64_t arg0;
+
+      /// the second user argument
+      int64_t arg1;
+    };
+
+    /**
+     * A fixed-size ring of trace records written by a single thread.
+     * Recording never locks or allocates; once the ring is full, the
+     * oldest records are overwritten.
+     **/
+    class GAMS_Export Trace_Buffer
+    {
+    public:
+      /// the number of records kept per thread (a power of two)
+      static const uint64_t CAPACITY = 4096;
+
+      /**
+       * Constructor
+       * @param  thread   the index of the owning thread
+       **/
+      Trace_Buffer (uint32_t thread);
+
+      /**
+       * Records a trace event
+       * @param  label   a string literal that identifies the event
+       * @param  arg0    the first user argument
+       * @param  arg1    the second user argument
+       **/
+      inline void record (const char * label, int64_t arg0, int64_t arg1)
+      {
+        Trace_Record & entry = records_[next_ & (CAPACITY - 1)];
+        entry.time = ACE_OS::gethrtime ();
+        entry.label = label;
+        entry.arg0 = arg0;
+        entry.arg1 = arg1;
+        ++next_;
+      }
+
+      /**
+       * Copies the records still in the ring, oldest first
+       * @param  records   the list to append the records to
+       **/
+      void get_records (std::vector <Trace_Record> & records) const;
+
+      /**
+       * Gets the index of the owning thread
+       * @return the thread index
+       **/
+      uint32_t get_thread (void) const;
+
+      /**
+       * Discards all records
+       **/
+      void clear (void);
+
+    protected:
+      /// the ring of records
+      Trace_Record records_[CAPACITY];
+
+      /// the total number of records written
+      uint64_t next_;
+
+      /// the index of the owning thread
+      uint32_t thread_;
+    };
+
+    /**
+     * Enables or disables recording of trace events
+     * @param  enabled   true to record trace events
+     **/
+    inline void enable_tracing (bool enabled = true)
+    {
+      ::GAMS_trace_enabled = enabled;
+    }
+
+    /**
+     * Checks if trace events are being recorded
+     * @return true if trace events are recorded
+     **/
+    inline bool is_tracing (void)
+    {
+      return ::GAMS_trace_enabled;
+    }
+
+    /**
+     * Gets the trace buffer of the calling thread, creating it on first use.
+     * Buffers live until the process exits so they can be dumped after
+     * their threads finish.
+     * @return the trace buffer of the calling thread
+     **/
+    GAMS_Export Trace_Buffer * get_trace_buffer (void);
+
+    /**
+     * Records a trace event in the calling thread's buffer
+     * @param  label   a string literal that identifies the event
+     * @param  arg0    the first user argument
+     * @param  arg1    the second user argument
+     **/
+    inline void trace_event (const char * label,
+      int64_t arg0 = 0, int64_t arg1 = 0)
+    {
+      get_trace_buffer ()->record (label, arg0, arg1);
+    }
+
+    /**
+     * Writes the records of all threads to a binary trace file, ordered by
+     * time. Threads should not be recording while the trace is dumped.
+     * @param  filename   the file to write
+     * @return 0 on success, -1 if the file could not be written
+     **/
+    GAMS_Export int dump_trace (const std::string & filename);
+
+    /**
+     * Reads a binary trace file written by dump_trace
+     * @param  filename   the file to read
+     * @param  events     the list to append the events to
+     * @return 0 on success, -1 if the file could not be read
+     **/
+    GAMS_Export int load_trace (const std::string & filename,
+      std::vector <Trace_Event> & events);
+
+    /**
+     * Discards the records of all threads
+     **/
+    GAMS_Export void clear_trace (void);
+  }
+}
+
+#if defined (GAMS_NLOGGING)
+# define GAMS_TRACE_EVENT(L, LABEL, ARG0, ARG1) do {} while (0)
+#else
+# define GAMS_TRACE_EVENT(L, LABEL, ARG0, ARG1) \
+  do { \
+    if ((L) <= GAMS_MIN_LOG_LEVEL && GAMS_trace_enabled) \
+      gams::utility::trace_event (LABEL, ARG0, ARG1); \
+  } while (0)
+#endif
+
+#endif // _GAMS_UTILITY_TRACE_BUFFER_H_
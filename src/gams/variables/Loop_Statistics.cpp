@@ -0,0 +1,156 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+#include "Loop_Statistics.h"
+
+#include <cmath>
+
+typedef  Madara::Knowledge_Record::Integer  Integer;
+
+gams::variables::Loop_Statistics::Loop_Statistics ()
+{
+  reset (0.0);
+}
+
+gams::variables::Loop_Statistics::~Loop_Statistics ()
+{
+}
+
+void
+gams::variables::Loop_Statistics::operator= (const Loop_Statistics & rhs)
+{
+  if (this != &rhs)
+  {
+    this->period = rhs.period;
+    this->iterations = rhs.iterations;
+    this->overruns = rhs.overruns;
+    this->skipped = rhs.skipped;
+    this->max_lateness = rhs.max_lateness;
+    this->mean_jitter = rhs.mean_jitter;
+    this->max_jitter = rhs.max_jitter;
+
+    this->period_ = rhs.period_;
+    this->iterations_ = rhs.iterations_;
+    this->overruns_ = rhs.overruns_;
+    this->skipped_ = rhs.skipped_;
+    this->last_start_ = rhs.last_start_;
+    this->max_lateness_ = rhs.max_lateness_;
+    this->total_jitter_ = rhs.total_jitter_;
+    this->max_jitter_ = rhs.max_jitter_;
+  }
+}
+
+void
+gams::variables::Loop_Statistics::init_vars (
+  Madara::Knowledge_Engine::Knowledge_Base & knowledge,
+  const std::string & prefix)
+{
+  // initialize the variable containers
+  period.set_name (prefix + ".period", knowledge);
+  iterations.set_name (prefix + ".iterations", knowledge);
+  overruns.set_name (prefix + ".overruns", knowledge);
+  skipped.set_name (prefix + ".skipped", knowledge);
+  max_lateness.set_name (prefix + ".max_lateness", knowledge);
+  mean_jitter.set_name (prefix + ".jitter.mean", knowledge);
+  max_jitter.set_name (prefix + ".jitter.max", knowledge);
+}
+
+void
+gams::variables::Loop_Statistics::reset (double new_period)
+{
+  period_ = new_period;
+  iterations_ = 0;
+  overruns_ = 0;
+  skipped_ = 0;
+  last_start_ = 0.0;
+  max_lateness_ = 0.0;
+  total_jitter_ = 0.0;
+  max_jitter_ = 0.0;
+}
+
+void
+gams::variables::Loop_Statistics::record_start (double start, double deadline)
+{
+  // lateness is how far behind schedule the iteration started
+  double lateness = start - deadline;
+  if (lateness > max_lateness_)
+    max_lateness_ = lateness;
+
+  // jitter is the deviation of the start-to-start interval from the period
+  if (iterations_ > 0)
+  {
+    double jitter = fabs ((start - last_start_) - period_);
+    total_jitter_ += jitter;
+    if (jitter > max_jitter_)
+      max_jitter_ = jitter;
+  }
+
+  last_start_ = start;
+  ++iterations_;
+}
+
+void
+gams::variables::Loop_Statistics::record_overrun (unsigned int num_skipped)
+{
+  ++overruns_;
+  skipped_ += num_skipped;
+}
+
+void
+gams::variables::Loop_Statistics::publish (void)
+{
+  period = period_;
+  iterations = iterations_;
+  overruns = overruns_;
+  skipped = skipped_;
+  max_lateness = max_lateness_;
+  max_jitter = max_jitter_;
+
+  if (iterations_ > 1)
+    mean_jitter = total_jitter_ / (iterations_ - 1);
+  else
+    mean_jitter = 0.0;
+}
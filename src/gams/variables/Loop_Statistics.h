@@ -0,0 +1,174 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+/**
+ * @file Loop_Statistics.h
+ * @author James Edmondson <jedmondson@gmail.com>
+ *
+ * This file contains the definition of the controller loop timing variables
+ **/
+
+#ifndef   _GAMS_VARIABLES_LOOP_STATISTICS_H_
+#define   _GAMS_VARIABLES_LOOP_STATISTICS_H_
+
+#include <string>
+
+#include "gams/GAMS_Export.h"
+#include "madara/knowledge_engine/containers/Integer.h"
+#include "madara/knowledge_engine/containers/Double.h"
+#include "madara/knowledge_engine/Knowledge_Base.h"
+
+namespace gams
+{
+  namespace variables
+  {
+    /**
+     * Timing statistics of a periodic control loop. Samples are accumulated
+     * locally on every iteration and only written to the knowledge base
+     * when publish is called, so recording stays cheap.
+     **/
+    class GAMS_Export Loop_Statistics
+    {
+    public:
+      /**
+       * Constructor
+       **/
+      Loop_Statistics ();
+
+      /**
+       * Destructor
+       **/
+      ~Loop_Statistics ();
+
+      /**
+       * Assignment operator
+       * @param  rhs   value to copy
+       **/
+      void operator= (const Loop_Statistics & rhs);
+
+      /**
+       * Initializes variable containers
+       * @param   knowledge  the knowledge base that houses the variables
+       * @param   prefix     the variable prefix (local variables by default)
+       **/
+      void init_vars (Madara::Knowledge_Engine::Knowledge_Base & knowledge,
+        const std::string & prefix = ".gams.perf.loop");
+
+      /**
+       * Clears all accumulated samples
+       * @param   new_period  the intended loop period in seconds
+       **/
+      void reset (double new_period);
+
+      /**
+       * Records the start of a loop iteration
+       * @param   start     time the iteration actually started, in seconds
+       * @param   deadline  time the iteration was scheduled to start
+       **/
+      void record_start (double start, double deadline);
+
+      /**
+       * Records an iteration that finished after the next deadline
+       * @param   skipped   number of deadlines dropped because of the overrun
+       **/
+      void record_overrun (unsigned int skipped = 0);
+
+      /**
+       * Writes the accumulated statistics to the knowledge base
+       **/
+      void publish (void);
+
+      /// the intended period of the loop in seconds
+      Madara::Knowledge_Engine::Containers::Double period;
+
+      /// number of iterations executed
+      Madara::Knowledge_Engine::Containers::Integer iterations;
+
+      /// number of iterations that finished after the following deadline
+      Madara::Knowledge_Engine::Containers::Integer overruns;
+
+      /// number of deadlines dropped by the skip overrun policy
+      Madara::Knowledge_Engine::Containers::Integer skipped;
+
+      /// worst-case lateness of an iteration start, in seconds
+      Madara::Knowledge_Engine::Containers::Double max_lateness;
+
+      /// mean absolute deviation of the start-to-start interval from period
+      Madara::Knowledge_Engine::Containers::Double mean_jitter;
+
+      /// maximum absolute deviation of the start-to-start interval
+      Madara::Knowledge_Engine::Containers::Double max_jitter;
+
+    protected:
+
+      /// intended period of the loop
+      double period_;
+
+      /// number of iterations started
+      Madara::Knowledge_Record::Integer iterations_;
+
+      /// number of overruns
+      Madara::Knowledge_Record::Integer overruns_;
+
+      /// number of skipped deadlines
+      Madara::Knowledge_Record::Integer skipped_;
+
+      /// start of the previous iteration
+      double last_start_;
+
+      /// worst-case lateness
+      double max_lateness_;
+
+      /// sum of all jitter samples
+      double total_jitter_;
+
+      /// worst-case jitter
+      double max_jitter_;
+    };
+  }
+}
+
+#endif // _GAMS_VARIABLES_LOOP_STATISTICS_H_
@@ -51,6 +51,16 @@
 #include <vector>
 #include <string>
 #include <cmath>
+#include <algorithm>
+#include <stdlib.h>
+
+#include "gams/maps/Tile_Codec.h"
+#include "gams/utility/Logging.h"
+
+#include "ace/Task.h"
+#include "ace/Atomic_Op.h"
+#include "ace/Thread_Mutex.h"
+#include "ace/OS_NS_unistd.h"
 
 using std::string;
 using std::stringstream;
@@ -58,15 +68,261 @@ using std::vector;
 
 typedef  Madara::Knowledge_Record::Integer  Integer;
 
+namespace
+{
+  /// mean radius of the Earth, as used by GPS_Position
+  const double EARTH_RADIUS = 6371000.0;
+
+  /// sends with new writes after which an agent that sent no change
+  /// record is no longer waited for
+  const uint64_t MAX_SILENT_SENDS = 16;
+
+  /// most cells of earlier sends that wait in a change record for
+  /// acknowledgement
+  const size_t MAX_CHANGE_CELLS = 4096;
+
+  /// index of the row nearest to a latitude
+  int nearest_x (const gams::variables::Sensor_Frame & frame, double latitude)
+  {
+    const double step = frame.get_latitude (1) - frame.get_latitude (0);
+    return (int)floor ((latitude - frame.get_origin ().latitude ()) / step
+      + 0.5);
+  }
+
+  /// index of the column nearest to a longitude
+  int nearest_y (const gams::variables::Sensor_Frame & frame, double longitude)
+  {
+    const double step = frame.get_longitude (1) - frame.get_longitude (0);
+    return (int)floor ((longitude - frame.get_origin ().longitude ()) / step
+      + 0.5);
+  }
+
+  /**
+   * Rasterizes a region with an edge-table scanline. Each column of cells
+   * is a line of constant longitude. The edges that cross it are the same
+   * edges that the even-odd test in Region::contains counts, at the same
+   * latitudes. Between sorted pairs of crossings lies a span of cells
+   * inside the region, which is emitted without testing each cell.
+   * Cell centers are computed by the frame with the same arithmetic as
+   * Sensor::get_gps_from_index, so the cells agree exactly with
+   * Region::contains on the cell centers.
+   * @param region   the region to rasterize
+   * @param frame    the frame of the cells
+   * @param cells    list to append the inside cells to
+   **/
+  void rasterize (const gams::utility::Region & region,
+    const gams::variables::Sensor_Frame & frame,
+    vector<gams::utility::Position> & cells)
+  {
+    const vector<gams::utility::GPS_Position> & vertices = region.vertices;
+    if (vertices.size () < 3 || frame.get_discretization () <= 0)
+      return;
+
+    vector<double> crossings;
+
+    const int min_y = nearest_y (frame, region.min_lon_) - 1;
+    const int max_y = nearest_y (frame, region.max_lon_) + 1;
+    for (int y = min_y; y <= max_y; ++y)
+    {
+      const double lon = frame.get_longitude (y);
+      if (lon < region.min_lon_ || lon > region.max_lon_)
+        continue;
+
+      // the edge table for this column
+      crossings.clear ();
+      for (size_t i = 0, j = vertices.size () - 1; i < vertices.size (); j = i++)
+      {
+        const gams::utility::GPS_Position & vi = vertices[i];
+        const gams::utility::GPS_Position & vj = vertices[j];
+        if ((vi.longitude () > lon) != (vj.longitude () > lon))
+        {
+          crossings.push_back ((vj.latitude () - vi.latitude ()) *
+            (lon - vi.longitude ()) / (vj.longitude () - vi.longitude ()) +
+            vi.latitude ());
+        }
+      }
+      std::sort (crossings.begin (), crossings.end ());
+
+      // a point is inside if an odd number of crossings lie above it
+      for (size_t k = 0; k + 1 < crossings.size (); k += 2)
+      {
+        const double low = crossings[k];
+        const double high = crossings[k + 1];
+
+        int x = nearest_x (frame, low);
+        while (frame.get_latitude (x - 1) >= low)
+          --x;
+        while (frame.get_latitude (x) < low)
+          ++x;
+
+        for (double lat = frame.get_latitude (x); lat < high;
+          lat = frame.get_latitude (++x))
+        {
+          if (lat >= region.min_lat_ && lat <= region.max_lat_)
+            cells.push_back (gams::utility::Position (x, y));
+        }
+      }
+    }
+
+    // Region::contains also accepts points that are exactly vertices
+    for (size_t i = 0; i < vertices.size (); ++i)
+    {
+      const int x = nearest_x (frame, vertices[i].latitude ());
+      const int y = nearest_y (frame, vertices[i].longitude ());
+      if (frame.get_latitude (x) == vertices[i].latitude () &&
+        frame.get_longitude (y) == vertices[i].longitude () &&
+        frame.get_origin ().altitude () == vertices[i].altitude ())
+      {
+        cells.push_back (gams::utility::Position (x, y));
+      }
+    }
+  }
+
+  /**
+   * Rasterizes the regions of a search area, one region at a time per
+   * thread
+   **/
+  class Raster_Task : public ACE_Task_Base
+  {
+  public:
+    Raster_Task (const vector<gams::utility::Prioritized_Region> & regions,
+      const gams::variables::Sensor_Frame & frame)
+      : cells (regions.size ()), regions_ (regions), frame_ (frame),
+      next_ (0)
+    {
+    }
+
+    virtual int svc (void)
+    {
+      for (size_t i = next_++; i < regions_.size (); i = next_++)
+        rasterize (regions_[i], frame_, cells[i]);
+
+      return 0;
+    }
+
+    /// the cells of each region
+    vector<vector<gams::utility::Position> > cells;
+
+  private:
+    const vector<gams::utility::Prioritized_Region> & regions_;
+    const gams::variables::Sensor_Frame frame_;
+    ACE_Atomic_Op<ACE_Thread_Mutex, size_t> next_;
+  };
+}
+
+gams::variables::Sensor_Frame::Sensor_Frame () :
+  origin_ (0, 0, 0), range_ (0.0), discretization_ (0.0),
+  lat_circumference_ (2 * EARTH_RADIUS * M_PI),
+  lon_circumference_ (2 * EARTH_RADIUS * M_PI)
+{
+}
+
+gams::variables::Sensor_Frame::Sensor_Frame (
+  const utility::GPS_Position & origin, double range) :
+  origin_ (origin), range_ (range),
+  discretization_ (sqrt (2.0 * pow (range, 2.0))),
+  lat_circumference_ (2 * EARTH_RADIUS * M_PI)
+{
+  // the same terms as GPS_Position::to_gps_position, computed once
+  double r_prime = EARTH_RADIUS * cos (origin.latitude () * M_PI / 180.0);
+  lon_circumference_ = 2 * r_prime * M_PI;
+}
+
+bool
+gams::variables::Sensor_Frame::matches (
+  const utility::GPS_Position & origin, double range) const
+{
+  return origin_ == origin && range_ == range;
+}
+
+double
+gams::variables::Sensor_Frame::get_discretization () const
+{
+  return discretization_;
+}
+
+const gams::utility::GPS_Position &
+gams::variables::Sensor_Frame::get_origin () const
+{
+  return origin_;
+}
+
+double
+gams::variables::Sensor_Frame::get_range () const
+{
+  return range_;
+}
+
+double
+gams::variables::Sensor_Frame::get_latitude (int x) const
+{
+  return x * discretization_ * 360.0 / lat_circumference_ +
+    origin_.latitude ();
+}
+
+double
+gams::variables::Sensor_Frame::get_longitude (int y) const
+{
+  return y * discretization_ / lon_circumference_ * 360 +
+    origin_.longitude ();
+}
+
+gams::utility::GPS_Position
+gams::variables::Sensor_Frame::get_gps (const utility::Position & idx) const
+{
+  return utility::GPS_Position (get_latitude (int(idx.x)),
+    get_longitude (int(idx.y)), origin_.altitude () + int(idx.z));
+}
+
+gams::utility::Position
+gams::variables::Sensor_Frame::get_index (
+  const utility::GPS_Position & pos) const
+{
+  utility::Position idx (
+    (pos.latitude () - origin_.latitude ()) / 360.0 * lat_circumference_,
+    (pos.longitude () - origin_.longitude ()) / 360.0 * lon_circumference_,
+    pos.altitude () - origin_.altitude ());
+  idx.x = (int)((idx.x + discretization_ / 2) / discretization_);
+  idx.y = (int)((idx.y + discretization_ / 2) / discretization_);
+
+  return idx;
+}
+
+void
+gams::variables::Sensor_Frame::get_gps (
+  const std::vector <utility::Position> & indices,
+  std::vector <utility::GPS_Position> & result) const
+{
+  result.resize (indices.size ());
+  for (size_t i = 0; i < indices.size (); ++i)
+    result[i] = get_gps (indices[i]);
+}
+
+void
+gams::variables::Sensor_Frame::get_index (
+  const std::vector <utility::GPS_Position> & positions,
+  std::vector <utility::Position> & result) const
+{
+  result.resize (positions.size ());
+  for (size_t i = 0; i < positions.size (); ++i)
+    result[i] = get_index (positions[i]);
+}
+
 gams::variables::Sensor::Sensor () :
-  knowledge_ (0), name_ ("")
+  knowledge_ (0), name_ (""), cache_frame_ (false), dense_min_x_ (0),
+  dense_min_y_ (0),
+  dense_width_ (0), dense_height_ (0), sequence_ (0), unsent_ (false),
+  send_acks_ (false)
 {
 }
 
 gams::variables::Sensor::Sensor (const string & name,
   Madara::Knowledge_Engine::Knowledge_Base * knowledge,
   const double & range, const utility::GPS_Position & origin) :
-  knowledge_ (knowledge), name_ (name)
+  knowledge_ (knowledge), name_ (name), cache_frame_ (false),
+  dense_min_x_ (0), dense_min_y_ (0),
+  dense_width_ (0), dense_height_ (0), sequence_ (0), unsent_ (false),
+  send_acks_ (false)
 {
   init_vars ();
 
@@ -90,6 +346,26 @@ gams::variables::Sensor::operator= (const Sensor & rhs)
     this->origin_ = rhs.origin_;
     this->knowledge_ = rhs.knowledge_;
     this->name_ = rhs.name_;
+    this->cache_frame_ = rhs.cache_frame_;
+    this->frame_ = rhs.frame_;
+    this->dense_min_x_ = rhs.dense_min_x_;
+    this->dense_min_y_ = rhs.dense_min_y_;
+    this->dense_width_ = rhs.dense_width_;
+    this->dense_height_ = rhs.dense_height_;
+    this->dense_values_ = rhs.dense_values_;
+    this->dense_refs_ = rhs.dense_refs_;
+    this->dense_dirty_ = rhs.dense_dirty_;
+    this->dirty_cells_ = rhs.dirty_cells_;
+    this->sync_ = rhs.sync_;
+    this->changes_ = rhs.changes_;
+    this->versions_ = rhs.versions_;
+    this->sequence_ = rhs.sequence_;
+    this->unsent_ = rhs.unsent_;
+    this->applied_ = rhs.applied_;
+    this->acks_ = rhs.acks_;
+    this->heard_ = rhs.heard_;
+    this->send_acks_ = rhs.send_acks_;
+    this->received_ = rhs.received_;
   }
 }
 
@@ -99,77 +375,9 @@ gams::variables::Sensor::discretize (
 {
   set<utility::Position> ret_val;
 
-  // find northern most point
-  utility::GPS_Position northern = region.vertices[0];
-  for (size_t i = 1; i < region.vertices.size (); ++i)
-    if (northern.latitude () < region.vertices[i].latitude ())
-      northern = region.vertices[i];
-  const int max_x = get_index_from_gps (northern).x;
-
-  // find southern most point
-  utility::GPS_Position southern = region.vertices[0];
-  for (size_t i = 1; i < region.vertices.size (); ++i)
-    if (southern.latitude () > region.vertices[i].latitude ())
-      southern = region.vertices[i];
-  const int min_x = get_index_from_gps (southern).x;
-
-  // find west most point 
-  utility::GPS_Position start;
-  start.longitude (DBL_MAX);
-  for (size_t i = 0; i < region.vertices.size (); ++i)
-    if (start.longitude () > region.vertices[i].longitude ())
-      start = region.vertices[i];
-
-  // find valid corresponding position
-  utility::Position start_index = get_index_from_gps (start);
-  if (!region.contains (get_gps_from_index (start_index)))
-  {
-    ++start_index.y; // go one east...
-    utility::Position check = start_index;
-    while ((!region.contains (get_gps_from_index (check))) &&
-      check.x <= max_x)
-    {
-      ++check.x; // ... and start looking north for position in region
-    }
-
-    // if we still haven't found a good position...
-    if (!region.contains (get_gps_from_index (check)))
-    {
-      // ...start looking south
-      check = start_index;
-      while ((!region.contains (get_gps_from_index (check))) &&
-        check.x >= min_x)
-      {
-        --check.x;
-      }
-    }
-
-    // by now we must have found a starting position, so update start_index
-    start_index = check;
-  }
-
-  // find east most point
-  utility::GPS_Position eastern = region.vertices[0];
-  for (size_t i = 1; i < region.vertices.size (); ++i)
-    if (eastern.longitude () < region.vertices[i].longitude ())
-      eastern = region.vertices[i];
-  const int max_y = get_index_from_gps (eastern).y;
-
-  // move east each iteration
-  while (start_index.y < max_y)
-  {
-    // check north
-    for (utility::Position pos = start_index; pos.x <= max_x; ++pos.x)
-      if (region.contains (get_gps_from_index (pos)))
-        ret_val.insert (pos);
-  
-    // check south
-    for (utility::Position pos = start_index; pos.x >= min_x; --pos.x)
-      if (region.contains (get_gps_from_index (pos)))
-        ret_val.insert (pos);
-
-    ++start_index.y;
-  }
+  vector<utility::Position> cells;
+  rasterize (region, get_frame (), cells);
+  ret_val.insert (cells.begin (), cells.end ());
 
   return ret_val;
 }
@@ -180,17 +388,38 @@ gams::variables::Sensor::discretize (
 {
   set<utility::Position> ret_val;
   const vector<utility::Prioritized_Region>& regions = search.get_regions ();
-  for (size_t i = 0; i < regions.size (); ++i)
+  if (regions.empty ())
+    return ret_val;
+
+  // the frame is read from the knowledge base once, before any threads
+  Raster_Task task (regions, get_frame ());
+
+  size_t threads = (size_t)ACE_OS::num_processors_online ();
+  if (threads > regions.size ())
+    threads = regions.size ();
+
+  if (threads > 1)
   {
-    set<utility::Position> to_add = discretize (regions[i]);
-    ret_val.insert (to_add.begin (), to_add.end ());
+    task.activate (THR_NEW_LWP | THR_JOINABLE, (int)threads);
+    task.wait ();
   }
+  else
+  {
+    task.svc ();
+  }
+
+  for (size_t i = 0; i < task.cells.size (); ++i)
+    ret_val.insert (task.cells[i].begin (), task.cells[i].end ());
+
   return ret_val;
 }
 
 double
 gams::variables::Sensor::get_discretization () const
 {
+  if (cache_frame_)
+    return frame_.get_discretization ();
+
   return sqrt (2.0 * pow(get_range (), 2.0));
 }
 
@@ -198,6 +427,9 @@ gams::utility::GPS_Position
 gams::variables::Sensor::get_gps_from_index (
   const utility::Position & idx)
 {
+  if (cache_frame_)
+    return frame_.get_gps (idx);
+
   const double discretize = get_discretization ();
   utility::Position meters (
     int(idx.x) * discretize, int(idx.y) * discretize, int(idx.z));
@@ -212,6 +444,9 @@ gams::utility::Position
 gams::variables::Sensor::get_index_from_gps (
   const utility::GPS_Position & pos)
 {
+  if (cache_frame_)
+    return frame_.get_index (pos);
+
   utility::GPS_Position origin;
   origin.from_container (origin_);
   utility::Position idx = pos.to_position (origin);
@@ -222,6 +457,69 @@ gams::variables::Sensor::get_index_from_gps (
   return idx;
 }
 
+void
+gams::variables::Sensor::get_gps_from_index (
+  const vector<utility::Position> & indices,
+  vector<utility::GPS_Position> & result)
+{
+  if (cache_frame_)
+    frame_.get_gps (indices, result);
+  else
+    get_frame ().get_gps (indices, result);
+}
+
+void
+gams::variables::Sensor::get_index_from_gps (
+  const vector<utility::GPS_Position> & positions,
+  vector<utility::Position> & result)
+{
+  if (cache_frame_)
+  {
+    frame_.get_index (positions, result);
+  }
+  else
+  {
+    // keep the per-point conversion of the uncached mode
+    result.resize (positions.size ());
+    for (size_t i = 0; i < positions.size (); ++i)
+      result[i] = get_index_from_gps (positions[i]);
+  }
+}
+
+void
+gams::variables::Sensor::set_frame_caching (bool enabled)
+{
+  cache_frame_ = enabled;
+
+  if (enabled)
+    frame_ = Sensor_Frame (get_origin (), get_range ());
+}
+
+bool
+gams::variables::Sensor::refresh_frame ()
+{
+  if (!cache_frame_)
+    return false;
+
+  utility::GPS_Position origin = get_origin ();
+  double range = get_range ();
+
+  if (frame_.matches (origin, range))
+    return false;
+
+  frame_ = Sensor_Frame (origin, range);
+  return true;
+}
+
+gams::variables::Sensor_Frame
+gams::variables::Sensor::get_frame ()
+{
+  if (cache_frame_)
+    return frame_;
+
+  return Sensor_Frame (get_origin (), get_range ());
+}
+
 string
 gams::variables::Sensor::get_name () const
 {
@@ -251,19 +549,35 @@ gams::variables::Sensor::get_value (const utility::GPS_Position & pos)
 double
 gams::variables::Sensor::get_value (const utility::Position & pos)
 {
+  size_t index;
+  if (get_dense_index (pos, index))
+    return dense_values_[index];
+
   return value_[index_pos_to_index (pos)].to_double ();
 }
 
+Madara::Knowledge_Record
+gams::variables::Sensor::get_record (const utility::Position & pos)
+{
+  size_t index;
+  if (get_dense_index (pos, index))
+    return knowledge_->get_context ().get (dense_refs_[index]);
+
+  return value_[index_pos_to_index (pos)];
+}
+
 void
 gams::variables::Sensor::set_origin (const utility::GPS_Position & origin)
 {
   origin.to_container (origin_);
+  refresh_frame ();
 }
 
 void
 gams::variables::Sensor::set_range (const double & range)
 {
   range_ = range;
+  refresh_frame ();
 }
 
 void
@@ -279,8 +593,457 @@ gams::variables::Sensor::set_value (const utility::Position & pos,
   const double & val,
   const Madara::Knowledge_Engine::Knowledge_Update_Settings & settings)
 {
-  string idx = index_pos_to_index (pos);
-  value_.set (idx, val, settings);
+  if (sync_ != 0.0 && !settings.treat_globals_as_locals)
+  {
+    // the change goes out with the next send_changes instead
+    static const Madara::Knowledge_Engine::Knowledge_Update_Settings
+      LOCAL (true, false);
+    changes_.set ((int)pos.x, (int)pos.y, val);
+    versions_.set ((int)pos.x, (int)pos.y, (double)(sequence_ + 1));
+    unsent_ = true;
+
+    size_t index;
+    if (get_dense_index (pos, index))
+    {
+      dense_values_[index] = val;
+      knowledge_->get_context ().set (dense_refs_[index], val, LOCAL);
+    }
+    else
+    {
+      value_.set (index_pos_to_index (pos), val, LOCAL);
+    }
+    return;
+  }
+
+  size_t index;
+  if (get_dense_index (pos, index))
+  {
+    dense_values_[index] = val;
+
+    if (settings.treat_globals_as_locals)
+    {
+      // local-only writes wait for push_values
+      if (!dense_dirty_[index])
+      {
+        dense_dirty_[index] = 1;
+        dirty_cells_.push_back (index);
+      }
+    }
+    else
+    {
+      knowledge_->get_context ().set (dense_refs_[index], val, settings);
+      dense_dirty_[index] = 0;
+    }
+  }
+  else
+  {
+    string idx = index_pos_to_index (pos);
+    value_.set (idx, val, settings);
+  }
+}
+
+void
+gams::variables::Sensor::use_dense_storage (
+  const set<utility::Position> & cells)
+{
+  dense_values_.clear ();
+  dense_refs_.clear ();
+  dense_dirty_.clear ();
+  dirty_cells_.clear ();
+  dense_width_ = 0;
+  dense_height_ = 0;
+
+  if (cells.empty ())
+    return;
+
+  // find the bounding box of the cells
+  int max_x = (int)cells.begin ()->x;
+  int max_y = (int)cells.begin ()->y;
+  dense_min_x_ = max_x;
+  dense_min_y_ = max_y;
+  for (set<utility::Position>::const_iterator it = cells.begin ();
+    it != cells.end (); ++it)
+  {
+    if ((int)it->x < dense_min_x_)
+      dense_min_x_ = (int)it->x;
+    if ((int)it->x > max_x)
+      max_x = (int)it->x;
+    if ((int)it->y < dense_min_y_)
+      dense_min_y_ = (int)it->y;
+    if ((int)it->y > max_y)
+      max_y = (int)it->y;
+  }
+
+  dense_width_ = max_x - dense_min_x_ + 1;
+  dense_height_ = max_y - dense_min_y_ + 1;
+
+  const size_t size = (size_t)dense_width_ * dense_height_;
+  dense_values_.assign (size, 0.0);
+  dense_refs_.resize (size);
+  dense_dirty_.assign (size, 0);
+
+  // resolve the variables of the cells once, so no keys are built later
+  Madara::Knowledge_Engine::Thread_Safe_Context & context =
+    knowledge_->get_context ();
+  const string prefix = "sensor." + name_ + ".covered.";
+  for (set<utility::Position>::const_iterator it = cells.begin ();
+    it != cells.end (); ++it)
+  {
+    size_t index = (size_t)((int)it->y - dense_min_y_) * dense_width_ +
+      ((int)it->x - dense_min_x_);
+    dense_refs_[index] = context.get_ref (prefix + index_pos_to_index (*it));
+  }
+
+  pull_values ();
+}
+
+bool
+gams::variables::Sensor::has_dense_storage () const
+{
+  return dense_width_ > 0;
+}
+
+void
+gams::variables::Sensor::pull_values ()
+{
+  if (dense_width_ == 0)
+    return;
+
+  Madara::Knowledge_Engine::Thread_Safe_Context & context =
+    knowledge_->get_context ();
+  context.lock ();
+  for (size_t i = 0; i < dense_values_.size (); ++i)
+  {
+    if (dense_refs_[i].is_valid () && !dense_dirty_[i])
+      dense_values_[i] = context.get (dense_refs_[i]).to_double ();
+  }
+  context.unlock ();
+}
+
+void
+gams::variables::Sensor::push_values (
+  const Madara::Knowledge_Engine::Knowledge_Update_Settings & settings)
+{
+  if (dirty_cells_.empty ())
+    return;
+
+  Madara::Knowledge_Engine::Thread_Safe_Context & context =
+    knowledge_->get_context ();
+  context.lock ();
+  for (size_t i = 0; i < dirty_cells_.size (); ++i)
+  {
+    const size_t index = dirty_cells_[i];
+
+    // cells written through since they were marked are already current
+    if (dense_dirty_[index])
+    {
+      context.set (dense_refs_[index], dense_values_[index], settings);
+      dense_dirty_[index] = 0;
+    }
+  }
+  context.unlock ();
+
+  dirty_cells_.clear ();
+}
+
+void
+gams::variables::Sensor::set_change_sync (double scale)
+{
+  sync_ = scale;
+  changes_.clear ();
+  versions_.clear ();
+  unsent_ = false;
+}
+
+bool
+gams::variables::Sensor::has_change_sync () const
+{
+  return sync_ != 0.0;
+}
+
+size_t
+gams::variables::Sensor::send_changes (
+  const Madara::Knowledge_Engine::Eval_Settings & settings)
+{
+  if (sync_ == 0.0)
+    return 0;
+
+  // writes since the last send go out under a new sequence number
+  if (unsent_)
+  {
+    ++sequence_;
+    unsent_ = false;
+  }
+
+  const Madara::Knowledge_Record self_id = knowledge_->get (".id");
+  const Integer self = self_id.to_integer ();
+  const Integer size = knowledge_->get ("swarm.size").to_integer ();
+
+  // cells stay in the record until every other agent has applied them,
+  // except agents that have been silent for too long
+  bool has_peers (false);
+  uint64_t acked (sequence_);
+  for (Integer id = 0; id < size; ++id)
+  {
+    if (id == self)
+      continue;
+
+    std::map <uint64_t, uint64_t>::const_iterator heard = heard_.find (id);
+    if (sequence_ - (heard == heard_.end () ? 0 : heard->second) >
+      MAX_SILENT_SENDS)
+      continue;
+
+    has_peers = true;
+    std::map <uint64_t, uint64_t>::const_iterator ack = acks_.find (id);
+    acked = std::min (acked, ack == acks_.end () ? 0 : ack->second);
+  }
+  if (has_peers)
+    prune_changes (acked);
+
+  if (changes_.get_tiles ().empty () && !send_acks_)
+    return 0;
+
+  std::vector <unsigned char> buffer;
+  maps::encode_varint (sequence_, buffer);
+  maps::encode_varint (applied_.size (), buffer);
+  for (std::map <uint64_t, uint64_t>::const_iterator i = applied_.begin ();
+    i != applied_.end (); ++i)
+  {
+    maps::encode_varint (i->first, buffer);
+    maps::encode_varint (i->second, buffer);
+  }
+
+  std::vector <unsigned char> values;
+  const size_t cells = maps::encode_changes (changes_, sync_.to_double (),
+    values);
+  maps::encode_varint (values.size (), buffer);
+  buffer.insert (buffer.end (), values.begin (), values.end ());
+  maps::encode_changes (versions_, 1.0, buffer);
+
+  const string key = "sensor." + name_ + ".changes." + self_id.to_string ();
+  knowledge_->set_file (key, &buffer[0], buffer.size (), settings);
+  send_acks_ = false;
+
+  // without other agents, there is no one to wait for
+  if (!has_peers)
+    prune_changes (sequence_);
+
+  GAMS_DEBUG (gams::utility::LOG_DETAILED_TRACE, (LM_DEBUG, 
+    DLINFO "gams::variables::Sensor::send_changes:" \
+    " sent %d cells in %d bytes\n", (int)cells, (int)buffer.size ()));
+
+  return cells;
+}
+
+size_t
+gams::variables::Sensor::receive_changes (
+  std::vector <utility::Position> * cells)
+{
+  if (sync_ == 0.0)
+    return 0;
+
+  size_t result (0);
+  const string prefix = "sensor." + name_ + ".changes.";
+
+  knowledge_->lock ();
+
+  const uint64_t self = (uint64_t)knowledge_->get (".id").to_integer ();
+
+  std::map <std::string, Madara::Knowledge_Record> records =
+    knowledge_->to_map (prefix);
+
+  for (std::map <std::string, Madara::Knowledge_Record>::iterator i =
+    records.begin (); i != records.end (); ++i)
+  {
+    const uint64_t sender =
+      strtoul (i->first.c_str () + prefix.size (), 0, 10);
+    if (sender == self)
+      continue;
+
+    // skip records that have not changed since the last receive
+    std::map <std::string, uint64_t>::iterator previous =
+      received_.find (i->first);
+    if (previous != received_.end () && previous->second == i->second.clock)
+      continue;
+
+    size_t size;
+    unsigned char * buffer = i->second.to_unmanaged_buffer (size);
+    const unsigned char * current = buffer;
+    const unsigned char * end = buffer + size;
+
+    uint64_t sequence, count, bytes;
+    std::map <uint64_t, uint64_t> acks;
+    bool valid = maps::decode_varint (current, end, sequence) &&
+      maps::decode_varint (current, end, count);
+    for (uint64_t j = 0; valid && j < count; ++j)
+    {
+      uint64_t id, applied;
+      valid = maps::decode_varint (current, end, id) &&
+        maps::decode_varint (current, end, applied);
+      acks[id] = applied;
+    }
+    valid = valid && maps::decode_varint (current, end, bytes) &&
+      bytes <= (uint64_t)(end - current);
+
+    maps::Grid_Layer <double> values;
+    maps::Grid_Layer <double> versions;
+    valid = valid &&
+      maps::decode_changes (current, (size_t)bytes, sync_.to_double (),
+        values) >= 0 &&
+      maps::decode_changes (current + bytes, end - current - bytes, 1.0,
+        versions) >= 0;
+    delete [] buffer;
+
+    if (!valid)
+    {
+      GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
+        DLINFO "gams::variables::Sensor::receive_changes:" \
+        " ignoring malformed record %s\n", i->first.c_str ()));
+      continue;
+    }
+    received_[i->first] = i->second.clock;
+    heard_[sender] = sequence_;
+
+    // the sender tells us how much of our own changes it has applied
+    std::map <uint64_t, uint64_t>::const_iterator ack = acks.find (self);
+    if (ack != acks.end () && ack->second > acks_[sender])
+      acks_[sender] = ack->second;
+
+    uint64_t & applied = applied_[sender];
+
+    const maps::Grid_Layer <double>::Tile_Map & tiles = versions.get_tiles ();
+    for (maps::Grid_Layer <double>::Tile_Map::const_iterator tile =
+      tiles.begin (); tile != tiles.end (); ++tile)
+    {
+      const int min_x = maps::get_tile_x (tile->first);
+      const int min_y = maps::get_tile_y (tile->first);
+      for (int j = 0; j < maps::TILE_CELLS; ++j)
+      {
+        if ((tile->second->dirty[j >> 6] >> (j & 63) & 1) == 0 ||
+          (uint64_t)tile->second->values[j] <= applied)
+          continue;
+
+        const int x = min_x + (j & (maps::TILE_SIZE - 1));
+        const int y = min_y + (j >> maps::TILE_BITS);
+        if (changes_.is_dirty (x, y) && versions_.get (x, y) > sequence_)
+          continue;
+
+        apply_value (utility::Position (x, y), values.get (x, y));
+        if (cells)
+          cells->push_back (utility::Position (x, y));
+        ++result;
+      }
+    }
+
+    if (sequence > applied)
+      applied = sequence;
+
+    // the sender resends until we acknowledge, even if nothing was new
+    if (!tiles.empty ())
+      send_acks_ = true;
+  }
+
+  knowledge_->unlock ();
+
+  return result;
+}
+
+void
+gams::variables::Sensor::prune_changes (uint64_t acked)
+{
+  maps::Grid_Layer <double> values;
+  maps::Grid_Layer <double> versions;
+
+  const maps::Grid_Layer <double>::Tile_Map & tiles = versions_.get_tiles ();
+
+  // count the waiting cells of each send
+  std::map <uint64_t, size_t> counts;
+  for (maps::Grid_Layer <double>::Tile_Map::const_iterator tile =
+    tiles.begin (); tile != tiles.end (); ++tile)
+  {
+    for (int j = 0; j < maps::TILE_CELLS; ++j)
+    {
+      if ((tile->second->dirty[j >> 6] >> (j & 63) & 1) != 0 &&
+        (uint64_t)tile->second->values[j] > acked)
+        ++counts[(uint64_t)tile->second->values[j]];
+    }
+  }
+
+  // past the limit, the oldest sends are given up on. The latest send is
+  // always kept, so new writes go out at least once.
+  size_t waiting (0);
+  for (std::map <uint64_t, size_t>::reverse_iterator i = counts.rbegin ();
+    i != counts.rend (); ++i)
+  {
+    waiting += i->second;
+    if (waiting > MAX_CHANGE_CELLS && i != counts.rbegin ())
+    {
+      GAMS_DEBUG (gams::utility::LOG_MAJOR_EVENT, (LM_DEBUG, 
+        DLINFO "gams::variables::Sensor::prune_changes:" \
+        " dropping unacknowledged cells up to send %d\n", (int)i->first));
+
+      acked = i->first;
+      break;
+    }
+  }
+  for (maps::Grid_Layer <double>::Tile_Map::const_iterator tile =
+    tiles.begin (); tile != tiles.end (); ++tile)
+  {
+    const int min_x = maps::get_tile_x (tile->first);
+    const int min_y = maps::get_tile_y (tile->first);
+    for (int j = 0; j < maps::TILE_CELLS; ++j)
+    {
+      if ((tile->second->dirty[j >> 6] >> (j & 63) & 1) == 0 ||
+        (uint64_t)tile->second->values[j] <= acked)
+        continue;
+
+      const int x = min_x + (j & (maps::TILE_SIZE - 1));
+      const int y = min_y + (j >> maps::TILE_BITS);
+      values.set (x, y, changes_.get (x, y));
+      versions.set (x, y, tile->second->values[j]);
+    }
+  }
+
+  changes_ = values;
+  versions_ = versions;
+}
+
+void
+gams::variables::Sensor::apply_value (const utility::Position & pos,
+  const double & val)
+{
+  static const Madara::Knowledge_Engine::Knowledge_Update_Settings
+    LOCAL (true, false);
+
+  size_t index;
+  if (get_dense_index (pos, index))
+  {
+    // cells with unpushed local writes keep their local values
+    if (!dense_dirty_[index])
+    {
+      dense_values_[index] = val;
+      knowledge_->get_context ().set (dense_refs_[index], val, LOCAL);
+    }
+  }
+  else
+  {
+    value_.set (index_pos_to_index (pos), val, LOCAL);
+  }
+}
+
+bool
+gams::variables::Sensor::get_dense_index (const utility::Position & pos,
+  size_t & index) const
+{
+  const int x = (int)pos.x - dense_min_x_;
+  const int y = (int)pos.y - dense_min_y_;
+
+  if (x < 0 || y < 0 || x >= dense_width_ || y >= dense_height_)
+    return false;
+
+  index = (size_t)y * dense_width_ + x;
+
+  return dense_refs_[index].is_valid ();
 }
 
 string
@@ -305,6 +1068,7 @@ gams::variables::Sensor::init_vars ()
   range_.set_name (prefix + ".range", *knowledge_);
   value_.set_name (prefix + ".covered", *knowledge_);
   origin_.set_name (prefix + ".origin", *knowledge_, 3);
+  sync_.set_name (prefix + ".sync", *knowledge_);
 }
 
 void
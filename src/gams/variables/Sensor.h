@@ -59,9 +59,11 @@
 #include <string>
 
 #include "gams/GAMS_Export.h"
+#include "gams/maps/Grid.h"
 #include "madara/knowledge_engine/containers/Double.h"
 #include "madara/knowledge_engine/containers/Map.h"
 #include "madara/knowledge_engine/Knowledge_Base.h"
+#include "madara/knowledge_engine/Variable_Reference.h"
 
 #include "gams/utility/GPS_Position.h"
 #include "gams/utility/Position.h"
@@ -74,6 +76,117 @@ namespace gams
 {
   namespace variables
   {
+    /**
+     * A snapshot of the values that map sensor cells to GPS positions: the
+     * origin, the range, the cell size and the length of a degree of
+     * latitude and longitude. Conversions through a frame do not read the
+     * knowledge base or evaluate trigonometric functions.
+     **/
+    class GAMS_Export Sensor_Frame
+    {
+    public:
+      /**
+       * Constructor for an empty frame
+       **/
+      Sensor_Frame ();
+
+      /**
+       * Constructor
+       * @param origin   the GPS origin of cell (0,0)
+       * @param range    the range of the sensor in meters
+       **/
+      Sensor_Frame (const utility::GPS_Position & origin, double range);
+
+      /**
+       * Checks if the frame was built from an origin and range
+       * @param origin   the GPS origin to compare
+       * @param range    the range to compare
+       * @return true if both match the frame
+       **/
+      bool matches (const utility::GPS_Position & origin, double range) const;
+
+      /**
+       * Get the length of the side of each discretized cell
+       * @return discretization value
+       **/
+      double get_discretization () const;
+
+      /**
+       * Gets origin
+       * @return GPS origin
+       **/
+      const utility::GPS_Position & get_origin () const;
+
+      /**
+       * Gets range in meters
+       * @return sensor range
+       **/
+      double get_range () const;
+
+      /**
+       * Gets the latitude of the centers of a row of cells
+       * @param x   the x index of the row
+       * @return the latitude
+       **/
+      double get_latitude (int x) const;
+
+      /**
+       * Gets the longitude of the centers of a column of cells
+       * @param y   the y index of the column
+       * @return the longitude
+       **/
+      double get_longitude (int y) const;
+
+      /**
+       * Gets GPS position from index position
+       * @param index   index location in cartesian location on sensor map
+       * @return GPS_Position of index position
+       **/
+      utility::GPS_Position get_gps (const utility::Position & index) const;
+
+      /**
+       * Gets index position from GPS position. Unlike
+       * Sensor::get_index_from_gps without a cached frame, the length of a
+       * degree of longitude is taken at the origin, which makes this the
+       * exact inverse of get_gps.
+       * @param pos   GPS position
+       * @return index position containing pos
+       **/
+      utility::Position get_index (const utility::GPS_Position & pos) const;
+
+      /**
+       * Gets GPS positions from a list of index positions
+       * @param indices   index positions to convert
+       * @param result    list to store the GPS positions in
+       **/
+      void get_gps (const std::vector <utility::Position> & indices,
+        std::vector <utility::GPS_Position> & result) const;
+
+      /**
+       * Gets index positions from a list of GPS positions
+       * @param positions GPS positions to convert
+       * @param result    list to store the index positions in
+       **/
+      void get_index (const std::vector <utility::GPS_Position> & positions,
+        std::vector <utility::Position> & result) const;
+
+    protected:
+      /// origin of cell (0,0)
+      utility::GPS_Position origin_;
+
+      /// the range of the sensor
+      double range_;
+
+      /// the length of the side of a cell
+      double discretization_;
+
+      /// meters around the Earth along a meridian
+      double lat_circumference_;
+
+      /// meters around the Earth along the parallel of the origin
+      double lon_circumference_;
+    };
+
     class GAMS_Export Sensor
     {
     public:
@@ -131,6 +244,15 @@ namespace gams
       utility::GPS_Position get_gps_from_index (
         const utility::Position & index);
 
+      /**
+       * Gets GPS positions from a list of index positions
+       * @param indices   index positions to convert
+       * @param result    list to store the GPS positions in
+       **/
+      void get_gps_from_index (
+        const std::vector <utility::Position> & indices,
+        std::vector <utility::GPS_Position> & result);
+
       /**
        * Gets current location on sensor map
        * @param pos current GPS location
@@ -139,6 +261,39 @@ namespace gams
       utility::Position get_index_from_gps (
         const utility::GPS_Position & pos);
 
+      /**
+       * Gets index positions from a list of GPS positions
+       * @param positions GPS positions to convert
+       * @param result    list to store the index positions in
+       **/
+      void get_index_from_gps (
+        const std::vector <utility::GPS_Position> & positions,
+        std::vector <utility::Position> & result);
+
+      /**
+       * Enables or disables the cached frame. With the cache, index and
+       * GPS conversions use a snapshot of the origin and range instead of
+       * reading them from the knowledge base on every call. The snapshot
+       * follows set_origin and set_range, and refresh_frame picks up
+       * changes made by other agents.
+       * @param enabled   true to use the cached frame
+       **/
+      void set_frame_caching (bool enabled = true);
+
+      /**
+       * Rebuilds the cached frame if the origin or range in the knowledge
+       * base differ from the snapshot
+       * @return true if the frame changed
+       **/
+      bool refresh_frame ();
+
+      /**
+       * Gets the frame used for conversions, which is the cached frame if
+       * caching is enabled and a fresh snapshot otherwise
+       * @return the conversion frame
+       **/
+      Sensor_Frame get_frame ();
+
       /**
        * Gets name
        * @return name of sensor
@@ -171,6 +326,15 @@ namespace gams
        **/
       double get_value (const utility::Position& pos);
 
+      /**
+       * Gets the knowledge base record of a cell, including its clock.
+       * Unlike get_value, this reads dense cells from the knowledge base
+       * rather than from the array.
+       * @param pos   index position
+       * @return the record of the cell
+       **/
+      Madara::Knowledge_Record get_record (const utility::Position& pos);
+
       /**
        * Sets origin
        * @param origin  new origin
@@ -202,6 +366,79 @@ namespace gams
       void set_value (const utility::Position& pos, const double& val,
         const Madara::Knowledge_Engine::Knowledge_Update_Settings& settings =
           Madara::Knowledge_Engine::Knowledge_Update_Settings());
+
+      /**
+       * Switches value storage for a set of cells to a contiguous array
+       * over their bounding box. Reads and writes of these cells no longer
+       * build string keys or search the knowledge base. Writes that are
+       * sent to other agents still go to the knowledge base immediately,
+       * while local-only writes are kept in the array until push_values.
+       * Calling this with an empty set returns to knowledge base storage.
+       * @param cells   index positions to keep in the array
+       **/
+      void use_dense_storage (const set<utility::Position> & cells);
+
+      /**
+       * Checks if a dense array holds any cell values
+       * @return true if dense storage is in use
+       **/
+      bool has_dense_storage () const;
+
+      /**
+       * Copies knowledge base values, such as updates from other agents,
+       * into the dense array. Cells with unpushed local writes keep their
+       * local values.
+       **/
+      void pull_values ();
+
+      /**
+       * Writes local-only changes of the dense array into the knowledge base
+       * @param settings  settings to use for mutating values
+       **/
+      void push_values (
+        const Madara::Knowledge_Engine::Knowledge_Update_Settings& settings =
+          Madara::Knowledge_Engine::Knowledge_Update_Settings (true));
+
+      /**
+       * Selects how cell values are shared with other agents. By default,
+       * each cell is its own knowledge record. With change sync, writes
+       * that would be sent are instead collected and sent by send_changes
+       * as one binary record per agent, holding the changed cells that
+       * are not yet acknowledged by the other agents. Agents that send no
+       * record for 16 sends with new writes are no longer waited for, and
+       * at most 4096 cells of earlier sends are kept for resending.
+       * The mode is kept in sensor.{name}.sync so that it can be set once
+       * for the whole swarm.
+       * @param scale   steps per unit of value that cells are rounded to
+       *                when sent, or 0 for one record per cell
+       **/
+      void set_change_sync (double scale = 1.0);
+
+      /**
+       * Checks if cell writes are sent as batches of changes
+       * @return true if change sync is in use
+       **/
+      bool has_change_sync () const;
+
+      /**
+       * Sends the cells written since the last send as one record,
+       * sensor.{name}.changes.{.id}. Does nothing without change sync.
+       * @param settings  settings to use for setting the record
+       * @return the number of cells sent
+       **/
+      size_t send_changes (
+        const Madara::Knowledge_Engine::Eval_Settings & settings =
+          Madara::Knowledge_Engine::Eval_Settings ());
+
+      /**
+       * Applies the changes that other agents have sent since the last
+       * receive. Cells with local writes that have not been sent yet keep
+       * their local values.
+       * @param cells   if not 0, the list to append the applied cells to
+       * @return the number of cells applied
+       **/
+      size_t receive_changes (std::vector <utility::Position> * cells = 0);
+
       /**
        * Initializes the variables
        * @param name      name of the sensor
@@ -227,6 +464,29 @@ namespace gams
        */
       void init_vars ();
 
+      /**
+       * Gets the dense array index of a cell
+       * @param pos     index position of the cell
+       * @param index   the array index, if the cell is in the array
+       * @return true if the cell is kept in the dense array
+       **/
+      bool get_dense_index (const utility::Position& pos, size_t& index) const;
+
+      /**
+       * Sets the local value of a cell to a value received from another
+       * agent, unless the cell has a local write that is not yet pushed
+       * @param pos     index of position to set
+       * @param val     value to set at position
+       **/
+      void apply_value (const utility::Position& pos, const double& val);
+
+      /**
+       * Drops the written cells that every other agent has applied, and
+       * the oldest ones past the limit on cells waiting for acknowledgement
+       * @param acked   the highest sequence applied by all other agents
+       **/
+      void prune_changes (uint64_t acked);
+
       /// the map of locations to sensor value
       Madara::Knowledge_Engine::Containers::Map value_;
 
@@ -241,6 +501,66 @@ namespace gams
 
       /// origin for index calculations
       Madara::Knowledge_Engine::Containers::Double_Array origin_;
+
+      /// flag for converting through the cached frame
+      bool cache_frame_;
+
+      /// the cached frame
+      Sensor_Frame frame_;
+
+      /// lowest x index in the dense array
+      int dense_min_x_;
+
+      /// lowest y index in the dense array
+      int dense_min_y_;
+
+      /// number of cells along x in the dense array
+      int dense_width_;
+
+      /// number of cells along y in the dense array
+      int dense_height_;
+
+      /// cell values, row by row along x
+      std::vector <double> dense_values_;
+
+      /// knowledge base variables of the cells, invalid for untracked cells
+      std::vector <Madara::Knowledge_Engine::Variable_Reference> dense_refs_;
+
+      /// flags for cells with local writes not yet in the knowledge base
+      std::vector <char> dense_dirty_;
+
+      /// array indices of cells with local writes
+      std::vector <size_t> dirty_cells_;
+
+      /// scale of values in change sync, or 0 for one record per cell
+      Madara::Knowledge_Engine::Containers::Double sync_;
+
+      /// written cells that are not yet acknowledged by every agent
+      maps::Grid_Layer <double> changes_;
+
+      /// sequence of the send that each cell of changes_ goes out in
+      maps::Grid_Layer <double> versions_;
+
+      /// sequence of the last send_changes with new writes
+      uint64_t sequence_;
+
+      /// true if cells were written since the last send_changes
+      bool unsent_;
+
+      /// highest sequence applied from each agent, by agent id
+      std::map <uint64_t, uint64_t> applied_;
+
+      /// highest sequence of ours that each agent applied, by agent id
+      std::map <uint64_t, uint64_t> acks_;
+
+      /// our sequence when a record of each agent was last received
+      std::map <uint64_t, uint64_t> heard_;
+
+      /// true if applied_ changed in ways other agents have not been sent
+      bool send_acks_;
+
+      /// clocks of the change records applied by receive_changes
+      std::map <std::string, uint64_t> received_;
     };
 
     /// a map of sensor names to the sensor information
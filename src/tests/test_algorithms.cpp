@@ -0,0 +1,482 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+/**
+ * @file test_algorithms.cpp
+ * @author James Edmondson <jedmondson@gmail.com>
+ *
+ * Tests the functionality of gams::algorithms classes
+ **/
+
+#include "gams/algorithms/area_coverage/Min_Time_Area_Coverage.h"
+#include "gams/algorithms/area_coverage/Prioritized_Min_Time_Area_Coverage.h"
+#include "gams/algorithms/area_coverage/Utility_Kernels.h"
+#include "gams/utility/GPS_Position.h"
+#include "gams/utility/Position.h"
+#include "gams/variables/Self.h"
+#include "gams/variables/Sensor.h"
+#include "madara/knowledge_engine/Knowledge_Base.h"
+
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <assert.h>
+#include <vector>
+#include <cmath>
+#include <cfloat>
+#include <cstdlib>
+#include <algorithm>
+#include <map>
+#include <set>
+
+using gams::utility::GPS_Position;
+using gams::utility::Position;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace area_coverage = gams::algorithms::area_coverage;
+namespace engine = Madara::Knowledge_Engine;
+
+typedef Madara::Knowledge_Record::Integer Integer;
+
+void
+testing_output (const string& str, const unsigned int& tabs = 0)
+{
+  for (unsigned int i = 0; i < tabs; ++i)
+    cout << "\t";
+  cout << "testing " << str << "..." << endl;
+}
+
+/**
+ * Sums the cells of a block in the bounding box of the path from a start
+ * to a cell, widened by a radius, one cell at a time
+ **/
+double
+brute_force_box_sum (const vector<double> & cells, int min_x, int min_y,
+  int width, int height, const Position & start, double radius, int x, int y)
+{
+  const int low_x = (int)floor (std::min (start.x, (double)x) - radius);
+  const int high_x = (int)ceil (std::max (start.x, (double)x) + radius);
+  const int low_y = (int)floor (std::min (start.y, (double)y) - radius);
+  const int high_y = (int)ceil (std::max (start.y, (double)y) + radius);
+
+  double sum = 0.0;
+  for (int cell_y = std::max (low_y, min_y);
+    cell_y <= std::min (high_y, min_y + height - 1); ++cell_y)
+  {
+    for (int cell_x = std::max (low_x, min_x);
+      cell_x <= std::min (high_x, min_x + width - 1); ++cell_x)
+    {
+      sum += cells[(cell_y - min_y) * width + cell_x - min_x];
+    }
+  }
+
+  return sum;
+}
+
+void
+test_Utility_Kernels ()
+{
+  testing_output ("gams::algorithms::area_coverage::Utility_Kernels");
+
+  srand (1);
+
+  // an odd count leaves a remainder after every vector width
+  const size_t count = 37;
+  vector<int> x (count), y (count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    x[i] = rand () % 41 - 20;
+    y[i] = rand () % 41 - 20;
+  }
+
+  /**
+   * Weights match 1 / sqrt (distance + 1), including from a start that is
+   * not a cell center
+   */
+  testing_output ("get_distance_weights", 1);
+  vector<double> weights (count);
+  const Position start (0.5, -2.25);
+  area_coverage::get_distance_weights (start, &x[0], &y[0], count,
+    &weights[0]);
+  for (size_t i = 0; i < count; ++i)
+  {
+    const double dx = x[i] - start.x;
+    const double dy = y[i] - start.y;
+    assert (fabs (weights[i] -
+      1.0 / sqrt (sqrt (dx * dx + dy * dy) + 1.0)) < 1e-12);
+  }
+
+  /**
+   * Box sums match summing the cells of each box. Candidates lie on both
+   * sides of the block, so boxes are clipped, and boxes from a start far
+   * outside the block can miss it entirely.
+   */
+  testing_output ("get_box_sums", 1);
+  const int min_x = -7, min_y = 3, width = 13, height = 9;
+  vector<double> cells ((size_t)width * height);
+  for (size_t i = 0; i < cells.size (); ++i)
+    cells[i] = rand () % 100 / 10.0;
+
+  vector<double> table ((size_t)(width + 1) * (height + 1), 0.0);
+  for (int j = 0; j < height; ++j)
+  {
+    for (int i = 0; i < width; ++i)
+    {
+      table[(j + 1) * (width + 1) + i + 1] = cells[j * width + i] +
+        table[j * (width + 1) + i + 1] + table[(j + 1) * (width + 1) + i] -
+        table[j * (width + 1) + i];
+    }
+  }
+
+  const area_coverage::Summed_Area_Table sat =
+    { &table[0], min_x, min_y, width, height };
+
+  vector<Position> starts;
+  starts.push_back (start);
+  starts.push_back (Position (-3, 6));
+  starts.push_back (Position (-30, -40));
+
+  vector<double> sums (count);
+  size_t empty = 0;
+  for (size_t s = 0; s < starts.size (); ++s)
+  {
+    area_coverage::get_box_sums (sat, starts[s], 1.5,
+      &x[0], &y[0], count, &sums[0]);
+    for (size_t i = 0; i < count; ++i)
+    {
+      const double expected = brute_force_box_sum (cells, min_x, min_y,
+        width, height, starts[s], 1.5, x[i], y[i]);
+      assert (fabs (sums[i] - expected) < 1e-9);
+      if (expected == 0.0)
+        ++empty;
+    }
+  }
+  assert (empty > 0);
+
+  // an empty block has nothing to sum
+  const area_coverage::Summed_Area_Table none = { &table[0], 0, 0, 0, 0 };
+  area_coverage::get_box_sums (none, start, 1.5,
+    &x[0], &y[0], count, &sums[0]);
+  for (size_t i = 0; i < count; ++i)
+    assert (sums[i] == 0.0);
+}
+
+/**
+ * Minimum time coverage with access to the state of a replan
+ **/
+class Test_Min_Time_Area_Coverage : public area_coverage::Min_Time_Area_Coverage
+{
+public:
+  Test_Min_Time_Area_Coverage (engine::Knowledge_Base & knowledge,
+    gams::variables::Sensors & sensors, gams::variables::Self & self)
+    : Min_Time_Area_Coverage (Madara::Knowledge_Record ("region.0"),
+      &knowledge, 0, &sensors, &self)
+  {
+  }
+
+  using Min_Time_Area_Coverage::generate_new_position;
+  using Min_Time_Area_Coverage::get_age;
+  using Min_Time_Area_Coverage::set_age;
+  using Min_Time_Area_Coverage::min_time_;
+  using Min_Time_Area_Coverage::valid_positions_;
+  using Min_Time_Area_Coverage::position_value_map_;
+  using Min_Time_Area_Coverage::next_position_;
+  using Min_Time_Area_Coverage::last_seen_;
+  using Min_Time_Area_Coverage::record_clocks_;
+};
+
+void
+test_Min_Time_Area_Coverage ()
+{
+  testing_output ("gams::algorithms::area_coverage::Min_Time_Area_Coverage");
+
+  engine::Knowledge_Base knowledge;
+
+  // a search area large enough to score candidates on several threads
+  knowledge.set ("region.0.type", Integer (0));
+  knowledge.set ("region.0.size", Integer (4));
+  std::vector <double> vertex (2);
+  vertex[0] = 40.0;
+  vertex[1] = -80.0;
+  knowledge.set ("region.0.0", vertex);
+  vertex[1] = -79.998;
+  knowledge.set ("region.0.1", vertex);
+  vertex[0] = 40.0015;
+  knowledge.set ("region.0.2", vertex);
+  vertex[1] = -80.0;
+  knowledge.set ("region.0.3", vertex);
+
+  std::vector <double> origin (3, 0.0);
+  origin[0] = 40.0;
+  origin[1] = -80.0;
+  knowledge.set ("sensor.coverage.origin", origin);
+
+  gams::variables::Self self;
+  self.init_vars (knowledge, 0);
+  const GPS_Position current (40.0007, -79.9991);
+  current.to_container (self.device.location);
+
+  gams::variables::Sensors sensors;
+  Test_Min_Time_Area_Coverage planner (knowledge, sensors, self);
+  assert (planner.valid_positions_.size () > 1024);
+
+  /**
+   * The destination and the cells cleared on the way match an exhaustive
+   * scan of every destination against every cell. Ages are integers, so
+   * both sum the same utilities exactly.
+   */
+  testing_output ("destination", 1);
+  srand (2);
+  std::map <Position, double> ages;
+  for (std::set <Position>::const_iterator it =
+    planner.valid_positions_.begin ();
+    it != planner.valid_positions_.end (); ++it)
+  {
+    ages[*it] = rand () % 50;
+    planner.set_age (*it, ages[*it]);
+  }
+  planner.position_value_map_.clear ();
+
+  const Position start = planner.min_time_.get_index_from_gps (current);
+  const double radius = planner.min_time_.get_range () /
+    planner.min_time_.get_discretization ();
+
+  double best_utility = -DBL_MAX;
+  Position best;
+  std::set <Position> best_online;
+  for (std::set <Position>::const_iterator end =
+    planner.valid_positions_.begin ();
+    end != planner.valid_positions_.end (); ++end)
+  {
+    double utility = 0.0;
+    std::set <Position> online;
+    for (std::map <Position, double>::const_iterator cell = ages.begin ();
+      cell != ages.end (); ++cell)
+    {
+      if (start.distance_to_2d (*end, cell->first) < radius)
+      {
+        utility += pow (cell->second, 3.0);
+        online.insert (cell->first);
+      }
+    }
+
+    utility /= sqrt (start.distance_to_2d (*end) + 1);
+    if (utility > best_utility)
+    {
+      best_utility = utility;
+      best = *end;
+      best_online.swap (online);
+    }
+  }
+
+  planner.generate_new_position ();
+
+  const GPS_Position expected = planner.min_time_.get_gps_from_index (best);
+  assert (planner.next_position_.latitude () == expected.latitude ());
+  assert (planner.next_position_.longitude () == expected.longitude ());
+
+  assert (planner.position_value_map_.size () == best_online.size ());
+  for (std::set <Position>::const_iterator it = best_online.begin ();
+    it != best_online.end (); ++it)
+  {
+    assert (planner.position_value_map_.count (*it) == 1);
+    assert (planner.position_value_map_[*it] == ages[*it]);
+    assert (planner.get_age (*it) == 0);
+  }
+
+  /**
+   * analyze only dates the cells that other agents sent in a batch. A cell
+   * written outside of change sync is not read until the planner needs its
+   * age, and a remote observation in a batch is dated when it arrives.
+   * The first analyze sends the ages set above, which would otherwise
+   * take precedence over the batch.
+   */
+  testing_output ("analyze", 1);
+  planner.analyze ();
+  const Position unvisited = *planner.valid_positions_.begin ();
+  const Position observed = *planner.valid_positions_.rbegin ();
+  assert (!(unvisited == start) && !(observed == start));
+
+  const Integer unvisited_seen = planner.last_seen_.get (
+    (int)unvisited.x, (int)unvisited.y);
+  const uint64_t unvisited_clock = planner.record_clocks_.get (
+    (int)unvisited.x, (int)unvisited.y);
+  std::stringstream unvisited_key;
+  unvisited_key << "sensor.region.0.min_time.covered." <<
+    (int)unvisited.x << "x" << (int)unvisited.y;
+  knowledge.set (unvisited_key.str (), 3.0);
+
+  engine::Knowledge_Base peer_kb;
+  peer_kb.set (".id", Integer (1));
+  gams::variables::Sensor peer ("region.0.min_time", &peer_kb,
+    planner.min_time_.get_range (), GPS_Position (40.0, -80.0));
+  peer.set_change_sync ();
+  peer.set_value (observed, 0);
+  assert (peer.send_changes () == 1);
+
+  const std::string peer_key ("sensor.region.0.min_time.changes.1");
+  size_t size;
+  unsigned char * buffer = peer_kb.get (peer_key).to_unmanaged_buffer (size);
+  knowledge.set_file (peer_key, buffer, size);
+  delete [] buffer;
+
+  planner.analyze ();
+  assert (planner.last_seen_.get ((int)unvisited.x, (int)unvisited.y) ==
+    unvisited_seen);
+  assert (planner.record_clocks_.get ((int)unvisited.x, (int)unvisited.y) ==
+    unvisited_clock);
+  assert (planner.record_clocks_.get ((int)observed.x, (int)observed.y) ==
+    planner.min_time_.get_record (observed).clock);
+  assert (planner.get_age (observed) == 0);
+  assert (planner.get_age (unvisited) == 3);
+}
+
+/**
+ * Prioritized minimum time coverage with access to its search area
+ **/
+class Test_Prioritized_Min_Time_Area_Coverage :
+  public area_coverage::Prioritized_Min_Time_Area_Coverage
+{
+public:
+  Test_Prioritized_Min_Time_Area_Coverage (
+    engine::Knowledge_Base & knowledge,
+    gams::variables::Sensors & sensors, gams::variables::Self & self)
+    : Prioritized_Min_Time_Area_Coverage (
+      Madara::Knowledge_Record ("search_area.0"), &knowledge, 0, &sensors,
+      &self)
+  {
+  }
+
+  using Prioritized_Min_Time_Area_Coverage::search_area_;
+  using Prioritized_Min_Time_Area_Coverage::min_time_;
+  using Prioritized_Min_Time_Area_Coverage::valid_positions_;
+};
+
+/**
+ * Sets up a rectangular region with a priority
+ **/
+void
+set_region (engine::Knowledge_Base & knowledge, const std::string & prefix,
+  double min_lat, double min_lon, double max_lat, double max_lon,
+  Integer priority)
+{
+  knowledge.set (prefix + ".type", Integer (0));
+  knowledge.set (prefix + ".size", Integer (4));
+  knowledge.set (prefix + ".priority", priority);
+
+  std::vector <double> vertex (2);
+  vertex[0] = min_lat;
+  vertex[1] = min_lon;
+  knowledge.set (prefix + ".0", vertex);
+  vertex[1] = max_lon;
+  knowledge.set (prefix + ".1", vertex);
+  vertex[0] = max_lat;
+  knowledge.set (prefix + ".2", vertex);
+  vertex[1] = min_lon;
+  knowledge.set (prefix + ".3", vertex);
+}
+
+void
+test_Prioritized_Min_Time_Area_Coverage ()
+{
+  testing_output (
+    "gams::algorithms::area_coverage::Prioritized_Min_Time_Area_Coverage");
+
+  engine::Knowledge_Base knowledge;
+
+  // a low priority area with a high priority area inside it
+  set_region (knowledge, "region.0", 40.0, -80.0, 40.0005, -79.9994, 1);
+  set_region (knowledge, "region.1",
+    40.0001, -79.9999, 40.0003, -79.9996, 5);
+  knowledge.set ("search_area.0.size", Integer (2));
+  knowledge.set ("search_area.0.0", "region.0");
+  knowledge.set ("search_area.0.1", "region.1");
+
+  std::vector <double> origin (3, 0.0);
+  origin[0] = 40.0;
+  origin[1] = -80.0;
+  knowledge.set ("sensor.coverage.origin", origin);
+
+  gams::variables::Self self;
+  self.init_vars (knowledge, 0);
+  const GPS_Position current (40.0002, -79.9997);
+  current.to_container (self.device.location);
+
+  gams::variables::Sensors sensors;
+  Test_Prioritized_Min_Time_Area_Coverage planner (knowledge, sensors, self);
+
+  /**
+   * Priorities are computed once, in a batch, for all valid cells. They
+   * match the search area's priority of each cell center.
+   */
+  testing_output ("get_priorities", 1);
+  const gams::maps::Grid_Layer <double> & priorities =
+    planner.get_priorities ();
+  std::set <double> seen;
+  assert (!planner.valid_positions_.empty ());
+  for (std::set <Position>::const_iterator it =
+    planner.valid_positions_.begin ();
+    it != planner.valid_positions_.end (); ++it)
+  {
+    const double expected = (double)planner.search_area_.get_priority (
+      planner.min_time_.get_gps_from_index (*it));
+    assert (priorities.get ((int)it->x, (int)it->y) == expected);
+    seen.insert (expected);
+  }
+  assert (seen.count (1.0) == 1 && seen.count (5.0) == 1);
+}
+
+int
+main (int argc, char ** argv)
+{
+  test_Utility_Kernels ();
+  test_Min_Time_Area_Coverage ();
+  test_Prioritized_Min_Time_Area_Coverage ();
+  return 0;
+}
@@ -0,0 +1,687 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+/**
+ * @file test_controllers.cpp
+ * @author James Edmondson <jedmondson@gmail.com>
+ *
+ * Tests the functionality of gams::controllers classes
+ **/
+
+#include "gams/controllers/Accent_Pool.h"
+#include "gams/controllers/Async_Sender.h"
+#include "gams/controllers/Base_Controller.h"
+#include "gams/controllers/Change_Watcher.h"
+#include "gams/controllers/Controller_Pool.h"
+#include "gams/utility/Clock.h"
+#include "madara/knowledge_engine/Knowledge_Base.h"
+
+#include "ace/Task.h"
+#include "ace/OS_NS_unistd.h"
+
+#include <string>
+#include <iostream>
+#include <assert.h>
+#include <vector>
+#include <set>
+
+using gams::controllers::Accent_Pool;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace engine = Madara::Knowledge_Engine;
+namespace algorithms = gams::algorithms;
+namespace controllers = gams::controllers;
+
+typedef Madara::Knowledge_Record::Integer Integer;
+
+void
+testing_output (const string& str, const unsigned int& tabs = 0)
+{
+  for (unsigned int i = 0; i < tabs; ++i)
+    cout << "\t";
+  cout << "testing " << str << "..." << endl;
+}
+
+/**
+ * Accent that, on analyze, copies one variable into another
+ **/
+class Copy_Accent : public algorithms::Base_Algorithm
+{
+public:
+  Copy_Accent (engine::Knowledge_Base & knowledge,
+    const string & from, const string & to)
+    : Base_Algorithm (&knowledge), from_ (from), to_ (to)
+  {
+  }
+
+  virtual int analyze (void)
+  {
+    knowledge_->set (to_, knowledge_->get (from_).to_integer () + 1);
+    return 0;
+  }
+
+  virtual int plan (void)
+  {
+    return 0;
+  }
+
+  virtual int execute (void)
+  {
+    return 0;
+  }
+
+  using Base_Algorithm::declare_reads;
+  using Base_Algorithm::declare_writes;
+
+private:
+  string from_;
+  string to_;
+};
+
+void
+test_Accent_Pool ()
+{
+  testing_output ("gams::controllers::Accent_Pool");
+
+  engine::Knowledge_Base knowledge;
+
+  /**
+   * Accents that do not conflict share a wave. An accent goes after the
+   * waves of earlier accents it conflicts with, and accents without
+   * declarations conflict with every other accent.
+   */
+  testing_output ("get_waves", 1);
+  Copy_Accent first (knowledge, "input", "a.x");
+  first.declare_reads ("input");
+  first.declare_writes ("a.");
+  Copy_Accent second (knowledge, "input", "b.x");
+  second.declare_reads ("input");
+  second.declare_writes ("b.");
+  Copy_Accent third (knowledge, "a.x", "c.x");
+  third.declare_reads ("a.x");
+  third.declare_writes ("c.");
+  Copy_Accent fourth (knowledge, "b.x", "d.x");
+  fourth.declare_reads ("b.");
+  fourth.declare_writes ("d.");
+  Copy_Accent undeclared (knowledge, "c.x", "e.x");
+
+  algorithms::Algorithms accents;
+  accents.push_back (&first);
+  accents.push_back (&second);
+  accents.push_back (&third);
+  accents.push_back (&fourth);
+  accents.push_back (&undeclared);
+
+  vector<size_t> waves;
+  assert (Accent_Pool::get_waves (accents, waves) == 3);
+  assert (waves.size () == 5);
+  assert (waves[0] == 0 && waves[1] == 0);
+  assert (waves[2] == 1 && waves[3] == 1);
+  assert (waves[4] == 2);
+
+  accents.pop_back ();
+  assert (Accent_Pool::get_waves (accents, waves) == 2);
+
+  // readers of the same variable do not conflict
+  algorithms::Algorithms readers;
+  readers.push_back (&first);
+  readers.push_back (&second);
+  assert (Accent_Pool::get_waves (readers, waves) == 1);
+
+  /**
+   * Waves run in order, so each accent sees the writes of the accents it
+   * conflicts with. The caller's lock is given up while a wave runs on
+   * the workers, which otherwise could not access the knowledge base.
+   */
+  testing_output ("run", 1);
+  accents.push_back (&undeclared);
+  Accent_Pool pool (2);
+  knowledge.set ("input", Integer (1));
+  knowledge.lock ();
+  pool.run (accents, controllers::PHASE_ANALYZE, &knowledge);
+  knowledge.unlock ();
+  assert (knowledge.get ("a.x").to_integer () == 2);
+  assert (knowledge.get ("b.x").to_integer () == 2);
+  assert (knowledge.get ("c.x").to_integer () == 3);
+  assert (knowledge.get ("d.x").to_integer () == 3);
+  assert (knowledge.get ("e.x").to_integer () == 4);
+}
+
+/**
+ * Transport that keeps what it is given instead of sending it
+ **/
+class Recording_Transport : public Madara::Transport::Base
+{
+public:
+  Recording_Transport (engine::Knowledge_Base & knowledge,
+    Madara::Transport::Settings & settings)
+    : Base (knowledge.get_id (), settings, knowledge.get_context ()),
+    sends (0)
+  {
+  }
+
+  virtual long send_data (const Madara::Knowledge_Records & records)
+  {
+    ++sends;
+    sent.clear ();
+    for (Madara::Knowledge_Records::const_iterator i = records.begin ();
+      i != records.end (); ++i)
+    {
+      sent[i->first] = *i->second;
+    }
+    return 0;
+  }
+
+  unsigned int sends;
+  std::map <std::string, Madara::Knowledge_Record> sent;
+};
+
+/**
+ * Sender whose sends can be triggered without its thread
+ **/
+class Test_Async_Sender : public controllers::Async_Sender
+{
+public:
+  Test_Async_Sender (engine::Knowledge_Base & knowledge,
+    Madara::Transport::Base & transport)
+    : Async_Sender (knowledge, transport, 1.0)
+  {
+  }
+
+  using Async_Sender::flush;
+};
+
+void
+test_Async_Sender ()
+{
+  testing_output ("gams::controllers::Async_Sender");
+
+  engine::Knowledge_Base knowledge;
+  Madara::Transport::Settings settings;
+  Recording_Transport transport (knowledge, settings);
+  Test_Async_Sender sender (knowledge, transport);
+
+  /**
+   * Iterations collected between two sends go out in one send, with the
+   * latest value of each variable.
+   */
+  testing_output ("collect and flush", 1);
+  knowledge.set ("x", Integer (1));
+  sender.collect ();
+  knowledge.set ("x", Integer (2));
+  knowledge.set ("y", Integer (3));
+  sender.collect ();
+  knowledge.set ("x", Integer (4));
+  sender.collect ();
+  assert (transport.sends == 0);
+
+  sender.flush ();
+  assert (transport.sends == 1);
+  assert (transport.sent.size () == 2);
+  assert (transport.sent["x"].to_integer () == 4);
+  assert (transport.sent["y"].to_integer () == 3);
+  assert (sender.get_sends () == 1);
+  assert (sender.get_coalesced () == 2);
+
+  // nothing new is not sent
+  sender.collect ();
+  sender.flush ();
+  assert (transport.sends == 1);
+
+  knowledge.set ("y", Integer (5));
+  sender.collect ();
+  sender.flush ();
+  assert (transport.sends == 2);
+  assert (transport.sent.size () == 1);
+  assert (transport.sent["y"].to_integer () == 5);
+}
+
+/**
+ * Controller that only counts its iterations
+ **/
+class Counting_Controller : public controllers::Base_Controller
+{
+public:
+  Counting_Controller (engine::Knowledge_Base & knowledge)
+    : Base_Controller (knowledge), iterations (0)
+  {
+  }
+
+  virtual int monitor (void)
+  {
+    ++iterations;
+    return 0;
+  }
+
+  virtual int analyze (void)
+  {
+    return 0;
+  }
+
+  virtual int plan (void)
+  {
+    return 0;
+  }
+
+  virtual int execute (void)
+  {
+    return 0;
+  }
+
+  unsigned int iterations;
+
+  using Base_Controller::release_algorithm;
+};
+
+/**
+ * Algorithm that counts how many of its instances were deleted
+ **/
+class Tracked_Algorithm : public algorithms::Base_Algorithm
+{
+public:
+  Tracked_Algorithm (engine::Knowledge_Base * knowledge)
+    : Base_Algorithm (knowledge)
+  {
+  }
+
+  virtual ~Tracked_Algorithm ()
+  {
+    ++deleted;
+  }
+
+  virtual int analyze (void)
+  {
+    return 0;
+  }
+
+  virtual int plan (void)
+  {
+    return 0;
+  }
+
+  virtual int execute (void)
+  {
+    return 0;
+  }
+
+  static unsigned int deleted;
+};
+
+unsigned int Tracked_Algorithm::deleted = 0;
+
+/**
+ * Factory that counts the algorithms it creates
+ **/
+class Tracked_Factory : public algorithms::Algorithm_Factory
+{
+public:
+  Tracked_Factory ()
+    : created (0)
+  {
+  }
+
+  virtual algorithms::Base_Algorithm * create (
+    const Madara::Knowledge_Vector & args,
+    engine::Knowledge_Base * knowledge,
+    gams::platforms::Base_Platform * platform,
+    gams::variables::Sensors * sensors,
+    gams::variables::Self * self,
+    gams::variables::Devices * devices)
+  {
+    ++created;
+    return new Tracked_Algorithm (knowledge);
+  }
+
+  unsigned int created;
+};
+
+/**
+ * A loop whose first iteration takes longer than several periods of a
+ * virtual clock
+ **/
+class Overrunning_Controller : public Counting_Controller
+{
+public:
+  Overrunning_Controller (engine::Knowledge_Base & knowledge,
+    gams::utility::Virtual_Clock & clock, double first_duration)
+    : Counting_Controller (knowledge), clock_ (clock),
+    first_duration_ (first_duration)
+  {
+  }
+
+  virtual int monitor (void)
+  {
+    if (iterations == 0)
+    {
+      ACE_Time_Value duration;
+      duration.set (first_duration_);
+      clock_.advance (duration);
+    }
+
+    return Counting_Controller::monitor ();
+  }
+
+private:
+  gams::utility::Virtual_Clock & clock_;
+  double first_duration_;
+};
+
+void
+test_Base_Controller ()
+{
+  testing_output ("gams::controllers::Base_Controller");
+
+  engine::Knowledge_Base knowledge;
+  Counting_Controller loop (knowledge);
+
+  /**
+   * A virtual clock only moves when the loop sleeps until the next period,
+   * so a loop without a period is rejected instead of running forever.
+   */
+  testing_output ("virtual clock", 1);
+  gams::utility::Virtual_Clock clock;
+  loop.set_clock (&clock);
+  assert (loop.run (0.0, 10.0) == -1);
+  assert (loop.iterations == 0);
+  assert (clock.now () == ACE_Time_Value::zero);
+
+  // iterations at 0, 0.5, 1 and 1.5 seconds
+  loop.run (0.5, 2.0);
+  assert (loop.iterations == 4);
+  assert (clock.now_seconds () == 2.0);
+
+  /**
+   * Without a period, or a send period, every iteration sends its updates
+   * and the loop runs until the max runtime on the real clock.
+   */
+  testing_output ("no period", 1);
+  gams::utility::Real_Clock real_clock;
+  loop.set_clock (&real_clock);
+  loop.iterations = 0;
+  loop.run (0.0, 0.05);
+  assert (loop.iterations > 1);
+
+  /**
+   * A first iteration of 2.5 periods is caught up on by starting the
+   * missed iterations late, at 2.5 and 2.5 seconds, before the schedule
+   * resumes at 3 seconds.
+   */
+  testing_output ("catch up overruns", 1);
+  gams::utility::Virtual_Clock catch_up_clock;
+  Overrunning_Controller catch_up (knowledge, catch_up_clock, 2.5);
+  catch_up.set_clock (&catch_up_clock);
+  catch_up.set_overrun_policy (controllers::OVERRUN_CATCH_UP);
+  catch_up.run (1.0, 4.0);
+  assert (catch_up.iterations == 4);
+  assert (knowledge.get (".gams.perf.loop.iterations").to_integer () == 4);
+  assert (knowledge.get (".gams.perf.loop.overruns").to_integer () == 2);
+  assert (knowledge.get (".gams.perf.loop.skipped").to_integer () == 0);
+  assert (knowledge.get (".gams.perf.loop.max_lateness").to_double () == 1.5);
+  assert (knowledge.get (".gams.perf.loop.jitter.max").to_double () == 1.5);
+  assert (knowledge.get (".gams.perf.loop.jitter.mean").to_double () == 1.0);
+
+  /**
+   * The skip policy drops the deadlines at 1 and 2 seconds and starts the
+   * next iteration on time at 3 seconds.
+   */
+  testing_output ("skip overruns", 1);
+  gams::utility::Virtual_Clock skip_clock;
+  Overrunning_Controller skip (knowledge, skip_clock, 2.5);
+  skip.set_clock (&skip_clock);
+  skip.set_overrun_policy (controllers::OVERRUN_SKIP);
+  skip.run (1.0, 4.0);
+  assert (skip.iterations == 2);
+  assert (knowledge.get (".gams.perf.loop.iterations").to_integer () == 2);
+  assert (knowledge.get (".gams.perf.loop.overruns").to_integer () == 1);
+  assert (knowledge.get (".gams.perf.loop.skipped").to_integer () == 2);
+  assert (knowledge.get (".gams.perf.loop.max_lateness").to_double () == 0.0);
+  assert (knowledge.get (".gams.perf.loop.jitter.max").to_double () == 2.0);
+  assert (knowledge.get (".gams.perf.loop.jitter.mean").to_double () == 2.0);
+}
+
+void
+test_algorithm_cache ()
+{
+  testing_output ("gams::controllers::Base_Controller algorithm cache");
+
+  Tracked_Factory factory;
+  engine::Knowledge_Base knowledge;
+  Counting_Controller loop (knowledge);
+  std::vector <std::string> aliases;
+  aliases.push_back ("a");
+  aliases.push_back ("b");
+  loop.add_algorithm_factory (aliases, &factory);
+  loop.set_algorithm_caching ();
+
+  /**
+   * Switching back to an algorithm reactivates the instance it had, and
+   * replaced algorithms stay alive in the cache.
+   */
+  testing_output ("switching", 1);
+  loop.init_algorithm ("a");
+  algorithms::Base_Algorithm * a = loop.get_algorithm ();
+  loop.init_algorithm ("b");
+  algorithms::Base_Algorithm * b = loop.get_algorithm ();
+  loop.init_algorithm ("a");
+  assert (a != 0 && b != 0 && a != b);
+  assert (loop.get_algorithm () == a);
+  assert (factory.created == 2);
+  assert (Tracked_Algorithm::deleted == 0);
+
+  /**
+   * Arguments are part of the key. Arguments that print the same, but
+   * differ in their types or in how they are split, get their own
+   * instances.
+   */
+  testing_output ("keys", 1);
+  Madara::Knowledge_Vector joined (1), split (2), integer (1), text (1);
+  joined[0] = Madara::Knowledge_Record ("x\ny");
+  split[0] = Madara::Knowledge_Record ("x");
+  split[1] = Madara::Knowledge_Record ("y");
+  integer[0] = Madara::Knowledge_Record (Integer (1));
+  text[0] = Madara::Knowledge_Record ("1");
+
+  std::set <algorithms::Base_Algorithm *> instances;
+  instances.insert (a);
+  instances.insert (b);
+  loop.init_algorithm ("a", joined);
+  instances.insert (loop.get_algorithm ());
+  loop.init_algorithm ("a", split);
+  instances.insert (loop.get_algorithm ());
+  loop.init_algorithm ("a", integer);
+  instances.insert (loop.get_algorithm ());
+  loop.init_algorithm ("a", text);
+  instances.insert (loop.get_algorithm ());
+  assert (instances.size () == 6);
+  assert (factory.created == 6);
+
+  loop.init_algorithm ("a", split);
+  assert (factory.created == 6);
+
+  /**
+   * Releasing the active algorithm leaves cached instances alone, and
+   * disabling the cache deletes the inactive ones.
+   */
+  testing_output ("release", 1);
+  loop.release_algorithm ();
+  assert (loop.get_algorithm () == 0);
+  assert (Tracked_Algorithm::deleted == 0);
+  loop.init_algorithm ("b");
+  assert (loop.get_algorithm () == b);
+  assert (factory.created == 6);
+
+  loop.set_algorithm_caching (false);
+  assert (Tracked_Algorithm::deleted == 5);
+  assert (loop.get_algorithm () == b);
+
+  // without the cache, a replaced algorithm is deleted
+  loop.init_algorithm ("a");
+  assert (Tracked_Algorithm::deleted == 6);
+  assert (factory.created == 7);
+}
+
+/**
+ * Writes a watched variable repeatedly, waiting for each write to be
+ * acknowledged, like an agent commanding a loop with a period of 0
+ */
+class Change_Writer : public ACE_Task_Base
+{
+public:
+  Change_Writer (engine::Knowledge_Base & knowledge, unsigned int writes)
+    : knowledge_ (knowledge), writes_ (writes)
+  {
+  }
+
+  int svc (void)
+  {
+    for (unsigned int i = 1; i <= writes_; ++i)
+    {
+      knowledge_.set ("command", Integer (i));
+      while (knowledge_.get ("ack").to_integer () < Integer (i))
+        ACE_OS::sleep (ACE_Time_Value (0, 100));
+    }
+    return 0;
+  }
+
+private:
+  engine::Knowledge_Base & knowledge_;
+  unsigned int writes_;
+};
+
+void
+test_Change_Watcher ()
+{
+  testing_output ("gams::controllers::Change_Watcher");
+
+  engine::Knowledge_Base knowledge;
+
+  /**
+   * A write to a watched variable wakes the waiting loop, and the watcher
+   * is stopped without leaving variables behind in the knowledge base.
+   */
+  testing_output ("wait_for_change", 1);
+  controllers::Change_Watcher watcher (knowledge);
+  watcher.add ("command");
+  watcher.start ();
+  knowledge.set ("command", "move");
+  assert (watcher.wait_for_change (10.0));
+  assert (!watcher.wait_for_change (0.01));
+
+  /**
+   * Writes from another thread are never lost, even when they land between
+   * the helper thread's check and its next wait and the loop waits without
+   * a timeout.
+   */
+  testing_output ("wait_for_change (threaded writes)", 1);
+  const unsigned int writes = 200;
+  Change_Writer writer (knowledge, writes);
+  writer.activate ();
+  for (unsigned int i = 1; i <= writes; ++i)
+  {
+    assert (watcher.wait_for_change (-1.0));
+    assert (knowledge.get ("command").to_integer () ==
+      Integer (i));
+    knowledge.set ("ack", Integer (i));
+  }
+  writer.wait ();
+
+  testing_output ("stop", 1);
+  watcher.stop ();
+  assert (knowledge.to_map (".gams.").empty ());
+}
+
+void
+test_Controller_Pool ()
+{
+  testing_output ("gams::controllers::Controller_Pool");
+
+  /**
+   * Every controller runs exactly once per round, whether it runs on the
+   * worker it was queued on or is stolen by another.
+   */
+  testing_output ("run", 1);
+  const size_t num_controllers = 7;
+  std::vector <engine::Knowledge_Base *> knowledges;
+  std::vector <Counting_Controller *> loops;
+  controllers::Controller_Pool pool (3);
+  for (size_t i = 0; i < num_controllers; ++i)
+  {
+    knowledges.push_back (new engine::Knowledge_Base ());
+    loops.push_back (new Counting_Controller (*knowledges[i]));
+    pool.add (loops[i]);
+  }
+  assert (pool.size () == num_controllers);
+
+  unsigned int rounds = pool.run (0.0, 0.05);
+  assert (rounds > 0);
+  for (size_t i = 0; i < num_controllers; ++i)
+    assert (loops[i]->iterations == rounds);
+
+  rounds += pool.run (0.01, 0.05);
+  for (size_t i = 0; i < num_controllers; ++i)
+    assert (loops[i]->iterations == rounds);
+
+  for (size_t i = 0; i < num_controllers; ++i)
+  {
+    delete loops[i];
+    delete knowledges[i];
+  }
+}
+
+int
+main (int argc, char ** argv)
+{
+  test_Accent_Pool ();
+  test_Async_Sender ();
+  test_Base_Controller ();
+  test_algorithm_cache ();
+  test_Change_Watcher ();
+  test_Controller_Pool ();
+  return 0;
+}
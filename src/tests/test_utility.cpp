@@ -57,18 +57,29 @@
 #include <assert.h>
 #include <vector>
 #include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include <cstdio>
 
 #include "gams/utility/Position.h"
 #include "gams/utility/GPS_Position.h"
+#include "gams/utility/Local_Frame.h"
 #include "gams/utility/Region.h"
 #include "gams/utility/Prioritized_Region.h"
 #include "gams/utility/Search_Area.h"
+#include "gams/utility/Latency_Histogram.h"
+#include "gams/utility/Clock.h"
+#include "gams/utility/Trace_Buffer.h"
 
 using gams::utility::GPS_Position;
+using gams::utility::Latency_Histogram;
 using gams::utility::Position;
 using gams::utility::Prioritized_Region;
 using gams::utility::Region;
 using gams::utility::Search_Area;
+using gams::utility::Trace_Buffer;
+using gams::utility::Trace_Event;
+using gams::utility::Virtual_Clock;
 using std::cout;
 using std::endl;
 using std::string;
@@ -218,6 +229,44 @@ test_GPS_Position ()
   assert (phi == M_PI);
 }
 
+void
+test_Local_Frame ()
+{
+  testing_output ("gams::utility::Local_Frame");
+
+  // conversions must match GPS_Position exactly
+  const GPS_Position origin (40.443237, -79.94057, 3);
+  gams::utility::Local_Frame frame (origin);
+  testing_output ("to_position", 1);
+  vector<GPS_Position> gps;
+  for (int i = 0; i < 101; ++i)
+    gps.push_back (GPS_Position (40.44 + 0.0001 * i, -79.94 - 0.0002 * i, i));
+  vector<Position> meters;
+  frame.to_positions (gps, meters);
+  for (size_t i = 0; i < gps.size (); ++i)
+    assert (meters[i] == gps[i].to_position (origin));
+
+  testing_output ("to_gps_position", 1);
+  vector<GPS_Position> back;
+  frame.to_gps_positions (meters, back);
+  for (size_t i = 0; i < meters.size (); ++i)
+    assert (back[i] == GPS_Position::to_gps_position (meters[i], origin));
+
+  testing_output ("arrays", 1);
+  vector<double> lats, lons, x (gps.size ()), y (gps.size ());
+  for (size_t i = 0; i < gps.size (); ++i)
+  {
+    lats.push_back (gps[i].latitude ());
+    lons.push_back (gps[i].longitude ());
+  }
+  frame.to_positions (&lats[0], &lons[0], gps.size (), &x[0], &y[0]);
+  for (size_t i = 0; i < gps.size (); ++i)
+    assert (x[i] == meters[i].x && y[i] == meters[i].y);
+  frame.to_gps_positions (&x[0], &y[0], gps.size (), &lats[0], &lons[0]);
+  for (size_t i = 0; i < gps.size (); ++i)
+    assert (lats[i] == back[i].latitude () && lons[i] == back[i].longitude ());
+}
+
 // TODO: fill out remaining Region function tests
 void
 test_Region ()
@@ -252,6 +301,26 @@ test_Region ()
   GPS_Position empty;
   assert (!r.contains (empty));
 
+  // batch contains must agree with single point contains
+  testing_output ("batch contains", 1);
+  const size_t side = 63;
+  const size_t num_points = side * side;
+  vector<double> lats (num_points), lons (num_points);
+  vector<uint8_t> inside (num_points);
+  for (size_t i = 0; i < num_points; ++i)
+  {
+    lats[i] = r.min_lat_ - 0.00001 +
+      (r.max_lat_ - r.min_lat_ + 0.00002) * (i % side) / (side - 1);
+    lons[i] = r.min_lon_ - 0.00001 +
+      (r.max_lon_ - r.min_lon_ + 0.00002) * (i / side) / (side - 1);
+  }
+  lats[0] = p.latitude ();
+  lons[0] = p.longitude ();
+  r.contains (&lats[0], &lons[0], num_points, &inside[0]);
+  for (size_t i = 0; i < num_points; ++i)
+    assert (inside[i] == r.contains (GPS_Position (lats[i], lons[i])));
+  assert (inside[0]);
+
   // bounding box
   testing_output ("get_bounding_box", 1);
   Region bound = r.get_bounding_box ();
@@ -264,6 +333,41 @@ test_Region ()
   testing_output ("get_area", 1);
   assert (r.get_area () < 525.8 && r.get_area() > 525.7);
   assert (bound.get_area () < 681.3 && bound.get_area() > 681.2);
+
+  // distance searches the edges of large regions through a hierarchy
+  testing_output ("distance", 1);
+  points.clear ();
+  for (int i = 0; i < 500; ++i)
+  {
+    const double angle = 2 * M_PI * i / 500;
+    const double radius = 0.001 * (1 + 0.3 * sin (7 * angle));
+    points.push_back (GPS_Position (40.443 + radius * cos (angle),
+      -79.94 + radius * sin (angle)));
+  }
+  Region star (points);
+  const GPS_Position sw (star.min_lat_, star.min_lon_);
+  for (int i = 0; i < 40; ++i)
+  {
+    for (int j = 0; j < 40; ++j)
+    {
+      const GPS_Position q (40.4405 + 0.000125 * i, -79.9425 + 0.000125 * j);
+      double expected_distance = 0;
+      if (!star.contains (q))
+      {
+        expected_distance = DBL_MAX;
+        const Position local_q = q.to_position (sw);
+        for (size_t k = 0; k < points.size (); ++k)
+        {
+          expected_distance = std::min (expected_distance,
+            points[k].to_position (sw).distance_to_2d (
+            points[(k + 1) % points.size ()].to_position (sw), local_q));
+        }
+      }
+      assert (star.distance (q) == expected_distance);
+    }
+  }
+  assert (r.distance (GPS_Position (40.4432, -79.9401)) == 0);
+  assert (r.distance (GPS_Position (40.4434, -79.9401)) > 0);
 }
 
 void
@@ -302,6 +406,148 @@ test_Search_Area ()
   Prioritized_Region pr2 (points, 1);
   search.add_prioritized_region (pr2);
   assert (search.get_convex_hull () == convex1);
+
+  // indexed lookups must agree with testing every region
+  testing_output ("get_priority", 1);
+  vector<Prioritized_Region> regions;
+  for (int i = 0; i < 300; ++i)
+  {
+    const double lat = 40.44 + 0.0007 * (i % 20) + 0.00003 * (i % 7);
+    const double lon = -79.94 + 0.0009 * (i / 20) - 0.00002 * (i % 5);
+    const double size = 0.0004 + 0.0002 * (i % 3);
+    points.clear ();
+    points.push_back (GPS_Position (lat, lon));
+    points.push_back (GPS_Position (lat + size, lon + 0.3 * size));
+    points.push_back (GPS_Position (lat + 0.5 * size, lon + size));
+    regions.push_back (Prioritized_Region (points, 1 + i % 11));
+  }
+  Search_Area many (regions);
+  for (int i = 0; i < 200; ++i)
+  {
+    for (int j = 0; j < 200; ++j)
+    {
+      const GPS_Position q (40.4395 + 0.00008 * i, -79.9405 + 0.00008 * j);
+      Madara::Knowledge_Record::Integer expected_priority = 0;
+      for (size_t k = 0; k < regions.size (); ++k)
+        if (regions[k].contains (q) && regions[k].priority > expected_priority)
+          expected_priority = regions[k].priority;
+      assert (many.get_priority (q) == expected_priority);
+      assert (many.contains (q) == (expected_priority > 0));
+    }
+  }
+
+  // hull built one region at a time matches the hull of all regions
+  testing_output ("get_convex_hull incremental", 1);
+  Search_Area incremental (regions[0]);
+  for (size_t k = 1; k < regions.size (); ++k)
+    incremental.add_prioritized_region (regions[k]);
+  Region hull = many.get_convex_hull ();
+  assert (incremental.get_convex_hull () == hull);
+  for (size_t k = 0; k < regions.size (); ++k)
+    for (size_t v = 0; v < regions[k].vertices.size (); ++v)
+      assert (hull.distance (regions[k].vertices[v]) < 0.001);
+  for (size_t k = 1; k < hull.vertices.size (); ++k)
+    assert (hull.vertices[0].latitude () <= hull.vertices[k].latitude ());
+}
+
+void
+test_Latency_Histogram ()
+{
+  testing_output ("gams::utility::Latency_Histogram");
+
+  // empty histogram
+  testing_output ("empty", 1);
+  Latency_Histogram h;
+  assert (h.get_count () == 0);
+  assert (h.get_max () == 0);
+  assert (h.get_percentile (50) == 0);
+
+  // small values are stored exactly
+  testing_output ("exact buckets", 1);
+  for (uint64_t i = 1; i <= 20; ++i)
+    h.record (i);
+  assert (h.get_count () == 20);
+  assert (h.get_min () == 1);
+  assert (h.get_max () == 20);
+  assert (h.get_percentile (50) == 10);
+  assert (h.get_percentile (100) == 20);
+  assert (h.get_mean () == 10.5);
+
+  // large values stay within the relative error of a sub-bucket
+  testing_output ("relative error", 1);
+  h.reset ();
+  for (uint64_t i = 0; i < 99; ++i)
+    h.record (1000000);
+  h.record (50000000);
+  uint64_t p50 = h.get_percentile (50);
+  assert (p50 >= 1000000 && p50 <= 1000000 + 1000000 / 16);
+  uint64_t p99 = h.get_percentile (99);
+  assert (p99 >= 1000000 && p99 <= 1000000 + 1000000 / 16);
+  assert (h.get_percentile (100) == 50000000);
+
+  // the largest values do not overflow the buckets
+  testing_output ("maximum value", 1);
+  h.record ((uint64_t)-1);
+  assert (h.get_max () == (uint64_t)-1);
+  assert (h.get_percentile (100) == (uint64_t)-1);
+}
+
+void
+test_Virtual_Clock ()
+{
+  testing_output ("gams::utility::Virtual_Clock");
+
+  testing_output ("starting time", 1);
+  Virtual_Clock clock (ACE_Time_Value (10));
+  assert (clock.now () == ACE_Time_Value (10));
+  assert (clock.now_seconds () == 10.0);
+
+  // sleeping jumps forward and never goes back in time
+  testing_output ("sleep_until", 1);
+  clock.sleep_until (ACE_Time_Value (12, 500000));
+  assert (clock.now () == ACE_Time_Value (12, 500000));
+  clock.sleep_until (ACE_Time_Value (11));
+  assert (clock.now () == ACE_Time_Value (12, 500000));
+
+  testing_output ("advance", 1);
+  clock.advance (ACE_Time_Value (0, 500000));
+  assert (clock.now_seconds () == 13.0);
+}
+
+void
+test_Trace_Buffer ()
+{
+  testing_output ("gams::utility::Trace_Buffer");
+
+  // the ring keeps only the newest records
+  testing_output ("ring", 1);
+  Trace_Buffer buffer (0);
+  for (int64_t i = 0; i < (int64_t)Trace_Buffer::CAPACITY + 10; ++i)
+    buffer.record ("ring", i, -i);
+  vector <gams::utility::Trace_Record> records;
+  buffer.get_records (records);
+  assert (records.size () == Trace_Buffer::CAPACITY);
+  assert (records[0].arg0 == 10);
+  assert (records.back ().arg1 == -(int64_t)Trace_Buffer::CAPACITY - 9);
+
+  // events survive a round trip through a trace file
+  testing_output ("dump and load", 1);
+  gams::utility::enable_tracing ();
+  GAMS_TRACE_EVENT (gams::utility::LOG_DETAILED_TRACE, "first", 1, 2);
+  GAMS_TRACE_EVENT (gams::utility::LOG_DETAILED_TRACE, "second", 3, 4);
+  GAMS_TRACE_EVENT (gams::utility::LOG_DETAILED_TRACE, "first", 5, 6);
+  gams::utility::enable_tracing (false);
+  GAMS_TRACE_EVENT (gams::utility::LOG_DETAILED_TRACE, "disabled", 0, 0);
+
+  assert (gams::utility::dump_trace ("test_utility.trace") == 0);
+  vector <Trace_Event> events;
+  assert (gams::utility::load_trace ("test_utility.trace", events) == 0);
+  assert (events.size () == 3);
+  assert (events[0].label == "first" && events[0].arg0 == 1);
+  assert (events[1].label == "second" && events[1].arg1 == 4);
+  assert (events[2].label == "first" && events[2].arg0 == 5);
+  assert (events[0].time == 0 && events[2].time >= events[1].time);
+  remove ("test_utility.trace");
 }
 
 int
@@ -309,7 +555,11 @@ main (int argc, char ** argv)
 {
   test_Position ();
   test_GPS_Position ();
+  test_Local_Frame ();
   test_Region ();
   test_Search_Area ();
+  test_Latency_Histogram ();
+  test_Virtual_Clock ();
+  test_Trace_Buffer ();
   return 0;
 }
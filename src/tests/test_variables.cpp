@@ -54,6 +54,9 @@
 
 #include "gams/utility/Position.h"
 #include "gams/utility/GPS_Position.h"
+#include "gams/utility/Region.h"
+#include "gams/maps/Grid.h"
+#include "gams/maps/Tile_Codec.h"
 #include "gams/variables/Sensor.h"
 
 #include "gams/variables/Accent.h"
@@ -62,7 +65,12 @@
 #include <iostream>
 #include <assert.h>
 #include <vector>
+#include <set>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
 
+using gams::maps::Grid;
 using gams::utility::GPS_Position;
 using gams::utility::Position;
 using gams::variables::Sensor;
@@ -76,6 +84,8 @@ namespace engine = Madara::Knowledge_Engine;
 namespace utility = Madara::Utility;
 namespace variables = gams::variables;
 
+typedef Madara::Knowledge_Record::Integer Integer;
+
 void
 testing_output (const string& str, const unsigned int& tabs = 0)
 {
@@ -102,6 +112,26 @@ test_accent ()
   knowledge.print ();
 }
 
+/**
+ * Copies a knowledge record between knowledge bases, as a transport would
+ **/
+void
+copy_record (engine::Knowledge_Base & from, engine::Knowledge_Base & to,
+  const std::string & key)
+{
+  const Madara::Knowledge_Record record = from.get (key);
+  if (record.type () == Madara::Knowledge_Record::DOUBLE_ARRAY)
+  {
+    to.set (key, record.to_doubles ());
+    return;
+  }
+
+  size_t size;
+  unsigned char * buffer = record.to_unmanaged_buffer (size);
+  to.set_file (key, buffer, size);
+  delete [] buffer;
+}
+
 void
 test_Sensor ()
 {
@@ -207,6 +237,187 @@ test_Sensor ()
   assert (s.get_value (p1) == value);
   assert (s.get_value (g2) == value);
 
+  /**
+   * discretize finds the cells of a region a column at a time instead of
+   * testing each cell, so it is compared with Region::contains on every
+   * cell center around random polygons. Polygons may be concave or
+   * self-intersecting, and half of them have their vertices on cell
+   * centers, where the two are most likely to disagree.
+   */
+  testing_output ("discretize", 1);
+  srand (13);
+  for (int polygon = 0; polygon < 300; ++polygon)
+  {
+    vector <GPS_Position> vertices (3 + rand () % 6);
+    for (size_t i = 0; i < vertices.size (); ++i)
+    {
+      if (polygon % 2 == 0)
+      {
+        vertices[i] = s.get_gps_from_index (
+          Position (rand () % 40 - 20, rand () % 40 - 20));
+      }
+      else
+      {
+        vertices[i] = GPS_Position (40 + (rand () % 1000 - 500) * 4e-7,
+          -80 + (rand () % 1000 - 500) * 4e-7);
+      }
+    }
+    const gams::utility::Region region (vertices);
+
+    Position low = s.get_index_from_gps (vertices[0]);
+    Position high = low;
+    for (size_t i = 1; i < vertices.size (); ++i)
+    {
+      const Position index = s.get_index_from_gps (vertices[i]);
+      low.x = std::min (low.x, index.x);
+      low.y = std::min (low.y, index.y);
+      high.x = std::max (high.x, index.x);
+      high.y = std::max (high.y, index.y);
+    }
+
+    std::set <Position> expected;
+    for (int x = (int)low.x - 2; x <= (int)high.x + 2; ++x)
+    {
+      for (int y = (int)low.y - 2; y <= (int)high.y + 2; ++y)
+      {
+        if (region.contains (s.get_gps_from_index (Position (x, y))))
+          expected.insert (Position (x, y));
+      }
+    }
+
+    assert (s.discretize (region) == expected);
+  }
+
+  /**
+   * Algorithms that touch every cell on every tick can keep those cells in a
+   * dense array. Values already in the knowledge base are copied in, writes
+   * that are broadcast go straight to the knowledge base, and local-only
+   * writes reach it on push_values. Cells outside the set are unaffected.
+   */
+  testing_output ("dense storage", 1);
+  set<Position> cells;
+  cells.insert (origin_idx);
+  cells.insert (Position (1, 2));
+  s.use_dense_storage (cells);
+  assert (s.has_dense_storage ());
+  assert (s.get_value (origin_idx) == 1);
+
+  const engine::Knowledge_Update_Settings local (true, false);
+  s.set_value (Position (1, 2), 5, local);
+  assert (s.get_value (Position (1, 2)) == 5);
+  assert (test.get ("sensor.coverage.covered.1x2").to_double () == 0);
+  s.push_values ();
+  assert (test.get ("sensor.coverage.covered.1x2").to_double () == 5);
+
+  s.set_value (origin_idx, 3);
+  assert (test.get ("sensor.coverage.covered.0x0").to_double () == 3);
+
+  test.set ("sensor.coverage.covered.1x2", 7.0);
+  s.pull_values ();
+  assert (s.get_value (Position (1, 2)) == 7);
+  assert (s.get_value (p1) == 2);
+
+  /**
+   * Conversions can also go through a snapshot of the origin and range,
+   * which avoids reading the knowledge base for every cell. The cached
+   * frame produces the same GPS positions, converts lists of cells at once
+   * and is exactly inverted by get_index_from_gps.
+   */
+  testing_output ("cached frame", 1);
+  vector<Position> indices;
+  indices.push_back (p1);
+  indices.push_back (Position (3, 7));
+  vector<GPS_Position> uncached;
+  for (size_t i = 0; i < indices.size (); ++i)
+    uncached.push_back (s.get_gps_from_index (indices[i]));
+
+  s.set_frame_caching ();
+  vector<GPS_Position> cached;
+  s.get_gps_from_index (indices, cached);
+  assert (cached.size () == indices.size ());
+  for (size_t i = 0; i < indices.size (); ++i)
+  {
+    assert (cached[i] == uncached[i]);
+    assert (s.get_index_from_gps (cached[i]) == indices[i]);
+  }
+  assert (!s.refresh_frame ());
+  s.set_range (2.0);
+  assert (s.get_discretization () == sqrt (8.0));
+  s.set_range (range);
+  s.set_frame_caching (false);
+
+  /**
+   * With change sync, cell writes are batched into one record per agent.
+   * Records hold every cell the other agents have not acknowledged, so a
+   * receiver that reads once after two sends, or misses a record, still
+   * gets every cell. Here the records are copied between two knowledge
+   * bases by hand, as a transport would deliver them.
+   */
+  testing_output ("change sync", 1);
+  engine::Knowledge_Base sender_kb, receiver_kb;
+  sender_kb.set (".id", Integer (0));
+  sender_kb.set ("swarm.size", Integer (2));
+  receiver_kb.set (".id", Integer (1));
+  receiver_kb.set ("swarm.size", Integer (2));
+  Sensor sender ("sync", &sender_kb, range, origin);
+  Sensor receiver ("sync", &receiver_kb, range, origin);
+  sender.set_change_sync (4);
+  receiver.set_change_sync (4);
+
+  const std::string sender_key ("sensor.sync.changes.0");
+  const std::string receiver_key ("sensor.sync.changes.1");
+  sender.set_value (Position (1, 1), 10);
+  assert (sender.send_changes () == 1);
+  sender.set_value (Position (-40, 3), 20);
+  assert (sender.send_changes () == 2);
+  copy_record (sender_kb, receiver_kb, sender_key);
+
+  vector<Position> changed;
+  assert (receiver.receive_changes (&changed) == 2);
+  assert (changed.size () == 2);
+  assert (receiver.get_value (Position (1, 1)) == 10);
+  assert (receiver.get_value (Position (-40, 3)) == 20);
+  assert (receiver.receive_changes () == 0);
+
+  // unacknowledged cells are resent, but applied only once
+  sender.set_value (Position (1, 1), 30);
+  assert (sender.send_changes () == 2);
+  copy_record (sender_kb, receiver_kb, sender_key);
+  assert (receiver.receive_changes () == 1);
+  assert (receiver.get_value (Position (1, 1)) == 30);
+
+  // once acknowledged, cells are no longer sent
+  assert (receiver.send_changes () == 0);
+  copy_record (receiver_kb, sender_kb, receiver_key);
+  assert (sender.receive_changes () == 0);
+  assert (sender.send_changes () == 0);
+
+  /**
+   * An agent that never answers does not hold cells in the record forever.
+   * At most 4096 cells of earlier sends wait for acknowledgement, and an
+   * agent that sent nothing for 16 sends with new writes is not waited for.
+   */
+  testing_output ("change sync without acknowledgement", 1);
+  engine::Knowledge_Base lonely_kb;
+  lonely_kb.set (".id", Integer (0));
+  lonely_kb.set ("swarm.size", Integer (2));
+  Sensor lonely ("lonely", &lonely_kb, range, origin);
+  lonely.set_change_sync (4);
+
+  for (int x = 0; x < 5000; ++x)
+    lonely.set_value (Position (x, 50), 1);
+  assert (lonely.send_changes () == 5000);
+  lonely.set_value (Position (0, 0), 1);
+  assert (lonely.send_changes () == 1);
+
+  for (size_t sends = 2; sends <= 16; ++sends)
+  {
+    lonely.set_value (Position ((double)sends, 0), 1);
+    assert (lonely.send_changes () == sends);
+  }
+  lonely.set_value (Position (17, 0), 1);
+  assert (lonely.send_changes () == 1);
+
   /**
    * While this class is coded for a group of homogeneous sensors, it could also
    * be used by a group of agents with different sensor ranges. 
@@ -221,10 +432,160 @@ test_Sensor ()
    */
 }
 
+void
+test_Grid ()
+{
+  testing_output ("gams::maps::Grid");
+
+  engine::Knowledge_Base knowledge;
+
+  /**
+   * Cells are stored in 16x16 tiles per layer that are only created when a
+   * cell in them is set. Unset cells read as the layer default.
+   */
+  testing_output ("layers", 1);
+  Grid grid;
+  grid.init_vars (knowledge, "map");
+  assert (grid.pheromone.get (-20, 5) == 0);
+  grid.pheromone.set (-20, 5, 2.5);
+  grid.last_seen.set (3, 4, 10);
+  assert (grid.pheromone.get (-20, 5) == 2.5);
+  assert (grid.pheromone.get (20, 5) == 0);
+  assert (grid.last_seen.get (3, 4) == 10);
+
+  /**
+   * Only tiles with changes are written on send_tiles, one record per
+   * layer, tile and agent. Records hold the cells the agent has written.
+   */
+  testing_output ("tile sync", 1);
+  knowledge.set (".id", Integer (0));
+  grid.pheromone.set (-18, 5, 3);
+  assert (grid.send_tiles () == 2);
+  assert (grid.send_tiles () == 0);
+  assert (knowledge.get ("grid.map.pheromone.-2x0.0").to_doubles ().size () ==
+    17 + 2 * 2);
+  assert (knowledge.get ("grid.map.last_seen.0x0.0").to_doubles ().size () ==
+    17 + 2);
+
+  /**
+   * Another agent applies the cells that the sender changed and keeps its
+   * own cells in the same tile, including unsent ones.
+   */
+  engine::Knowledge_Base peer_knowledge;
+  peer_knowledge.set (".id", Integer (1));
+  Grid other;
+  other.init_vars (peer_knowledge, "map");
+  other.last_seen.set (3, 4, 20);
+  other.pheromone.set (-20, 5, 9);
+  other.pheromone.set (-19, 5, 1);
+  copy_record (knowledge, peer_knowledge, "grid.map.pheromone.-2x0.0");
+  copy_record (knowledge, peer_knowledge, "grid.map.last_seen.0x0.0");
+  assert (other.receive_tiles () == 2);
+  assert (other.receive_tiles () == 0);
+  assert (other.pheromone.get (-20, 5) == 9);
+  assert (other.pheromone.get (-19, 5) == 1);
+  assert (other.pheromone.get (-18, 5) == 3);
+  assert (other.last_seen.get (3, 4) == 20);
+
+  /**
+   * Changes from several sends arrive together when a receiver misses the
+   * records in between, and cells that did not change are not reapplied.
+   */
+  other.pheromone.set (-18, 5, 6);
+  assert (other.send_tiles () == 2);
+  grid.pheromone.set (-21, 5, 4);
+  assert (grid.send_tiles () == 1);
+  grid.pheromone.set (-22, 5, 5);
+  assert (grid.send_tiles () == 1);
+  copy_record (knowledge, peer_knowledge, "grid.map.pheromone.-2x0.0");
+  assert (other.receive_tiles () == 1);
+  assert (other.pheromone.get (-21, 5) == 4);
+  assert (other.pheromone.get (-22, 5) == 5);
+  assert (other.pheromone.get (-18, 5) == 6);
+
+  copy_record (peer_knowledge, knowledge, "grid.map.pheromone.-2x0.1");
+  assert (grid.receive_tiles () == 1);
+  assert (grid.pheromone.get (-20, 5) == 9);
+  assert (grid.pheromone.get (-18, 5) == 6);
+
+  /**
+   * Lines cover every cell the segment between cell centers passes
+   * through, and corridors hold the cells within a radius of a segment.
+   */
+  testing_output ("line and corridor", 1);
+  vector<Position> cells;
+  Grid::get_line (Position (0, 0), Position (7, -3), cells);
+  assert (cells.front () == Position (0, 0));
+  assert (cells.back () == Position (7, -3));
+  // a line through a cell corner steps diagonally
+  for (size_t i = 1; i < cells.size (); ++i)
+    assert (std::abs (cells[i].x - cells[i - 1].x) <= 1 &&
+      std::abs (cells[i].y - cells[i - 1].y) <= 1 &&
+      !(cells[i] == cells[i - 1]));
+
+  // diagonal, vertical, horizontal and single cell segments, with cells
+  // exactly at integer radii left out
+  const Position starts[] = { Position (-2, 3), Position (0, 0),
+    Position (-6, 8), Position (-3, -4), Position (5, 5) };
+  const Position ends[] = { Position (6, -1), Position (0, 10),
+    Position (-6, 1), Position (7, -4), Position (5, 5) };
+  const double radii[] = { 0, 0.5, 1, 2, 2.5, 3 };
+  for (size_t s = 0; s < sizeof (starts) / sizeof (starts[0]); ++s)
+  {
+    for (size_t r = 0; r < sizeof (radii) / sizeof (radii[0]); ++r)
+    {
+      const Position & start = starts[s];
+      const Position & end = ends[s];
+      cells.clear ();
+      Grid::get_corridor (start, end, radii[r], cells);
+
+      size_t inside = 0;
+      for (int x = -20; x <= 20; ++x)
+        for (int y = -20; y <= 20; ++y)
+          if (start.distance_to_2d (end, Position (x, y)) < radii[r])
+            ++inside;
+      assert (cells.size () == inside);
+      for (size_t i = 0; i < cells.size (); ++i)
+        assert (start.distance_to_2d (end, cells[i]) < radii[r]);
+    }
+  }
+
+  cells.clear ();
+  Grid::get_corridor (Position (0, 0), Position (0, 10), 2, cells);
+  assert (cells.size () == 39);
+  cells.clear ();
+  Grid::get_corridor (Position (-6, 8), Position (-6, 1), 0, cells);
+  assert (cells.empty ());
+
+  /**
+   * The changed cells of a layer can be packed into one buffer. Equal
+   * neighboring values take a byte each, on top of a bitmap per tile.
+   */
+  testing_output ("change encoding", 1);
+  gams::maps::Grid_Layer<double> changes;
+  for (int x = -8; x < 8; ++x)
+    changes.set (x, 3, 42);
+  changes.set (100, -100, 0.25);
+
+  vector<unsigned char> buffer;
+  assert (gams::maps::encode_changes (changes, 4, buffer) == 17);
+  assert (buffer.size () < 17 + 3 * (32 + 3) + 8);
+
+  gams::maps::Grid_Layer<double> decoded;
+  assert (gams::maps::decode_changes (
+    &buffer[0], buffer.size (), 4, decoded) == 17);
+  assert (decoded.get (-8, 3) == 42 && decoded.get (7, 3) == 42);
+  assert (decoded.get (100, -100) == 0.25);
+  assert (decoded.is_dirty (0, 3) && !decoded.is_dirty (0, 4));
+  assert (gams::maps::decode_changes (
+    &buffer[0], buffer.size () - 1, 4, decoded) == -1);
+}
+
 int
 main (int argc, char ** argv)
 {
   test_accent ();
   test_Sensor ();
+  test_Grid ();
   return 0;
 }
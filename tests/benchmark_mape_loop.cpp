@@ -0,0 +1,167 @@
+/**
+ * Copyright (c) 2014 Carnegie Mellon University. All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following acknowledgments and disclaimers.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. The names "Carnegie Mellon University," "SEI" and/or "Software
+ *    Engineering Institute" shall not be used to endorse or promote products
+ *    derived from this software without prior written permission. For written
+ *    permission, please contact permission@sei.cmu.edu.
+ * 
+ * 4. Products derived from this software may not be called "SEI" nor may "SEI"
+ *    appear in their names without prior written permission of
+ *    permission@sei.cmu.edu.
+ * 
+ * 5. Redistributions of any form whatsoever must retain the following
+ *    acknowledgment:
+ * 
+ *      This material is based upon work funded and supported by the Department
+ *      of Defense under Contract No. FA8721-05-C-0003 with Carnegie Mellon
+ *      University for the operation of the Software Engineering Institute, a
+ *      federally funded research and development center. Any opinions,
+ *      findings and conclusions or recommendations expressed in this material
+ *      are those of the author(s) and do not necessarily reflect the views of
+ *      the United States Department of Defense.
+ * 
+ *      NO WARRANTY. THIS CARNEGIE MELLON UNIVERSITY AND SOFTWARE ENGINEERING
+ *      INSTITUTE MATERIAL IS FURNISHED ON AN "AS-IS" BASIS. CARNEGIE MELLON
+ *      UNIVERSITY MAKES NO WARRANTIES OF ANY KIND, EITHER EXPRESSED OR
+ *      IMPLIED, AS TO ANY MATTER INCLUDING, BUT NOT LIMITED TO, WARRANTY OF
+ *      FITNESS FOR PURPOSE OR MERCHANTABILITY, EXCLUSIVITY, OR RESULTS
+ *      OBTAINED FROM USE OF THE MATERIAL. CARNEGIE MELLON UNIVERSITY DOES
+ *      NOT MAKE ANY WARRANTY OF ANY KIND WITH RESPECT TO FREEDOM FROM PATENT,
+ *      TRADEMARK, OR COPYRIGHT INFRINGEMENT.
+ * 
+ *      This material has been approved for public release and unlimited
+ *      distribution.
+ **/
+
+/**
+ * @file benchmark_mape_loop.cpp
+ * @author James Edmondson <jedmondson@gmail.com>
+ *
+ * This file contains a benchmark that compares iterations per second of
+ * the KaRL and native phase paths of the GAMS MAPE loop.
+ **/
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "madara/knowledge_engine/Knowledge_Base.h"
+#include "gams/controllers/Mape_Loop.h"
+#include "ace/High_Res_Timer.h"
+
+// create shortcuts to MADARA classes and namespaces
+namespace engine = Madara::Knowledge_Engine;
+namespace controllers = gams::controllers;
+typedef Madara::Knowledge_Record   Record;
+typedef Record::Integer Integer;
+
+// number of iterations to time for each path
+Integer iterations (100000);
+
+/**
+ * KaRL phase function that does as little as possible
+ * @param  args   arguments to the function
+ * @param  vars   interface to the knowledge base
+ **/
+Record karl_phase (engine::Function_Arguments & args, engine::Variables & vars)
+{
+  return Integer (0);
+}
+
+/**
+ * Native phase function that does as little as possible
+ * @param  knowledge   the knowledge base of the loop
+ **/
+int native_phase (engine::Knowledge_Base & knowledge)
+{
+  return 0;
+}
+
+/**
+ * Times iterations of a loop
+ * @param  loop   the loop to iterate
+ * @return iterations per second
+ **/
+double time_iterations (controllers::Mape_Loop & loop)
+{
+  ACE_High_Res_Timer timer;
+  ACE_hrtime_t elapsed (0);
+
+  timer.start ();
+  for (Integer i = 0; i < iterations; ++i)
+    loop.run_once ();
+  timer.stop ();
+  timer.elapsed_time (elapsed);
+
+  return elapsed > 0 ? iterations * 1000000000.0 / elapsed : 0.0;
+}
+
+// handle command line arguments
+void handle_arguments (int argc, char ** argv)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg1 (argv[i]);
+
+    if ((arg1 == "-n" || arg1 == "--iterations") && i + 1 < argc)
+    {
+      std::stringstream buffer (argv[i + 1]);
+      buffer >> iterations;
+
+      ++i;
+    }
+    else
+    {
+      std::cerr << "\nProgram summary for " << argv[0] << ":\n\n" \
+        "     Compares the KaRL and native MAPE loop paths\n" \
+        " [-n |--iterations num]        iterations to time per path\n" \
+        "                               (def:100000)\n\n";
+      exit (0);
+    }
+  }
+}
+
+// perform main logic of program
+int main (int argc, char ** argv)
+{
+  handle_arguments (argc, argv);
+
+  // create knowledge base and a control loop
+  engine::Knowledge_Base knowledge;
+  controllers::Mape_Loop loop (knowledge);
+  loop.init_vars (knowledge, 0, 1);
+
+  loop.define_monitor (karl_phase);
+  loop.define_analyze (karl_phase);
+  loop.define_plan (karl_phase);
+  loop.define_execute (karl_phase);
+
+  double karl_rate = time_iterations (loop);
+
+  loop.define_monitor (native_phase);
+  loop.define_analyze (native_phase);
+  loop.define_plan (native_phase);
+  loop.define_execute (native_phase);
+
+  double native_rate = time_iterations (loop);
+
+  std::cerr << "KaRL:   " << karl_rate << " iterations/s\n";
+  std::cerr << "Native: " << native_rate << " iterations/s\n";
+
+  if (karl_rate > 0)
+    std::cerr << "Speedup: " << native_rate / karl_rate << "x\n";
+
+  return 0;
+}
@@ -251,5 +251,16 @@ int main (int argc, char ** argv)
     test_period (knowledge, loop, period, duration);
   }
 
+  std::cerr << "*****************************************************\n";
+  std::cerr <<
+    "* Running MADARA counters with the unlocked I/O execution model\n";
+  std::cerr << "*****************************************************\n";
+
+  loop.set_execution_model (controllers::EXECUTION_UNLOCKED_IO);
+
+  // run blasting experiments
+  test_hz (knowledge, loop);
+  test_period (knowledge, loop);
+
   return 0;
 }